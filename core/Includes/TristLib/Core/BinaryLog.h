@@ -0,0 +1,163 @@
+/**
+ * @file
+ *
+ * @brief Binary (deferred formatting) logging
+ *
+ * Log statements made with the `TLOGB_*` macros are not formatted when they're made: instead, a
+ * record containing the call site's identifier, the timestamp and the raw argument values is
+ * encoded as CBOR and written to the binary log destinations. The format string and call site
+ * information is written only once per site; the `tristlib-logdecode` tool renders the log file
+ * as text later.
+ *
+ * Format strings use `{}` as the placeholder for each argument, in order. Statements less severe
+ * than `TRISTLIB_LOG_MAX_SEVERITY` are removed at compile time.
+ */
+#ifndef TRISTLIB_CORE_BINARYLOG_H
+#define TRISTLIB_CORE_BINARYLOG_H
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <plog/Log.h>
+
+#include "TristLib/Core/CborWriter.h"
+#include "TristLib/Core/LogModules.h"
+
+namespace TristLib::Core {
+/**
+ * @brief Static information about a binary log call site
+ *
+ * One of these is created for every `TLOGB_*` statement; it's assigned an identifier the first
+ * time the statement logs a record.
+ */
+struct BinaryLogSite {
+    /// Format string
+    const char *format;
+    /// Source file name
+    const char *file;
+    /// Function name
+    const char *func;
+    /// Source line number
+    uint32_t line;
+    /// Severity of records logged at this site
+    plog::Severity severity;
+
+    /// Identifier of the site (zero until registered)
+    std::atomic<uint32_t> id{0};
+};
+
+namespace BinaryLog {
+/**
+ * @brief Record types in a binary log file
+ *
+ * Each record in the file is a CBOR array, whose first element is one of these values. The file
+ * is a CBOR sequence (RFC 8742) of these records.
+ */
+enum RecordType: uint8_t {
+    /// File header: `[type, magic, version]`
+    Header                              = 0,
+    /// Call site definition: `[type, id, severity, file, line, func, format]`
+    Site                                = 1,
+    /// Deferred record: `[type, site id, timestamp (ns), thread id, [args...]]`
+    Event                               = 2,
+    /// Preformatted record: `[type, timestamp (ns), severity, thread id, func, line, message]`
+    Text                                = 3,
+};
+
+/// Magic value stored in the file header
+constexpr static const std::string_view kMagic{"TristLib binary log"};
+/// Current version of the file format
+constexpr static const uint64_t kVersion{1};
+
+bool IsEnabled(const plog::Severity severity) noexcept;
+void Submit(BinaryLogSite &site, std::span<const std::byte> args);
+
+namespace detail {
+/// CBOR writer used to encode records
+using Writer = CborWriter<CborVectorSink>;
+
+/// Buffer in which the arguments of a record are encoded
+inline thread_local std::vector<std::byte> gArgBuffer;
+
+/**
+ * @brief Encode a single log argument
+ *
+ * Integers, floating point values, booleans and strings are encoded as-is; anything else that
+ * can be written to an output stream is formatted immediately, and encoded as a string.
+ */
+template<class T>
+inline void EncodeArg(Writer &writer, const T &value) {
+    using Type = std::remove_cvref_t<T>;
+
+    if constexpr(std::is_enum_v<Type>) {
+        EncodeArg(writer, static_cast<std::underlying_type_t<Type>>(value));
+    } else if constexpr(std::is_same_v<Type, char>) {
+        writer.writeString(std::string_view(&value, 1));
+    } else if constexpr(std::is_same_v<Type, bool> || std::integral<Type>) {
+        writer.write(value);
+    } else if constexpr(std::floating_point<Type>) {
+        writer.writeDouble(value);
+    } else if constexpr(std::is_convertible_v<const Type &, std::string_view>) {
+        writer.writeString(value);
+    } else {
+        std::ostringstream str;
+        str << value;
+        writer.writeString(str.str());
+    }
+}
+}
+
+/**
+ * @brief Encode the arguments of a record, and write it to all binary log destinations
+ *
+ * @param site Call site of the record
+ * @param args Arguments to the format string
+ */
+template<class... Args>
+inline void Write(BinaryLogSite &site, const Args &...args) {
+    auto &buf = detail::gArgBuffer;
+    buf.clear();
+
+    CborVectorSink sink(buf);
+    detail::Writer writer(sink);
+
+    writer.beginArray(sizeof...(Args));
+    (detail::EncodeArg(writer, args), ...);
+
+    Submit(site, buf);
+}
+}
+}
+
+/**
+ * @brief Log a record with deferred formatting
+ *
+ * @param severity plog severity of the record
+ * @param format Format string (a string literal) with `{}` placeholders
+ */
+#define TLOGB_(severity, format, ...) do { \
+    if constexpr(TristLib::Core::IsLogSeverityCompiled(severity)) { \
+        static TristLib::Core::BinaryLogSite _tlogbSite{format, __FILE__, PLOG_GET_FUNC(), \
+            __LINE__, severity}; \
+        if(TristLib::Core::BinaryLog::IsEnabled(severity)) { \
+            TristLib::Core::BinaryLog::Write(_tlogbSite __VA_OPT__(,) __VA_ARGS__); \
+        } \
+    } \
+} while(0)
+
+#define TLOGB_VERBOSE(format, ...) TLOGB_(plog::verbose, format __VA_OPT__(,) __VA_ARGS__)
+#define TLOGB_DEBUG(format, ...) TLOGB_(plog::debug, format __VA_OPT__(,) __VA_ARGS__)
+#define TLOGB_INFO(format, ...) TLOGB_(plog::info, format __VA_OPT__(,) __VA_ARGS__)
+#define TLOGB_WARNING(format, ...) TLOGB_(plog::warning, format __VA_OPT__(,) __VA_ARGS__)
+#define TLOGB_ERROR(format, ...) TLOGB_(plog::error, format __VA_OPT__(,) __VA_ARGS__)
+#define TLOGB_FATAL(format, ...) TLOGB_(plog::fatal, format __VA_OPT__(,) __VA_ARGS__)
+
+#endif
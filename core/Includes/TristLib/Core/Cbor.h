@@ -13,6 +13,8 @@
 #include <string>
 #include <string_view>
 
+#include "TristLib/Core/Utf8.h"
+
 namespace TristLib::Core {
 /**
  * @brief Encode a timestamp
@@ -87,17 +89,38 @@ constexpr inline static double CborReadFloat(const cbor_item_t *item) {
 }
 
 /**
- * @brief Read a CBOR string
+ * @brief Read a CBOR string without copying it
  *
- * @param item CBOR item to read
+ * The string is validated to be well-formed UTF-8.
+ *
+ * @param item CBOR item to read; it must be a definite length string
+ *
+ * @return View of the string's data, which is valid for as long as the item is
  */
-inline static std::string CborReadString(const cbor_item_t *item) {
+inline static std::string_view CborReadStringView(const cbor_item_t *item) {
     if(!cbor_isa_string(item)) {
         throw std::runtime_error("invalid type (expected string)");
+    } else if(!cbor_string_is_definite(item)) {
+        throw std::runtime_error("invalid string (expected definite length)");
+    }
+
+    const std::string_view str{reinterpret_cast<const char *>(cbor_string_handle(item)),
+        cbor_string_length(item)};
+    if(!IsValidUtf8(str)) {
+        throw std::runtime_error("invalid string (malformed UTF-8)");
     }
+    return str;
+}
 
-    return std::string(reinterpret_cast<char *>(cbor_string_handle(item)),
-            cbor_string_length(item));
+/**
+ * @brief Read a CBOR string
+ *
+ * The string is validated to be well-formed UTF-8.
+ *
+ * @param item CBOR item to read
+ */
+inline static std::string CborReadString(const cbor_item_t *item) {
+    return std::string(CborReadStringView(item));
 }
 
 /**
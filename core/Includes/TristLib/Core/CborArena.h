@@ -0,0 +1,370 @@
+/**
+ * @file
+ *
+ * @brief Arena allocator for libcbor
+ *
+ * libcbor allocates every decoded item (and their storage) separately, so decoding a large
+ * message results in many small heap allocations that have to be individually freed again. An
+ * arena instead hands out memory by bumping a pointer through large blocks, and releases all of
+ * it at once, by rewinding the pointer.
+ *
+ * Allocations are redirected to an arena for the lifetime of a `CborArenaScope` on the current
+ * thread; other threads (and code outside of scopes) keep using the regular heap.
+ *
+ * @remark This requires libcbor to support custom allocators: always the case since 0.10, but
+ *         earlier versions must be built with `CBOR_CUSTOM_ALLOC`.
+ */
+#ifndef TRISTLIB_CORE_CBORARENA_H
+#define TRISTLIB_CORE_CBORARENA_H
+
+#include <cbor.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if CBOR_MAJOR_VERSION == 0 && CBOR_MINOR_VERSION < 10 && !defined(CBOR_CUSTOM_ALLOC)
+#error "libcbor must be built with custom allocator support (CBOR_CUSTOM_ALLOC)"
+#endif
+
+namespace TristLib::Core {
+/**
+ * @brief Bump allocator for CBOR items
+ *
+ * Memory is carved out of a chain of blocks; individual frees are ignored, and all memory is
+ * reclaimed at once by rewinding the arena to an earlier mark (or resetting it entirely.) Blocks
+ * are kept around when rewinding, so an arena that's reused for similarly sized messages stops
+ * touching the heap altogether.
+ *
+ * An arena must only be used by one thread at a time.
+ */
+class CborArena {
+    public:
+        /// Default size of blocks, in bytes
+        constexpr static const size_t kDefaultBlockSize{64 * 1024};
+        /// Alignment of all allocations
+        constexpr static const size_t kAlignment{alignof(std::max_align_t)};
+
+    private:
+        /**
+         * @brief Block of memory allocated from
+         *
+         * The block's memory directly follows this header.
+         */
+        struct alignas(kAlignment) Block {
+            /// Next block in the chain
+            Block *next;
+            /// Size of the block's memory
+            size_t size;
+
+            inline std::byte *getData() {
+                return reinterpret_cast<std::byte *>(this + 1);
+            }
+        };
+
+        /**
+         * @brief Header preceding each allocation
+         *
+         * It records the allocation's size, so that it can be reallocated.
+         */
+        struct alignas(kAlignment) Header {
+            size_t size;
+        };
+
+    public:
+        /**
+         * @brief Position in the arena, to later rewind to
+         */
+        struct Mark {
+            Block *block;
+            size_t offset;
+        };
+
+    public:
+        CborArena(const size_t blockSize = kDefaultBlockSize) : blockSize(blockSize) {}
+
+        ~CborArena() {
+            while(this->first) {
+                auto next = this->first->next;
+                std::free(this->first);
+                this->first = next;
+            }
+        }
+
+        CborArena(const CborArena &) = delete;
+        CborArena &operator=(const CborArena &) = delete;
+
+        /**
+         * @brief Allocate memory from the arena
+         *
+         * @return Pointer to memory, or `nullptr` if out of memory (as libcbor expects)
+         */
+        void *allocate(const size_t size) {
+            const size_t needed = sizeof(Header) + AlignUp(size);
+
+            if(!this->current || this->current->size - this->offset < needed) {
+                if(!this->advance(needed)) {
+                    return nullptr;
+                }
+            }
+
+            auto header = reinterpret_cast<Header *>(this->current->getData() + this->offset);
+            header->size = size;
+            this->offset += needed;
+            this->last = header;
+
+            return header + 1;
+        }
+
+        /**
+         * @brief Resize an allocation made from the arena
+         *
+         * The most recent allocation is resized in place if it fits in its block; others are
+         * copied to a new allocation.
+         */
+        void *reallocate(void *ptr, const size_t size) {
+            auto header = reinterpret_cast<Header *>(ptr) - 1;
+
+            if(header == this->last) {
+                const auto start = reinterpret_cast<std::byte *>(header) -
+                    this->current->getData();
+                const size_t needed = sizeof(Header) + AlignUp(size);
+
+                if(this->current->size - start >= needed) {
+                    header->size = size;
+                    this->offset = start + needed;
+                    return ptr;
+                }
+            } else if(size <= header->size) {
+                header->size = size;
+                return ptr;
+            }
+
+            auto newPtr = this->allocate(size);
+            if(newPtr) {
+                std::memcpy(newPtr, ptr, std::min(size, header->size));
+            }
+            return newPtr;
+        }
+
+        /**
+         * @brief Determine whether memory was allocated from this arena
+         */
+        bool owns(const void *ptr) const {
+            // allocations always follow their header, so may end up right at the end of a block
+            const auto addr = reinterpret_cast<uintptr_t>(ptr);
+
+            for(auto block = this->first; block; block = block->next) {
+                const auto start = reinterpret_cast<uintptr_t>(block + 1);
+                if(addr > start && addr <= start + block->size) {
+                    return true;
+                }
+                if(block == this->current) {
+                    break;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Get the current position in the arena
+         */
+        constexpr Mark getMark() const {
+            return {this->current, this->offset};
+        }
+
+        /**
+         * @brief Release all memory allocated since the given mark was taken
+         */
+        constexpr void rewind(const Mark &mark) {
+            this->current = mark.block;
+            this->offset = mark.offset;
+            this->last = nullptr;
+        }
+
+        /**
+         * @brief Release all memory allocated from the arena
+         *
+         * The arena's blocks are kept, to be reused for subsequent allocations.
+         */
+        constexpr void reset() {
+            this->rewind({nullptr, 0});
+        }
+
+        /**
+         * @brief Get the total size of the arena's blocks
+         */
+        size_t getCapacity() const {
+            size_t total{0};
+            for(auto block = this->first; block; block = block->next) {
+                total += block->size;
+            }
+            return total;
+        }
+
+    private:
+        /**
+         * @brief Move to a block with at least the given amount of free space
+         *
+         * Unused blocks (following the current one) are reused if one is large enough; it's moved
+         * to directly follow the current block. Otherwise, a new block is allocated and inserted
+         * there instead.
+         */
+        bool advance(const size_t needed) {
+            auto &link = this->current ? this->current->next : this->first;
+
+            // find a large enough unused block
+            Block **prev = &link;
+            while(*prev && (*prev)->size < needed) {
+                prev = &(*prev)->next;
+            }
+
+            Block *block = *prev;
+            if(block) {
+                *prev = block->next;
+            } else {
+                const auto size = std::max(this->blockSize, needed);
+                block = static_cast<Block *>(std::malloc(sizeof(Block) + size));
+                if(!block) {
+                    return false;
+                }
+                block->size = size;
+            }
+
+            block->next = link;
+            link = block;
+
+            this->current = block;
+            this->offset = 0;
+            return true;
+        }
+
+        static constexpr size_t AlignUp(const size_t size) {
+            return (size + kAlignment - 1) & ~(kAlignment - 1);
+        }
+
+    private:
+        /// Size of newly allocated blocks
+        size_t blockSize;
+
+        /// First block in the chain
+        Block *first{nullptr};
+        /// Block currently allocated from
+        Block *current{nullptr};
+        /// Offset of the next allocation in the current block
+        size_t offset{0};
+        /// Most recent allocation (which may be resized in place)
+        Header *last{nullptr};
+};
+
+class CborArenaScope;
+
+namespace detail {
+/// Innermost arena scope on this thread; libcbor allocations are made from its arena
+inline thread_local CborArenaScope *gCurrentCborArenaScope{nullptr};
+
+inline void *CborArenaMalloc(size_t size);
+inline void *CborArenaRealloc(void *ptr, size_t size);
+inline void CborArenaFree(void *ptr);
+}
+
+/**
+ * @brief Redirects libcbor allocations on the current thread to an arena
+ *
+ * On exit, all memory allocated from the arena during the scope is released, so any CBOR items
+ * created inside it must not be used afterwards; they don't need to be released with
+ * `cbor_decref()` either, but doing so inside the scope is harmless. Scopes may be nested, even
+ * on the same arena; items from the arenas of all enclosing scopes may be freed or resized.
+ *
+ * @remark The allocator hooks are installed process wide the first time a scope is created;
+ *         this replaces any allocators previously set with `cbor_set_allocs()`.
+ */
+class CborArenaScope {
+    public:
+        CborArenaScope(CborArena &arena) : arena(arena), mark(arena.getMark()),
+            previous(detail::gCurrentCborArenaScope) {
+            static const bool installed = []() {
+                cbor_set_allocs(detail::CborArenaMalloc, detail::CborArenaRealloc,
+                        detail::CborArenaFree);
+                return true;
+            }();
+            (void) installed;
+
+            detail::gCurrentCborArenaScope = this;
+        }
+
+        ~CborArenaScope() {
+            detail::gCurrentCborArenaScope = this->previous;
+            this->arena.rewind(this->mark);
+        }
+
+        CborArenaScope(const CborArenaScope &) = delete;
+        CborArenaScope &operator=(const CborArenaScope &) = delete;
+
+        /// Get the arena allocations are redirected to
+        constexpr CborArena &getArena() const {
+            return this->arena;
+        }
+
+        /**
+         * @brief Find the arena of the calling thread's active scopes that memory came from
+         *
+         * @return Arena that owns the memory, or `nullptr` if it was allocated from the heap
+         */
+        static CborArena *FindOwner(const void *ptr) {
+            for(auto scope = detail::gCurrentCborArenaScope; scope; scope = scope->previous) {
+                if(scope->arena.owns(ptr)) {
+                    return &scope->arena;
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        /// Arena allocations are redirected to
+        CborArena &arena;
+        /// Position of the arena when the scope was entered
+        CborArena::Mark mark;
+        /// Enclosing scope, if any
+        CborArenaScope *previous;
+};
+
+namespace detail {
+inline void *CborArenaMalloc(size_t size) {
+    auto scope = gCurrentCborArenaScope;
+    return scope ? scope->getArena().allocate(size) : std::malloc(size);
+}
+
+inline void *CborArenaRealloc(void *ptr, size_t size) {
+    if(!ptr) {
+        return CborArenaMalloc(size);
+    } else if(auto arena = CborArenaScope::FindOwner(ptr)) {
+        return arena->reallocate(ptr, size);
+    }
+    return std::realloc(ptr, size);
+}
+
+inline void CborArenaFree(void *ptr) {
+    if(ptr && CborArenaScope::FindOwner(ptr)) {
+        return;
+    }
+    std::free(ptr);
+}
+}
+
+/**
+ * @brief Get the calling thread's CBOR arena
+ *
+ * This is a convenient arena to use with `CborArenaScope` for decoding messages; it's created on
+ * first use, and its blocks are retained for the lifetime of the thread.
+ */
+inline CborArena &GetThreadCborArena() {
+    static thread_local CborArena arena;
+    return arena;
+}
+}
+
+#endif
@@ -0,0 +1,520 @@
+/**
+ * @file
+ *
+ * @brief Compile-time CBOR struct bindings
+ *
+ * Describes how a struct maps to a CBOR map, once, so that encoding and decoding code for it is
+ * generated. A binding is declared by specializing `CborBinding` for the struct, listing its
+ * fields and their keys:
+ *
+ * ```
+ * template<>
+ * struct TristLib::Core::CborBinding<Message> {
+ *     constexpr static const auto kFields = std::tuple{
+ *         CborField{"id", &Message::id},
+ *         CborField{"name", &Message::name},
+ *         CborField{7, &Message::flags},
+ *     };
+ * };
+ * ```
+ *
+ * Keys may be text strings or unsigned integers. Structs are encoded (with a `CborWriter`) as a
+ * map whose keys are in canonical order (RFC 8949, section 4.2.1) and decoded from a
+ * `CborReader` without building an intermediate tree; keys are looked up in a table sorted at
+ * compile time, so decoding a map is O(n log n) rather than O(n²) in the number of fields.
+ *
+ * Field types may be booleans, integers, enums, floating point values, strings, byte vectors,
+ * time points (encoded as timestamps), `std::optional` (omitted when empty), `std::vector` and
+ * other bound structs.
+ */
+#ifndef TRISTLIB_CORE_CBORBINDING_H
+#define TRISTLIB_CORE_CBORBINDING_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "TristLib/Core/CborReader.h"
+#include "TristLib/Core/CborWriter.h"
+#include "TristLib/Core/Utf8.h"
+
+namespace TristLib::Core {
+/**
+ * @brief Key of a field in a CBOR map
+ *
+ * Either a text string or an unsigned integer.
+ */
+struct CborKey {
+    /// Set if the key is a string
+    bool isString;
+    /// Integer key value
+    uint64_t number{0};
+    /// String key value
+    std::string_view string;
+
+    constexpr CborKey() : isString(false) {}
+    constexpr CborKey(const char *key) : isString(true), string(key) {}
+    constexpr CborKey(const std::string_view key) : isString(true), string(key) {}
+
+    template<std::integral T>
+    constexpr CborKey(const T key) : isString(false), number(static_cast<uint64_t>(key)) {
+        if(key < 0) {
+            throw std::invalid_argument("CBOR keys must be unsigned");
+        }
+    }
+
+    /**
+     * @brief Compare keys in canonical order
+     *
+     * This is the bytewise order of the keys' encoded forms: integers sort before strings,
+     * integers by value, and strings by length, then contents.
+     */
+    constexpr bool operator<(const CborKey &other) const {
+        if(this->isString != other.isString) {
+            return !this->isString;
+        } else if(!this->isString) {
+            return this->number < other.number;
+        } else if(this->string.size() != other.string.size()) {
+            return this->string.size() < other.string.size();
+        }
+        return this->string < other.string;
+    }
+
+    constexpr bool operator==(const CborKey &other) const {
+        return this->isString == other.isString && this->number == other.number &&
+            this->string == other.string;
+    }
+};
+
+/**
+ * @brief Binding of a struct field to a CBOR map key
+ */
+template<class T, class M>
+struct CborField {
+    /// Struct the field belongs to
+    using Struct = T;
+    /// Type of the field
+    using Type = M;
+
+    /// Map key
+    CborKey key;
+    /// Member holding the field's value
+    M T::*member;
+
+    constexpr CborField(const CborKey key, M T::*member) : key(key), member(member) {}
+};
+
+/**
+ * @brief CBOR binding for a struct
+ *
+ * Specialize this for each struct to be encoded, providing a `kFields` tuple of `CborField`s.
+ */
+template<class T>
+struct CborBinding;
+
+/**
+ * @brief Types that have a CBOR binding
+ */
+template<class T>
+concept CborBound = requires {
+    std::tuple_size<std::remove_cvref_t<decltype(CborBinding<T>::kFields)>>::value;
+};
+
+namespace detail {
+template<class T>
+struct IsOptional: std::false_type {};
+template<class T>
+struct IsOptional<std::optional<T>>: std::true_type {};
+
+template<class T>
+struct IsVector: std::false_type {};
+template<class T, class A>
+struct IsVector<std::vector<T, A>>: std::true_type {};
+
+/**
+ * @brief Compile-time information about a binding
+ *
+ * Contains the fields' keys sorted in canonical order, along with the index of the field each
+ * belongs to.
+ */
+template<CborBound T>
+struct BindingInfo {
+    constexpr static const auto &kFields = CborBinding<T>::kFields;
+    constexpr static const size_t kNumFields =
+        std::tuple_size_v<std::remove_cvref_t<decltype(kFields)>>;
+
+    /// Key of a field, and its index in the fields tuple
+    struct Entry {
+        CborKey key;
+        size_t index;
+    };
+
+    /// Entries, sorted by key
+    constexpr static const auto kSorted = []() {
+        std::array<Entry, kNumFields> entries{};
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            ((entries[I] = Entry{std::get<I>(kFields).key, I}), ...);
+        }(std::make_index_sequence<kNumFields>{});
+
+        std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+            return a.key < b.key;
+        });
+
+        for(size_t i = 1; i < entries.size(); i++) {
+            if(entries[i - 1].key == entries[i].key) {
+                throw std::logic_error("duplicate key in CBOR binding");
+            }
+        }
+
+        return entries;
+    }();
+
+    /// Length of the longest string key
+    constexpr static const size_t kMaxKeyLength = []() {
+        size_t length{0};
+        for(const auto &entry : kSorted) {
+            length = std::max(length, entry.key.string.size());
+        }
+        return length;
+    }();
+
+    /**
+     * @brief Find a field by key
+     *
+     * @return Index of the field, or `kNumFields` if there is no field with this key
+     */
+    static size_t Find(const CborKey &key) {
+        const auto it = std::lower_bound(kSorted.begin(), kSorted.end(), key,
+                [](const auto &entry, const auto &key) {
+            return entry.key < key;
+        });
+        return (it != kSorted.end() && it->key == key) ? it->index : kNumFields;
+    }
+};
+
+/**
+ * @brief Read the next item, which must exist
+ */
+inline CborReader::Item ReadNext(CborReader &reader) {
+    auto item = reader.next();
+    if(item.type == CborReader::Type::NeedMore) {
+        throw std::runtime_error("truncated CBOR data");
+    }
+    return item;
+}
+
+/**
+ * @brief Read a complete (possibly chunked) string, given its first item
+ *
+ * The string's contents are appended to the output container.
+ */
+template<class Container>
+void ReadString(CborReader &reader, CborReader::Item item, Container &out) {
+    using Value = typename Container::value_type;
+
+    // indefinite length strings consist of definite length chunks
+    if(item.value == CborReader::kIndefinite) {
+        while((item = ReadNext(reader)).type != CborReader::Type::End) {
+            ReadString(reader, item, out);
+        }
+        return;
+    }
+
+    while(true) {
+        const auto begin = reinterpret_cast<const Value *>(item.data.data());
+        out.insert(out.end(), begin, begin + item.data.size());
+
+        if(!item.partial) {
+            break;
+        }
+        item = ReadNext(reader);
+    }
+}
+
+template<class T>
+void DecodeValue(CborReader &reader, const CborReader::Item &item, T &out);
+template<CborBound T>
+void DecodeMap(CborReader &reader, const CborReader::Item &item, T &out);
+
+/**
+ * @brief Decode a struct's field, given its index
+ */
+template<CborBound T, size_t I>
+void DecodeField(CborReader &reader, const CborReader::Item &item, T &out) {
+    DecodeValue(reader, item, out.*(std::get<I>(CborBinding<T>::kFields).member));
+}
+
+/**
+ * @brief Decode a map into a bound struct
+ *
+ * Fields not present in the map are left untouched; keys without a corresponding field are
+ * ignored.
+ */
+template<CborBound T>
+void DecodeMap(CborReader &reader, const CborReader::Item &item, T &out) {
+    using Info = BindingInfo<T>;
+    using Decoder = void (*)(CborReader &, const CborReader::Item &, T &);
+
+    constexpr static const auto kDecoders = []<size_t... I>(std::index_sequence<I...>) {
+        return std::array<Decoder, Info::kNumFields>{&DecodeField<T, I>...};
+    }(std::make_index_sequence<Info::kNumFields>{});
+
+    if(item.type != CborReader::Type::MapStart) {
+        throw std::runtime_error("invalid type (expected map)");
+    }
+
+    while(true) {
+        auto keyItem = ReadNext(reader);
+        size_t index{Info::kNumFields};
+
+        // identify the key; ones that can't possibly match are skipped
+        if(keyItem.type == CborReader::Type::End) {
+            break;
+        } else if(keyItem.type == CborReader::Type::Unsigned) {
+            index = Info::Find(keyItem.value);
+        } else if(keyItem.type == CborReader::Type::TextString &&
+                keyItem.value <= Info::kMaxKeyLength) {
+            char buffer[Info::kMaxKeyLength + 1];
+            size_t length{0};
+
+            while(true) {
+                std::memcpy(buffer + length, keyItem.data.data(), keyItem.data.size());
+                length += keyItem.data.size();
+                if(!keyItem.partial) {
+                    break;
+                }
+                keyItem = ReadNext(reader);
+            }
+
+            index = Info::Find(std::string_view{buffer, length});
+        } else {
+            reader.skip();
+        }
+
+        // then read (or skip) the value
+        const auto valueItem = ReadNext(reader);
+        if(index < Info::kNumFields) {
+            kDecoders[index](reader, valueItem, out);
+        } else {
+            reader.skip();
+        }
+    }
+}
+
+/**
+ * @brief Decode a value of the given type, starting at the provided item
+ */
+template<class T>
+void DecodeValue(CborReader &reader, const CborReader::Item &item, T &out) {
+    using Type = CborReader::Type;
+
+    if constexpr(CborBound<T>) {
+        DecodeMap(reader, item, out);
+    } else if constexpr(IsOptional<T>::value) {
+        if(item.type == Type::Null || item.type == Type::Undefined) {
+            out.reset();
+        } else {
+            DecodeValue(reader, item, out.emplace());
+        }
+    } else if constexpr(std::is_enum_v<T>) {
+        std::underlying_type_t<T> value;
+        DecodeValue(reader, item, value);
+        out = static_cast<T>(value);
+    } else if constexpr(std::is_same_v<T, bool>) {
+        if(item.type != Type::Bool) {
+            throw std::runtime_error("invalid type (expected bool)");
+        }
+        out = item.value;
+    } else if constexpr(std::unsigned_integral<T>) {
+        if(item.type != Type::Unsigned) {
+            throw std::runtime_error("invalid type (expected uint)");
+        } else if(item.value > std::numeric_limits<T>::max()) {
+            throw std::out_of_range("CBOR integer out of range");
+        }
+        out = static_cast<T>(item.value);
+    } else if constexpr(std::signed_integral<T>) {
+        if(item.type != Type::Unsigned && item.type != Type::Negative) {
+            throw std::runtime_error("invalid type (expected int)");
+        }
+        const auto value = item.getInt();
+        if(value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) {
+            throw std::out_of_range("CBOR integer out of range");
+        }
+        out = static_cast<T>(value);
+    } else if constexpr(std::floating_point<T>) {
+        if(item.type == Type::Float) {
+            out = static_cast<T>(item.number);
+        } else if(item.type == Type::Unsigned || item.type == Type::Negative) {
+            out = static_cast<T>(item.getInt());
+        } else {
+            throw std::runtime_error("invalid type (expected float)");
+        }
+    } else if constexpr(std::is_same_v<T, std::string>) {
+        if(item.type != Type::TextString) {
+            throw std::runtime_error("invalid type (expected string)");
+        }
+        out.clear();
+        ReadString(reader, item, out);
+
+        if(!IsValidUtf8(out)) {
+            throw std::runtime_error("invalid string (malformed UTF-8)");
+        }
+    } else if constexpr(std::is_same_v<T, std::vector<std::byte>>) {
+        if(item.type != Type::ByteString) {
+            throw std::runtime_error("invalid type (expected bytes)");
+        }
+        out.clear();
+        ReadString(reader, item, out);
+    } else if constexpr(IsTimePoint<T>::value) {
+        using namespace std::chrono;
+
+        if(item.type != Type::Tag || item.value != 1) {
+            throw std::invalid_argument("invalid argument (expected tagged item)");
+        }
+        double secs;
+        DecodeValue(reader, ReadNext(reader), secs);
+        out = T(duration_cast<typename T::duration>(duration<double>(secs)));
+    } else if constexpr(IsVector<T>::value) {
+        if(item.type != Type::ArrayStart) {
+            throw std::runtime_error("invalid type (expected array)");
+        }
+        out.clear();
+        if(item.value != CborReader::kIndefinite) {
+            out.reserve(item.value);
+        }
+
+        CborReader::Item element;
+        while((element = ReadNext(reader)).type != Type::End) {
+            DecodeValue(reader, element, out.emplace_back());
+        }
+    } else {
+        static_assert(!sizeof(T), "unsupported type in CBOR binding");
+    }
+}
+
+template<class Writer, class T>
+void EncodeValue(Writer &writer, const T &value);
+
+/**
+ * @brief Encode a bound struct as a map, with keys in canonical order
+ */
+template<class Writer, CborBound T>
+void EncodeMap(Writer &writer, const T &value) {
+    using Info = BindingInfo<T>;
+
+    const auto isPresent = [&value]<size_t I>(std::integral_constant<size_t, I>) {
+        const auto &field = value.*(std::get<I>(Info::kFields).member);
+        if constexpr(IsOptional<std::remove_cvref_t<decltype(field)>>::value) {
+            return field.has_value();
+        } else {
+            return true;
+        }
+    };
+
+    // count fields to write (empty optionals are omitted)
+    const size_t numPairs = [&]<size_t... I>(std::index_sequence<I...>) {
+        return (size_t{0} + ... + (isPresent(std::integral_constant<size_t, I>{}) ? 1 : 0));
+    }(std::make_index_sequence<Info::kNumFields>{});
+    writer.beginMap(numPairs);
+
+    // then write them in sorted order
+    [&]<size_t... S>(std::index_sequence<S...>) {
+        ([&]() {
+            constexpr size_t kIndex = Info::kSorted[S].index;
+            if(!isPresent(std::integral_constant<size_t, kIndex>{})) {
+                return;
+            }
+
+            constexpr auto kKey = Info::kSorted[S].key;
+            if constexpr(kKey.isString) {
+                writer.writeString(kKey.string);
+            } else {
+                writer.writeUint(kKey.number);
+            }
+            EncodeValue(writer, value.*(std::get<kIndex>(Info::kFields).member));
+        }(), ...);
+    }(std::make_index_sequence<Info::kNumFields>{});
+}
+
+/**
+ * @brief Encode a value of any supported type
+ */
+template<class Writer, class T>
+void EncodeValue(Writer &writer, const T &value) {
+    if constexpr(CborBound<T>) {
+        EncodeMap(writer, value);
+    } else if constexpr(IsOptional<T>::value) {
+        if(value) {
+            EncodeValue(writer, *value);
+        } else {
+            writer.writeNull();
+        }
+    } else if constexpr(std::is_enum_v<T>) {
+        writer.write(static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr(IsVector<T>::value && !std::is_same_v<T, std::vector<std::byte>>) {
+        writer.beginArray(value.size());
+        for(const auto &element : value) {
+            EncodeValue(writer, element);
+        }
+    } else {
+        writer.write(value);
+    }
+}
+}
+
+/**
+ * @brief Encode a bound struct
+ *
+ * The struct is written as a definite length map with its keys in canonical order.
+ *
+ * @param writer CBOR writer to output to
+ * @param value Struct to encode
+ */
+template<CborSink Sink, CborBound T>
+inline void CborEncode(CborWriter<Sink> &writer, const T &value) {
+    detail::EncodeMap(writer, value);
+}
+
+/**
+ * @brief Decode a bound struct from a reader
+ *
+ * The reader must be positioned at the start of a map, and have all of its data available (that
+ * is, the entire message must have been fed to it.)
+ *
+ * @param reader CBOR reader to decode from
+ * @param value Struct to decode into; fields not present in the map are left untouched
+ */
+template<CborBound T>
+inline void CborDecode(CborReader &reader, T &value) {
+    detail::DecodeMap(reader, detail::ReadNext(reader), value);
+}
+
+/**
+ * @brief Decode a bound struct from a buffer
+ *
+ * @param data Buffer holding an encoded map
+ * @param value Struct to decode into; fields not present in the map are left untouched
+ */
+template<CborBound T>
+inline void CborDecode(std::span<const std::byte> data, T &value) {
+    CborReader reader;
+    reader.feed(data);
+    CborDecode(reader, value);
+}
+}
+
+#endif
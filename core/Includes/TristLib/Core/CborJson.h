@@ -0,0 +1,99 @@
+/**
+ * @file
+ *
+ * @brief Streaming CBOR to JSON conversion
+ *
+ * Converts CBOR to JSON text in a single pass, without building a tree of items first. The
+ * mapping follows RFC 8949, section 6.1:
+ *
+ * - Integers, booleans, arrays and maps map to their JSON counterparts; non-string map keys are
+ *   converted to strings
+ * - Floating point values are written in their shortest form that round-trips (at the precision
+ *   they were encoded with); NaN and infinities become `null`
+ * - Byte strings are written as base64url strings (without padding)
+ * - Null, undefined and other simple values become `null`
+ * - Timestamps (tag 1, as written by `CborEncodeTimestamp()`) become ISO 8601 strings in UTC;
+ *   other tags are dropped, and only their content is written
+ */
+#ifndef TRISTLIB_CORE_CBORJSON_H
+#define TRISTLIB_CORE_CBORJSON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "TristLib/Core/CborReader.h"
+
+namespace TristLib::Core {
+/**
+ * @brief Incremental CBOR to JSON converter
+ *
+ * Input can be fed in segments of any size, as it arrives; JSON text is appended to the output
+ * string as soon as possible. If the input is a CBOR sequence, each top level item is written on
+ * its own line.
+ *
+ * Malformed input (including text strings that aren't valid UTF-8) results in a
+ * `std::runtime_error` being thrown.
+ */
+class CborJsonTranscoder {
+    public:
+        CborJsonTranscoder(std::string &output) : output(output) {}
+
+        void feed(std::span<const std::byte> data);
+
+        /**
+         * @brief Whether all input fed so far has been converted
+         *
+         * That is, the input ended at the end of a top level item.
+         */
+        constexpr bool isAtBoundary() const {
+            return this->reader.isAtBoundary();
+        }
+
+    private:
+        /// Type of an open container
+        enum class Container: uint8_t {
+            Array,
+            Map,
+            /// Indefinite length string (whose chunks are collected)
+            String,
+        };
+
+        void writeSeparator(const CborReader::Item &item);
+        void writeItem(const CborReader::Item &item);
+        void writeString(const CborReader::Type type, std::string_view data);
+        void writeNumber(const CborReader::Item &item);
+        void writeTimestamp(const CborReader::Item &item);
+
+    private:
+        /// Output string
+        std::string &output;
+
+        /// Reader decoding the input
+        CborReader reader;
+
+        /// Types of open containers
+        Container containers[CborReader::kMaxDepth];
+        /// Set for each open container, until its first item was written
+        bool first[CborReader::kMaxDepth];
+
+        /// Whether any top level items have been written
+        bool wroteItem{false};
+        /// Tag applying to the next item (or 0 if none)
+        uint64_t tag{0};
+        /// Whether a separator was already written for the next item (because it's tagged)
+        bool separated{false};
+
+        /// Set while collecting a definite length string that's split across input segments
+        bool inString{false};
+        /// Type of the indefinite length string being collected
+        CborReader::Type stringType{CborReader::Type::TextString};
+        /// Chunks of a string split across multiple items
+        std::string scratch;
+};
+
+std::string CborToJson(std::span<const std::byte> data);
+}
+
+#endif
@@ -0,0 +1,541 @@
+/**
+ * @file
+ *
+ * @brief Incremental CBOR decoder
+ *
+ * A pull style decoder: input is fed to it in segments as it arrives, and the caller pulls one
+ * item at a time from it. The decoder keeps its state between segments, so items (and even item
+ * headers) may be split across segments arbitrarily. Nothing is allocated: strings are returned
+ * as views into the fed data, in multiple chunks if they span segments.
+ */
+#ifndef TRISTLIB_CORE_CBORREADER_H
+#define TRISTLIB_CORE_CBORREADER_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace TristLib::Core {
+/**
+ * @brief Pull style incremental CBOR decoder
+ *
+ * Call `feed()` with a segment of input, then `next()` repeatedly until it returns an item of
+ * type `NeedMore`: at this point, the entire segment has been consumed, and the next one may be
+ * fed. Containers are reported as a start item, followed by their contents, followed by an `End`
+ * item; the contents of an uninteresting item can be skipped with `skip()`.
+ *
+ * Malformed input results in a `std::runtime_error` being thrown.
+ *
+ * @remark Data returned for strings points into the segment passed to `feed()`, so it's only
+ *         valid until the next segment is fed.
+ */
+class CborReader {
+    public:
+        /// Maximum nesting depth of containers
+        constexpr static const size_t kMaxDepth{32};
+        /// Length of indefinite length items
+        constexpr static const uint64_t kIndefinite{std::numeric_limits<uint64_t>::max()};
+
+        /**
+         * @brief Types of items returned by the reader
+         */
+        enum class Type: uint8_t {
+            /// The current segment is exhausted; feed more data
+            NeedMore,
+            /// Unsigned integer (`value`)
+            Unsigned,
+            /// Negative integer (`-1 - value`; use `getInt()`)
+            Negative,
+            /// Byte string (`data`; total length in `value`)
+            ByteString,
+            /// Text string (`data`; total length in `value`)
+            TextString,
+            /// Start of an array (number of items in `value`)
+            ArrayStart,
+            /// Start of a map (number of pairs in `value`)
+            MapStart,
+            /// End of an array, map or indefinite length string
+            End,
+            /// Tag (tag number in `value`) applying to the following item
+            Tag,
+            /// Boolean (`value` is 0 or 1)
+            Bool,
+            /// Null value
+            Null,
+            /// Undefined value
+            Undefined,
+            /// Other simple value (`value`)
+            Simple,
+            /// Floating point value (`number`; its encoded size in bytes in `value`)
+            Float,
+        };
+
+        /**
+         * @brief An item read from the input
+         */
+        struct Item {
+            /// Type of item
+            Type type{Type::NeedMore};
+            /// Set if this item is a key in a map
+            bool isKey{false};
+            /// For strings: set if more chunks of this string follow
+            bool partial{false};
+            /// Nesting depth of the item (top level items are at depth 0)
+            uint32_t depth{0};
+            /// Integer value, length, tag number or simple value
+            uint64_t value{0};
+            /// Floating point value
+            double number{0};
+            /// String data (or chunk thereof)
+            std::span<const std::byte> data;
+
+            /// Get a (positive or negative) integer value
+            inline int64_t getInt() const {
+                if(this->value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                    throw std::out_of_range("CBOR integer out of range");
+                }
+                return (this->type == Type::Negative) ? (-1 - static_cast<int64_t>(this->value)) :
+                    static_cast<int64_t>(this->value);
+            }
+
+            /// Get string data as a string view
+            inline std::string_view getString() const {
+                return {reinterpret_cast<const char *>(this->data.data()), this->data.size()};
+            }
+
+            /// Whether this item completes a value (rather than starting or prefixing one)
+            constexpr bool isComplete() const {
+                switch(this->type) {
+                    case Type::NeedMore:
+                    case Type::ArrayStart:
+                    case Type::MapStart:
+                    case Type::Tag:
+                        return false;
+                    case Type::ByteString:
+                    case Type::TextString:
+                        return !this->partial;
+                    default:
+                        return true;
+                }
+            }
+        };
+
+    private:
+        /// An open container
+        struct Frame {
+            /// Number of items in the container (twice the pairs, for maps), or kIndefinite
+            uint64_t count;
+            /// Number of items read so far
+            uint64_t index;
+            /// Set if the container is a map
+            bool isMap;
+            /// Set if the container is an indefinite length string
+            bool isString;
+        };
+
+    public:
+        /**
+         * @brief Provide the next segment of input
+         *
+         * The previous segment must have been fully consumed (that is, `next()` must have
+         * returned `NeedMore`.)
+         */
+        inline void feed(std::span<const std::byte> segment) {
+            this->cursor = segment.data();
+            this->end = segment.data() + segment.size();
+            this->segmentStart = segment.data();
+        }
+
+        /**
+         * @brief Read the next item
+         *
+         * @return The next item, or an item of type `NeedMore` if the current segment has been
+         *         consumed entirely
+         */
+        Item next() {
+            while(true) {
+                auto item = this->nextRaw();
+                if(!this->skipping || item.type == Type::NeedMore) {
+                    this->last = item;
+                    return item;
+                }
+
+                if(item.isComplete() && item.depth == this->skipDepth) {
+                    this->skipping = false;
+                }
+            }
+        }
+
+        /**
+         * @brief Skip the remainder of the last item returned
+         *
+         * For containers, all their contents (and their end) are skipped; for tags, the tagged
+         * item; and for partial strings, the remaining chunks. Skipping continues across
+         * segments, if required.
+         */
+        inline void skip() {
+            if(this->last.isComplete() || this->last.type == Type::NeedMore) {
+                return;
+            }
+
+            this->skipping = true;
+            this->skipDepth = this->last.depth;
+        }
+
+        /**
+         * @brief Whether the reader is between two top level items
+         *
+         * This can be used to detect the end of a message, when reading a sequence of them.
+         */
+        constexpr bool isAtBoundary() const {
+            return !this->depth && !this->stringRemaining && !this->headLength && !this->inTag &&
+                !this->skipping;
+        }
+
+        /// Get the number of bytes of the current segment consumed so far
+        constexpr size_t getOffset() const {
+            return this->cursor - this->segmentStart;
+        }
+
+        /// Get the current nesting depth
+        constexpr size_t getDepth() const {
+            return this->depth;
+        }
+
+    private:
+        /**
+         * @brief Read the next item, without considering skipping
+         */
+        Item nextRaw() {
+            // continue a string
+            if(this->stringRemaining) {
+                if(this->cursor == this->end) {
+                    return {};
+                }
+
+                const auto length = std::min<uint64_t>(this->stringRemaining,
+                        this->end - this->cursor);
+                auto item = this->stringItem;
+                item.data = {this->cursor, static_cast<size_t>(length)};
+                this->cursor += length;
+                this->stringRemaining -= length;
+
+                item.partial = (this->stringRemaining != 0);
+                if(!item.partial) {
+                    this->finishItem();
+                }
+                return item;
+            }
+
+            // close a definite length container that's complete
+            if(this->depth) {
+                auto &top = this->stack[this->depth - 1];
+                if(top.count != kIndefinite && top.index == top.count) {
+                    return this->closeContainer();
+                }
+            }
+
+            // read the next item's head
+            uint8_t initial;
+            uint64_t arg;
+            if(!this->readHead(initial, arg)) {
+                return {};
+            }
+
+            const uint8_t major = initial >> 5, info = initial & 0x1F;
+
+            Item item;
+            item.depth = this->depth;
+            item.value = arg;
+            if(this->depth) {
+                const auto &top = this->stack[this->depth - 1];
+                item.isKey = top.isMap && !(top.index & 1);
+
+                // indefinite length strings may only contain definite strings of the same type
+                if(top.isString && initial != 0xFF) {
+                    const uint8_t expected = (this->stringItem.type == Type::ByteString) ? 2 : 3;
+                    if(major != expected || info == 31) {
+                        throw std::runtime_error("invalid chunk in indefinite length string");
+                    }
+                }
+            }
+
+            switch(major) {
+                case 0:
+                    item.type = Type::Unsigned;
+                    break;
+                case 1:
+                    item.type = Type::Negative;
+                    break;
+
+                case 2:
+                case 3:
+                    item.type = (major == 2) ? Type::ByteString : Type::TextString;
+
+                    if(info == 31) {
+                        item.value = kIndefinite;
+                        item.partial = true;
+                        this->stringItem = item;
+                        this->pushFrame({kIndefinite, 0, false, true});
+                        return item;
+                    }
+
+                    if(arg) {
+                        this->stringItem = item;
+                        this->stringRemaining = arg;
+                        return this->nextRaw();
+                    }
+                    break;
+
+                case 4:
+                case 5:
+                    item.type = (major == 4) ? Type::ArrayStart : Type::MapStart;
+                    item.value = (info == 31) ? kIndefinite : arg;
+
+                    if(info != 31 && major == 5 && arg > (kIndefinite - 1) / 2) {
+                        throw std::runtime_error("CBOR map too large");
+                    }
+                    this->pushFrame({(info == 31) ? kIndefinite : (major == 5 ? arg * 2 : arg), 0,
+                            major == 5, false});
+                    return item;
+
+                case 6:
+                    item.type = Type::Tag;
+                    this->inTag = true;
+                    return item;
+
+                case 7:
+                    if(info == 31) {
+                        // break: terminates an indefinite length container
+                        if(!this->depth || this->stack[this->depth - 1].count != kIndefinite) {
+                            throw std::runtime_error("unexpected CBOR break");
+                        }
+                        auto &top = this->stack[this->depth - 1];
+                        if(top.isMap && (top.index & 1)) {
+                            throw std::runtime_error("CBOR map missing value");
+                        }
+                        return this->closeContainer();
+                    }
+
+                    DecodeSimple(item, info, arg);
+                    break;
+            }
+
+            this->finishItem();
+            return item;
+        }
+
+        /**
+         * @brief Read an item head
+         *
+         * Heads split across segments are collected in a small internal buffer.
+         *
+         * @return Whether a complete head was read
+         */
+        bool readHead(uint8_t &initial, uint64_t &arg) {
+            const std::byte *head;
+
+            if(!this->headLength) {
+                if(this->cursor == this->end) {
+                    return false;
+                }
+
+                const auto needed = HeadSize(static_cast<uint8_t>(*this->cursor));
+                if(static_cast<size_t>(this->end - this->cursor) >= needed) {
+                    head = this->cursor;
+                    this->cursor += needed;
+                    return DecodeHead(head, initial, arg);
+                }
+            }
+
+            // slow path: accumulate the head in the scratch buffer
+            while(this->cursor != this->end) {
+                this->headBuffer[this->headLength++] = *this->cursor++;
+                if(this->headLength == HeadSize(static_cast<uint8_t>(this->headBuffer[0]))) {
+                    this->headLength = 0;
+                    return DecodeHead(this->headBuffer, initial, arg);
+                }
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Get the total size of an item head, given its initial byte
+         */
+        static constexpr size_t HeadSize(const uint8_t initial) {
+            const auto info = initial & 0x1F;
+            if(info < 24 || info == 31) {
+                return 1;
+            } else if(info <= 27) {
+                return 1 + (1U << (info - 24));
+            }
+            throw std::runtime_error("invalid CBOR additional info");
+        }
+
+        /**
+         * @brief Decode an item head
+         */
+        static inline bool DecodeHead(const std::byte *head, uint8_t &initial, uint64_t &arg) {
+            initial = static_cast<uint8_t>(head[0]);
+            const auto info = initial & 0x1F;
+
+            if(info < 24) {
+                arg = info;
+            } else if(info == 31) {
+                arg = kIndefinite;
+                const auto major = initial >> 5;
+                if(major == 0 || major == 1 || major == 6) {
+                    throw std::runtime_error("invalid indefinite length CBOR item");
+                }
+            } else {
+                const size_t bytes = 1U << (info - 24);
+                arg = 0;
+                for(size_t i = 0; i < bytes; i++) {
+                    arg = (arg << 8) | static_cast<uint8_t>(head[1 + i]);
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Decode a simple value or floating point number
+         */
+        static void DecodeSimple(Item &item, const uint8_t info, const uint64_t arg) {
+            switch(info) {
+                case 20:
+                case 21:
+                    item.type = Type::Bool;
+                    item.value = (info == 21);
+                    break;
+                case 22:
+                    item.type = Type::Null;
+                    break;
+                case 23:
+                    item.type = Type::Undefined;
+                    break;
+                case 25:
+                    item.type = Type::Float;
+                    item.number = DecodeHalf(static_cast<uint16_t>(arg));
+                    item.value = 2;
+                    break;
+                case 26:
+                    item.type = Type::Float;
+                    item.number = std::bit_cast<float>(static_cast<uint32_t>(arg));
+                    item.value = 4;
+                    break;
+                case 27:
+                    item.type = Type::Float;
+                    item.number = std::bit_cast<double>(arg);
+                    item.value = 8;
+                    break;
+                default:
+                    item.type = Type::Simple;
+                    break;
+            }
+        }
+
+        /**
+         * @brief Decode a half precision floating point value
+         *
+         * See RFC 8949, appendix D.
+         */
+        static double DecodeHalf(const uint16_t half) {
+            const int exponent = (half >> 10) & 0x1F;
+            const int mantissa = half & 0x3FF;
+            double value;
+
+            if(!exponent) {
+                value = std::ldexp(mantissa, -24);
+            } else if(exponent != 31) {
+                value = std::ldexp(mantissa + 1024, exponent - 25);
+            } else {
+                value = mantissa ? std::numeric_limits<double>::quiet_NaN() :
+                    std::numeric_limits<double>::infinity();
+            }
+
+            return (half & 0x8000) ? -value : value;
+        }
+
+        /**
+         * @brief Open a container
+         */
+        inline void pushFrame(const Frame &frame) {
+            if(this->depth == kMaxDepth) {
+                throw std::runtime_error("CBOR nesting too deep");
+            }
+            this->stack[this->depth++] = frame;
+            this->inTag = false;
+        }
+
+        /**
+         * @brief Close the innermost container, and produce its end item
+         */
+        inline Item closeContainer() {
+            this->depth--;
+
+            Item item;
+            item.type = Type::End;
+            item.depth = this->depth;
+            if(this->depth) {
+                const auto &top = this->stack[this->depth - 1];
+                item.isKey = top.isMap && !(top.index & 1);
+            }
+
+            this->finishItem();
+            return item;
+        }
+
+        /**
+         * @brief Account for a completed item in its container
+         */
+        inline void finishItem() {
+            this->inTag = false;
+            if(this->depth) {
+                this->stack[this->depth - 1].index++;
+            }
+        }
+
+    private:
+        /// Current read position
+        const std::byte *cursor{nullptr};
+        /// End of the current segment
+        const std::byte *end{nullptr};
+        /// Start of the current segment
+        const std::byte *segmentStart{nullptr};
+
+        /// Partially received item head
+        std::byte headBuffer[9];
+        /// Number of bytes in the head buffer
+        size_t headLength{0};
+
+        /// Open containers
+        Frame stack[kMaxDepth];
+        /// Number of open containers
+        size_t depth{0};
+
+        /// Template for chunks of the string being read
+        Item stringItem;
+        /// Bytes remaining in the string being read
+        uint64_t stringRemaining{0};
+        /// Set if a tag was read, but not yet the item it applies to
+        bool inTag{false};
+
+        /// Last item returned
+        Item last;
+        /// Set while skipping
+        bool skipping{false};
+        /// Depth of the item being skipped
+        uint32_t skipDepth{0};
+};
+}
+
+#endif
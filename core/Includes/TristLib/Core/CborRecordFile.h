@@ -0,0 +1,253 @@
+/**
+ * @file
+ *
+ * @brief Indexed CBOR record files
+ *
+ * A record file is a CBOR sequence (RFC 8742) of timestamped records, so it can be processed by
+ * any tool that understands those. It consists of:
+ *
+ * - A header item: `55800(["TLRecord", version])` (the tag is the CBOR sequence file magic of
+ *   RFC 9277)
+ * - Any number of records: `[1(timestamp), 24(h'payload')]`; the timestamp is a floating point
+ *   value (as written by `CborEncodeTimestamp()`) and the payload an encoded CBOR item, wrapped
+ *   in a byte string so it can be skipped without parsing it
+ * - An index: an array of `[timestamp, offset]` pairs, one for (at least) every
+ *   `kIndexInterval` bytes of records
+ * - A trailer: a 16 byte byte string, containing `kTrailerMagic` and the offset of the index (as
+ *   a big endian 64-bit integer)
+ *
+ * Records must be written in order of their timestamps. Readers map the file into memory, and use
+ * the index to seek to the first record of a time range directly; if the index is missing (the
+ * writer didn't close the file cleanly) it's rebuilt by walking the records' headers.
+ */
+#ifndef TRISTLIB_CORE_CBORRECORDFILE_H
+#define TRISTLIB_CORE_CBORRECORDFILE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace TristLib::Core {
+/**
+ * @brief Definitions of the record file format
+ */
+namespace CborRecordFile {
+/// Clock used for record timestamps
+using Clock = std::chrono::system_clock;
+
+/// Name in the file header
+constexpr static const std::string_view kMagic{"TLRecord"};
+/// Current version of the file format
+constexpr static const uint64_t kVersion{1};
+/// Magic value at the start of the trailer
+constexpr static const std::string_view kTrailerMagic{"TLRIndex"};
+/// Size of the trailer (a byte string holding the magic value and index offset)
+constexpr static const size_t kTrailerSize{17};
+
+/// Maximum distance between records referenced by the index
+constexpr static const size_t kIndexInterval{64 * 1024};
+
+/**
+ * @brief Index entry
+ */
+struct IndexEntry {
+    /// Timestamp of the record (seconds since the UNIX epoch)
+    double time;
+    /// Offset of the record in the file
+    uint64_t offset;
+};
+}
+
+/**
+ * @brief Writes records to a record file
+ *
+ * Records are buffered, and written to the file in large batches. The index is written when the
+ * file is closed; an existing file is appended to (its index is removed again until then.)
+ */
+class CborRecordWriter {
+    public:
+        /// Size of the write buffer
+        constexpr static const size_t kBufferSize{256 * 1024};
+
+    public:
+        CborRecordWriter(const std::filesystem::path &path);
+        ~CborRecordWriter();
+
+        CborRecordWriter(const CborRecordWriter &) = delete;
+        CborRecordWriter &operator=(const CborRecordWriter &) = delete;
+
+        void append(const CborRecordFile::Clock::time_point time,
+                std::span<const std::byte> payload);
+
+        void flush();
+        void close();
+
+    private:
+        void writeAll(std::span<const std::byte> data);
+
+    private:
+        /// File descriptor of the file
+        int fd{-1};
+
+        /// Buffered data not yet written to the file
+        std::vector<std::byte> buffer;
+        /// File offset of the start of the buffer
+        uint64_t offset{0};
+
+        /// Index entries
+        std::vector<CborRecordFile::IndexEntry> index;
+        /// Timestamp of the last record written
+        double lastTime{0};
+};
+
+/**
+ * @brief Reads records from a record file
+ *
+ * The file is mapped into memory when opened; records written to it later aren't visible.
+ */
+class CborRecordReader {
+    public:
+        /**
+         * @brief A record read from the file
+         */
+        struct Record {
+            /// Timestamp of the record
+            CborRecordFile::Clock::time_point time;
+            /// Encoded payload item
+            std::span<const std::byte> payload;
+            /// Offset of the record in the file
+            uint64_t offset;
+        };
+
+        /**
+         * @brief Iterator over consecutive records
+         *
+         * The iteration ends at the end of the records, or at the first record with a timestamp
+         * at or after the iterator's limit.
+         */
+        class Iterator {
+            friend class CborRecordReader;
+
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = Record;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const Record *;
+                using reference = const Record &;
+
+                Iterator() = default;
+
+                inline const Record &operator*() const {
+                    return this->current;
+                }
+                inline const Record *operator->() const {
+                    return &this->current;
+                }
+
+                inline Iterator &operator++() {
+                    this->load(this->next);
+                    return *this;
+                }
+                inline Iterator operator++(int) {
+                    auto temp = *this;
+                    ++*this;
+                    return temp;
+                }
+
+                inline bool operator==(const Iterator &other) const {
+                    return this->current.offset == other.current.offset;
+                }
+
+            private:
+                Iterator(const CborRecordReader *reader, const uint64_t offset, const double limit)
+                    : reader(reader), limit(limit) {
+                    this->load(offset);
+                }
+
+                void load(const uint64_t offset);
+
+            private:
+                const CborRecordReader *reader{nullptr};
+                /// Timestamp at which iteration ends
+                double limit{0};
+
+                /// Current record
+                Record current{};
+                /// Timestamp of the current record, as stored in the file
+                double timestamp{0};
+                /// Offset of the record following the current one
+                uint64_t next{0};
+        };
+
+        /**
+         * @brief A range of records, usable in range-based for loops
+         */
+        struct Range {
+            Iterator first, last;
+
+            constexpr Iterator begin() const {
+                return this->first;
+            }
+            constexpr Iterator end() const {
+                return this->last;
+            }
+        };
+
+    public:
+        CborRecordReader(const std::filesystem::path &path);
+        ~CborRecordReader();
+
+        CborRecordReader(const CborRecordReader &) = delete;
+        CborRecordReader &operator=(const CborRecordReader &) = delete;
+
+        Iterator begin() const;
+        Iterator end() const;
+
+        Range getRange(const CborRecordFile::Clock::time_point start,
+                const CborRecordFile::Clock::time_point end) const;
+        std::optional<Record> readAt(const uint64_t offset) const;
+
+        /// Whether the file's index was present (rather than rebuilt)
+        constexpr bool hadIndex() const {
+            return this->indexValid;
+        }
+        /// Get the index entries
+        constexpr const std::vector<CborRecordFile::IndexEntry> &getIndex() const {
+            return this->index;
+        }
+        /// Get the offset of the end of the last (complete) record
+        constexpr uint64_t getDataEnd() const {
+            return this->dataEnd;
+        }
+
+    private:
+        bool loadIndex();
+        void rebuildIndex();
+        bool parseRecord(const uint64_t offset, Record &record, double &timestamp,
+                uint64_t &next) const;
+
+    private:
+        /// Mapped file contents
+        const std::byte *data{nullptr};
+        /// Size of the file
+        size_t size{0};
+
+        /// Offset of the first record
+        uint64_t dataStart{0};
+        /// Offset past the last record
+        uint64_t dataEnd{0};
+
+        /// Index entries, in order of their timestamps
+        std::vector<CborRecordFile::IndexEntry> index;
+        /// Whether the index was read from the file
+        bool indexValid{false};
+};
+}
+
+#endif
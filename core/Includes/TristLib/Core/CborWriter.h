@@ -0,0 +1,316 @@
+/**
+ * @file
+ *
+ * @brief Streaming CBOR encoder
+ *
+ * Encodes CBOR items directly into an output sink as they're written, without building a tree
+ * of items first; nothing is allocated per item. Containers are written by emitting their header
+ * (with the number of items) followed by the items themselves, or as indefinite length
+ * containers that are terminated with `end()`.
+ */
+#ifndef TRISTLIB_CORE_CBORWRITER_H
+#define TRISTLIB_CORE_CBORWRITER_H
+
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace TristLib::Core {
+namespace detail {
+template<class T>
+struct IsTimePoint: std::false_type {};
+template<class C, class D>
+struct IsTimePoint<std::chrono::time_point<C, D>>: std::true_type {};
+}
+
+/**
+ * @brief Output sink for a CBOR writer
+ *
+ * Sinks receive the encoded bytes through a `write(const void *data, size_t length)` method.
+ */
+template<class T>
+concept CborSink = requires(T &sink, const void *data, const size_t length) {
+    sink.write(data, length);
+};
+
+/**
+ * @brief CBOR sink writing into a fixed size buffer
+ *
+ * @remark Attempting to write past the end of the buffer throws `std::length_error`.
+ */
+class CborSpanSink {
+    public:
+        constexpr CborSpanSink(std::span<std::byte> buffer) : buffer(buffer) {}
+
+        inline void write(const void *data, const size_t length) {
+            if(length > this->buffer.size() - this->offset) [[unlikely]] {
+                throw std::length_error("CBOR output buffer full");
+            }
+
+            memcpy(this->buffer.data() + this->offset, data, length);
+            this->offset += length;
+        }
+
+        /// Get the part of the buffer written so far
+        constexpr std::span<std::byte> getWritten() const {
+            return this->buffer.subspan(0, this->offset);
+        }
+
+    private:
+        /// Output buffer
+        std::span<std::byte> buffer;
+        /// Number of bytes written
+        size_t offset{0};
+};
+
+/**
+ * @brief CBOR sink appending to a byte vector
+ *
+ * The vector is not cleared first, and its storage is reused, so writing into a vector that is
+ * kept around doesn't allocate once it's grown to size.
+ */
+class CborVectorSink {
+    public:
+        constexpr CborVectorSink(std::vector<std::byte> &buffer) : buffer(buffer) {}
+
+        inline void write(const void *data, const size_t length) {
+            const auto bytes = static_cast<const std::byte *>(data);
+            this->buffer.insert(this->buffer.end(), bytes, bytes + length);
+        }
+
+    private:
+        std::vector<std::byte> &buffer;
+};
+
+/**
+ * @brief Streaming CBOR encoder
+ *
+ * Integers and container lengths use the shortest encoding possible, as required for preferred
+ * serialization (RFC 8949 section 4.1.)
+ *
+ * @tparam Sink Output sink type
+ */
+template<CborSink Sink>
+class CborWriter {
+    public:
+        /// Major types
+        enum MajorType: uint8_t {
+            Unsigned                            = 0,
+            Negative                            = 1,
+            ByteString                          = 2,
+            TextString                          = 3,
+            Array                               = 4,
+            Map                                 = 5,
+            Tag                                 = 6,
+            Simple                              = 7,
+        };
+
+    public:
+        constexpr CborWriter(Sink &sink) : sink(sink) {}
+
+        /// Write an unsigned integer
+        inline CborWriter &writeUint(const uint64_t value) {
+            this->writeHead(MajorType::Unsigned, value);
+            return *this;
+        }
+        /// Write a signed integer
+        inline CborWriter &writeInt(const int64_t value) {
+            if(value < 0) {
+                // -1 - value, without overflowing for the most negative value
+                this->writeHead(MajorType::Negative, ~static_cast<uint64_t>(value));
+            } else {
+                this->writeHead(MajorType::Unsigned, static_cast<uint64_t>(value));
+            }
+            return *this;
+        }
+        /// Write a boolean
+        inline CborWriter &writeBool(const bool value) {
+            return this->writeByte(value ? 0xF5 : 0xF4);
+        }
+        /// Write a null value
+        inline CborWriter &writeNull() {
+            return this->writeByte(0xF6);
+        }
+        /// Write an undefined value
+        inline CborWriter &writeUndefined() {
+            return this->writeByte(0xF7);
+        }
+
+        /// Write a double precision floating point value
+        inline CborWriter &writeDouble(const double value) {
+            return this->writeFixed(0xFB, std::bit_cast<uint64_t>(value));
+        }
+        /// Write a single precision floating point value
+        inline CborWriter &writeFloat(const float value) {
+            return this->writeFixed(0xFA, std::bit_cast<uint32_t>(value));
+        }
+
+        /// Write a text string (which must be UTF-8)
+        inline CborWriter &writeString(const std::string_view str) {
+            this->writeHead(MajorType::TextString, str.size());
+            this->sink.write(str.data(), str.size());
+            return *this;
+        }
+        /// Write a byte string
+        inline CborWriter &writeBytes(std::span<const std::byte> bytes) {
+            this->writeHead(MajorType::ByteString, bytes.size());
+            this->sink.write(bytes.data(), bytes.size());
+            return *this;
+        }
+
+        /// Start an array with the given number of items
+        inline CborWriter &beginArray(const size_t numItems) {
+            this->writeHead(MajorType::Array, numItems);
+            return *this;
+        }
+        /// Start an indefinite length array; it must be terminated with `end()`
+        inline CborWriter &beginArray() {
+            return this->writeByte((MajorType::Array << 5) | 31);
+        }
+        /// Start a map with the given number of key/value pairs
+        inline CborWriter &beginMap(const size_t numPairs) {
+            this->writeHead(MajorType::Map, numPairs);
+            return *this;
+        }
+        /// Start an indefinite length map; it must be terminated with `end()`
+        inline CborWriter &beginMap() {
+            return this->writeByte((MajorType::Map << 5) | 31);
+        }
+        /// Terminate an indefinite length container
+        inline CborWriter &end() {
+            return this->writeByte(0xFF);
+        }
+
+        /// Tag the following item
+        inline CborWriter &writeTag(const uint64_t tag) {
+            this->writeHead(MajorType::Tag, tag);
+            return *this;
+        }
+
+        /**
+         * @brief Write a timestamp
+         *
+         * The timestamp is written as a floating point number of seconds since the UNIX epoch,
+         * tagged with tag 1; this is the same encoding as `CborEncodeTimestamp()`.
+         *
+         * See RFC8949 section 3.4.2 for the details of this encoding.
+         */
+        template<class Clock, class Duration>
+        inline CborWriter &writeTimestamp(const std::chrono::time_point<Clock, Duration> time) {
+            using namespace std::chrono;
+
+            this->writeTag(1);
+            return this->writeDouble(duration_cast<duration<double>>(
+                        time.time_since_epoch()).count());
+        }
+
+        /**
+         * @brief Write a value, choosing the encoding based on its type
+         *
+         * Supports booleans, integers, floating point values, strings, byte spans and time
+         * points.
+         */
+        template<class T>
+        inline CborWriter &write(const T &value) {
+            using Type = std::remove_cvref_t<T>;
+
+            if constexpr(std::is_same_v<Type, bool>) {
+                return this->writeBool(value);
+            } else if constexpr(std::unsigned_integral<Type>) {
+                return this->writeUint(value);
+            } else if constexpr(std::signed_integral<Type>) {
+                return this->writeInt(value);
+            } else if constexpr(std::is_same_v<Type, float>) {
+                return this->writeFloat(value);
+            } else if constexpr(std::floating_point<Type>) {
+                return this->writeDouble(value);
+            } else if constexpr(std::is_convertible_v<const Type &, std::string_view>) {
+                return this->writeString(value);
+            } else if constexpr(std::is_convertible_v<const Type &, std::span<const std::byte>>) {
+                return this->writeBytes(value);
+            } else if constexpr(detail::IsTimePoint<Type>::value) {
+                return this->writeTimestamp(value);
+            } else {
+                static_assert(!sizeof(T), "unsupported type");
+            }
+        }
+
+        /**
+         * @brief Write the head of an item
+         *
+         * @param major Major type
+         * @param value Argument (length, value, tag number)
+         */
+        inline void writeHead(const uint8_t major, const uint64_t value) {
+            const uint8_t type = major << 5;
+            uint8_t buf[9];
+
+            if(value < 24) {
+                buf[0] = type | value;
+                this->sink.write(buf, 1);
+            } else if(value <= 0xFF) {
+                buf[0] = type | 24;
+                buf[1] = value;
+                this->sink.write(buf, 2);
+            } else if(value <= 0xFFFF) {
+                buf[0] = type | 25;
+                StoreBigEndian<uint16_t>(buf + 1, value);
+                this->sink.write(buf, 3);
+            } else if(value <= 0xFFFF'FFFF) {
+                buf[0] = type | 26;
+                StoreBigEndian<uint32_t>(buf + 1, value);
+                this->sink.write(buf, 5);
+            } else {
+                buf[0] = type | 27;
+                StoreBigEndian<uint64_t>(buf + 1, value);
+                this->sink.write(buf, 9);
+            }
+        }
+
+    private:
+        inline CborWriter &writeByte(const uint8_t byte) {
+            this->sink.write(&byte, 1);
+            return *this;
+        }
+
+        template<class T>
+        inline CborWriter &writeFixed(const uint8_t initial, const T value) {
+            uint8_t buf[1 + sizeof(T)];
+            buf[0] = initial;
+            StoreBigEndian<T>(buf + 1, value);
+            this->sink.write(buf, sizeof(buf));
+            return *this;
+        }
+
+        /**
+         * @brief Store an integer in big endian byte order
+         */
+        template<class T>
+        static inline void StoreBigEndian(uint8_t *out, const T value) {
+            T be = value;
+            if constexpr(std::endian::native == std::endian::little) {
+                if constexpr(sizeof(T) == 2) {
+                    be = __builtin_bswap16(value);
+                } else if constexpr(sizeof(T) == 4) {
+                    be = __builtin_bswap32(value);
+                } else {
+                    be = __builtin_bswap64(value);
+                }
+            }
+            memcpy(out, &be, sizeof(T));
+        }
+
+    private:
+        Sink &sink;
+};
+}
+
+#endif
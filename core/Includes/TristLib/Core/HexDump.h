@@ -21,12 +21,23 @@
 #ifndef TRISTLIB_CORE_HEXDUMP_H
 #define TRISTLIB_CORE_HEXDUMP_H
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
 #include <ios>
 #include <iomanip>
+#include <ostream>
+#include <ranges>
 #include <span>
 #include <sstream>
+#include <string>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /// Helpers for printing arbitrary byte buffers
 namespace TristLib::Core::HexDump {
     using std::endl;
@@ -51,6 +62,158 @@ namespace TristLib::Core::HexDump {
 
     constexpr const size_t BytesPerLine{16};
 
+    // Width of the hex column (including the trailing space)
+    constexpr const size_t HexColumnWidth{BytesPerLine * 3 + 1};
+    // Longest line written by FormatHexLine: 16 digit offset, hex and text columns, newline
+    constexpr const size_t MaxLineLength{16 + 2 + HexColumnWidth + BytesPerLine + 1};
+    // Number of lines DumpStream and DumpBuffer format before writing them out
+    constexpr const size_t LinesPerBatch{64};
+
+    namespace detail {
+        // Two lowercase hex digits and a space for each byte value (padded to four chars, so
+        // they can be copied as a whole)
+        constexpr const auto HexDigits = []() {
+            constexpr const char digits[]{"0123456789abcdef"};
+
+            std::array<char, 1024> table{};
+            for(size_t i = 0; i < 256; i++) {
+                table[i * 4] = digits[i >> 4];
+                table[i * 4 + 1] = digits[i & 0xF];
+                table[i * 4 + 2] = ' ';
+                table[i * 4 + 3] = ' ';
+            }
+            return table;
+        }();
+
+        // Character in the text column for each byte value (same as isprint() in the C locale)
+        constexpr const auto TextChars = []() {
+            std::array<char, 256> table{};
+            for(size_t i = 0; i < 256; i++) {
+                table[i] = (i >= 0x20 && i < 0x7F) ? static_cast<char>(i) : '.';
+            }
+            return table;
+        }();
+    }
+
+    // Format one line of up to BytesPerLine bytes, in the same layout as DumpHexLine (with an
+    // offset), into a buffer of at least MaxLineLength chars; returns the number of chars written
+    inline size_t FormatHexLine(char* out, size_t offset, const unsigned char* bytes,
+            size_t count) {
+        char* p = out;
+
+        // offset: at least 8 digits, more if it doesn't fit (in which case it may have a leading
+        // zero digit to strip)
+        size_t digitPairs{4};
+        while(digitPairs < 8 && (offset >> (digitPairs * 8))) {
+            digitPairs++;
+        }
+        for(size_t i = digitPairs; i > 0; i--) {
+            const auto byte = (offset >> ((digitPairs - i) * 8)) & 0xFF;
+            memcpy(p + (i - 1) * 2, &detail::HexDigits[byte * 4], 2);
+        }
+        if(digitPairs > 4 && *p == '0') {
+            memmove(p, p + 1, digitPairs * 2 - 1);
+            p--;
+        }
+        p += digitPairs * 2;
+        *p++ = ' ';
+        *p++ = ' ';
+
+        // hex column, padded to a fixed width; then the text column
+        if(count == BytesPerLine) {
+#if defined(__SSE2__)
+            // full lines (the common case): convert all nibbles to hex digits at once
+            const auto line = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+            const auto nibbleMask = _mm_set1_epi8(0x0F);
+            const auto high = _mm_and_si128(_mm_srli_epi16(line, 4), nibbleMask);
+            const auto low = _mm_and_si128(line, nibbleMask);
+
+            const auto toAscii = [](__m128i nibbles) {
+                const auto letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)),
+                        _mm_set1_epi8('a' - '0' - 10));
+                return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+            };
+            alignas(16) char digits[BytesPerLine * 2];
+            _mm_store_si128(reinterpret_cast<__m128i*>(digits),
+                    _mm_unpacklo_epi8(toAscii(high), toAscii(low)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(digits + 16),
+                    _mm_unpackhi_epi8(toAscii(high), toAscii(low)));
+
+            memset(p, ' ', HexColumnWidth);
+            for(size_t i = 0; i < BytesPerLine; i++) {
+                memcpy(p + i * 3, digits + i * 2, 2);
+            }
+            p += HexColumnWidth;
+
+            // printable characters are 0x20 to 0x7E (bytes >= 0x80 are negative here)
+            const auto printable = _mm_andnot_si128(_mm_cmpeq_epi8(line, _mm_set1_epi8(0x7F)),
+                    _mm_cmpgt_epi8(line, _mm_set1_epi8(0x1F)));
+            const auto text = _mm_or_si128(_mm_and_si128(printable, line),
+                    _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), text);
+#else
+            // full lines (the common case) get fixed size loops the compiler can unroll
+            for(size_t i = 0; i < BytesPerLine; i++) {
+                memcpy(p + i * 3, &detail::HexDigits[bytes[i] * 4], 4);
+            }
+            p += HexColumnWidth;
+            for(size_t i = 0; i < BytesPerLine; i++) {
+                p[i] = detail::TextChars[bytes[i]];
+            }
+#endif
+        } else {
+            for(size_t i = 0; i < count; i++) {
+                memcpy(p + i * 3, &detail::HexDigits[bytes[i] * 4], 4);
+            }
+            memset(p + count * 3, ' ', HexColumnWidth - count * 3);
+            p += HexColumnWidth;
+            for(size_t i = 0; i < count; i++) {
+                p[i] = detail::TextChars[bytes[i]];
+            }
+        }
+        p += count;
+        *p++ = '\n';
+
+        return p - out;
+    }
+
+    // Upper bound on the number of chars FormatBuffer writes for the given number of bytes
+    constexpr size_t MaxFormattedLength(size_t length) {
+        return ((length + BytesPerLine - 1) / BytesPerLine) * MaxLineLength;
+    }
+
+    // Format a buffer in the same layout as DumpBuffer, into a buffer of at least
+    // MaxFormattedLength(input.size()) chars; offsets start at the given value. Returns the
+    // number of chars written.
+    template<typename ByteType>
+    size_t FormatBuffer(char* out, std::span<const ByteType> input, size_t offset = 0) {
+        static_assert(sizeof(ByteType) == 1, "byte type must be one byte in size");
+
+        auto bytes = reinterpret_cast<const unsigned char*>(input.data());
+        size_t remaining{input.size()}, written{0};
+
+        while(remaining) {
+            const auto count = std::min(remaining, BytesPerLine);
+            written += FormatHexLine(out + written, offset, bytes, count);
+
+            bytes += count;
+            offset += count;
+            remaining -= count;
+        }
+
+        return written;
+    }
+
+    // Format a buffer in the same layout as DumpBuffer, appending to a string
+    template<typename ByteType>
+    void FormatBuffer(std::string& output, std::span<const ByteType> input, size_t offset = 0) {
+        const auto start = output.size();
+        output.resize(start + MaxFormattedLength(input.size()));
+
+        const auto written = FormatBuffer(output.data() + start, input, offset);
+        output.resize(start + written);
+    }
+
     // Saves original formatting state for a stream and
     // restores that state before going out of scope
     template<typename Stream>
@@ -125,48 +288,124 @@ namespace TristLib::Core::HexDump {
     // Dump bytes from input stream in side-by-side hex and text formats
     template<typename OutputStream, typename InputStream>
     void DumpStream(OutputStream& output, InputStream& input) {
-        vector<char> bytesToDump;
-        bytesToDump.reserve(BytesPerLine);
-
-        size_t offset = 0;
+        // read a batch of lines at a time, then format and write them out in one go
+        char bytes[LinesPerBatch * BytesPerLine];
+        char buffer[LinesPerBatch * MaxLineLength];
 
-        char byte;
-        while(input.get(byte)) {
-            bytesToDump.push_back(byte);
-
-            if(bytesToDump.size() == BytesPerLine) {
-                DumpHexLine(output, offset, bytesToDump);
-                bytesToDump.clear();
-                offset += BytesPerLine;
+        size_t offset{0};
+        while(input) {
+            input.read(bytes, sizeof(bytes));
+            const auto count = static_cast<size_t>(input.gcount());
+            if(!count) {
+                break;
             }
-        }
 
-        if(!bytesToDump.empty()) {
-            DumpHexLine(output, offset, bytesToDump);
+            output.write(buffer, FormatBuffer(buffer, std::span<const char>(bytes, count),
+                        offset));
+            offset += count;
         }
+
+        output.flush();
     }
 
     // Dump bytes from buffer in side-by-side hex and text formats
     template<typename OutputStream, typename ByteType>
     void DumpBuffer(OutputStream& output, std::span<const ByteType> input) {
-        vector<char> bytesToDump;
-        bytesToDump.reserve(BytesPerLine);
+        // format a batch of lines at a time, then write them out in one go
+        char buffer[LinesPerBatch * MaxLineLength];
 
-        size_t offset{0}, bytesRead{0};
+        for(size_t offset = 0; offset < input.size(); offset += LinesPerBatch * BytesPerLine) {
+            const auto batch = input.subspan(offset,
+                    std::min(input.size() - offset, LinesPerBatch * BytesPerLine));
+            output.write(buffer, FormatBuffer(buffer, batch, offset));
+        }
 
-        while(bytesRead < input.size()) {
-            bytesToDump.push_back(static_cast<char>(input[bytesRead++]));
+        output.flush();
+    }
 
-            if(bytesToDump.size() == BytesPerLine) {
-                DumpHexLine(output, offset, bytesToDump);
-                bytesToDump.clear();
-                offset += BytesPerLine;
-            }
+    // Length (or limit) that doesn't restrict how much is dumped
+    constexpr const size_t ToEnd{static_cast<size_t>(-1)};
+
+    // Dump (part of) a file in side-by-side hex and text formats; offsets are those in the file.
+    //
+    // The file is mapped into memory, and split into chunks that are formatted in parallel. If
+    // collapse is set, lines identical to the preceding line are replaced by a single "*" line
+    // like hexdump -C does; if the dump ends with such lines, the offset of its end is printed
+    // on its own line. Throws std::system_error if the file can't be read.
+    void DumpFile(std::ostream& output, const std::filesystem::path& path, size_t offset = 0,
+            size_t length = ToEnd, bool collapse = true);
+
+    // A buffer that is dumped (in the same layout as DumpBuffer) when it's streamed into an
+    // output stream, such as a log record:
+    //
+    //     PLOG_VERBOSE << "received " << size << " bytes:" << HexDump::Head(packet, 256);
+    //
+    // Nothing is formatted until then, so a log statement that's filtered out costs nothing. The
+    // dump starts on a new line, and doesn't end with one. It can be limited to the first or last
+    // bytes of the buffer, in which case a line notes how many bytes were left out.
+    //
+    // The buffer isn't copied: it must remain valid until the dump is streamed.
+    class LazyDump
+    {
+    public:
+        LazyDump(std::span<const std::byte> data, size_t limit = ToEnd, bool fromEnd = false)
+        : data(data), limit(limit), fromEnd(fromEnd)
+        {}
+
+        // Accept any contiguous container of bytes, like std::vector<char> or std::string_view
+        template<std::ranges::contiguous_range Range>
+            requires(sizeof(std::ranges::range_value_t<Range>) == 1)
+        LazyDump(const Range& data, size_t limit = ToEnd, bool fromEnd = false)
+        : LazyDump(std::as_bytes(std::span(std::ranges::data(data), std::ranges::size(data))),
+                limit, fromEnd)
+        {}
+
+        friend std::ostream& operator<<(std::ostream& output, const LazyDump& dump) {
+            dump.write(output);
+            return output;
         }
 
-        if(!bytesToDump.empty()) {
-            DumpHexLine(output, offset, bytesToDump);
+    private:
+        void write(std::ostream& output) const {
+            const auto count = std::min(data.size(), limit);
+            const auto skipped = data.size() - count;
+            const size_t start = fromEnd ? skipped : 0;
+
+            if(skipped && fromEnd) {
+                output << "\n... (" << skipped << " bytes skipped)";
+            }
+
+            // format a batch of lines at a time; each line's newline is moved to its front
+            char buffer[LinesPerBatch * MaxLineLength + 1];
+            buffer[0] = '\n';
+
+            for(size_t offset = 0; offset < count; offset += LinesPerBatch * BytesPerLine) {
+                const auto batch = data.subspan(start + offset,
+                        std::min(count - offset, LinesPerBatch * BytesPerLine));
+                output.write(buffer, FormatBuffer(buffer + 1, batch, start + offset));
+            }
+
+            if(skipped && !fromEnd) {
+                output << "\n... (" << skipped << " more bytes)";
+            }
         }
+
+    private:
+        std::span<const std::byte> data;
+        size_t limit;
+        bool fromEnd;
+    };
+
+    // Dump at most the first limit bytes of a buffer, when streamed into an output stream
+    template<typename Range>
+    LazyDump Head(const Range& data, size_t limit) {
+        return LazyDump(data, limit, false);
+    }
+
+    // Dump at most the last limit bytes of a buffer, when streamed into an output stream
+    template<typename Range>
+    LazyDump Tail(const Range& data, size_t limit) {
+        return LazyDump(data, limit, true);
     }
 }
 
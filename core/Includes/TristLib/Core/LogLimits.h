@@ -0,0 +1,220 @@
+/**
+ * @file
+ *
+ * @brief Rate limited and sampled logging
+ *
+ * Log statements made with `TLOG_RATE_LIMITED_()` pass through a per call site token bucket, and
+ * those made with `TLOG_SAMPLED_()` log only one in every N records. Either way, the number of
+ * suppressed records is counted: it's reported by the next record the site logs. Additionally,
+ * once `kSuppressedLogReportInterval` has elapsed, the next suppressed record triggers a summary
+ * of all sites, so sites that stop logging (or are suppressing everything) are reported too.
+ * `ReportSuppressedLogs()` can be invoked to report them right away, such as before exiting.
+ */
+#ifndef TRISTLIB_CORE_LOGLIMITS_H
+#define TRISTLIB_CORE_LOGLIMITS_H
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include <plog/Log.h>
+
+#include "TristLib/Core/LogModules.h"
+
+namespace TristLib::Core {
+/// Interval (in nanoseconds) at which suppressed records of all sites are summarized
+constexpr static const uint64_t kSuppressedLogReportInterval{10'000'000'000ULL};
+
+namespace detail {
+/// Time (on the coarse monotonic clock) at which suppressed records are next summarized
+extern std::atomic<uint64_t> gNextSuppressionReport;
+
+void ReportSuppressedLogsPeriodic(const uint64_t now);
+
+/**
+ * @brief Get the current time from the coarse monotonic clock, in nanoseconds
+ */
+inline uint64_t GetCoarseTime() noexcept {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + ts.tv_nsec;
+}
+}
+
+/**
+ * @brief Call site that may suppress records
+ *
+ * Counts suppressed records; the first time a site suppresses a record, it's added to a global
+ * list, so its count can be reported even if it never logs again.
+ */
+struct LogSuppressionSite {
+    /// Severity of records logged at this site
+    const plog::Severity severity;
+    /// Function name
+    const char *func;
+    /// Source line number
+    const uint32_t line;
+    /// Source file name
+    const char *file;
+
+    /// Number of records suppressed since the last report
+    std::atomic<uint64_t> suppressed{0};
+    /// Set once the site has been added to the global list
+    std::atomic_bool registered{false};
+    /// Next site in the global list
+    LogSuppressionSite *next{nullptr};
+
+    constexpr LogSuppressionSite(const plog::Severity severity, const char *func,
+            const uint32_t line, const char *file) : severity(severity), func(func), line(line),
+        file(file) {}
+
+    /**
+     * @brief Count a suppressed record
+     *
+     * If the summary interval has elapsed, suppressed records of all sites are reported.
+     *
+     * @param now Current time, from `detail::GetCoarseTime()`
+     */
+    inline void suppress(const uint64_t now) {
+        this->suppressed.fetch_add(1, std::memory_order_relaxed);
+
+        if(!this->registered.load(std::memory_order_relaxed)) [[unlikely]] {
+            this->registerSite();
+        }
+
+        if(now >= detail::gNextSuppressionReport.load(std::memory_order_relaxed)) [[unlikely]] {
+            detail::ReportSuppressedLogsPeriodic(now);
+        }
+    }
+
+    /**
+     * @brief Report suppressed records (if any) before a record is logged
+     */
+    inline void flushSuppressed() {
+        if(this->suppressed.load(std::memory_order_relaxed)) [[unlikely]] {
+            this->report();
+        }
+    }
+
+    void report();
+
+    private:
+        void registerSite() noexcept;
+};
+
+/**
+ * @brief Token bucket rate limiter for a call site
+ *
+ * Implemented as a generic cell rate algorithm: the only state is the theoretical arrival time
+ * of the next record, which is updated with a single compare and swap.
+ */
+struct LogRateLimiter: public LogSuppressionSite {
+    /// Nanoseconds between records, at the sustained rate
+    const uint64_t interval;
+    /// How far (in nanoseconds) the arrival time may run ahead of the clock
+    const uint64_t tolerance;
+
+    /// Theoretical arrival time of the next record
+    std::atomic<uint64_t> arrival{0};
+
+    /**
+     * @brief Initialize a rate limiter
+     *
+     * @param perSecond Sustained number of records per second
+     * @param burst Maximum number of records logged in a burst
+     */
+    constexpr LogRateLimiter(const uint32_t perSecond, const uint32_t burst,
+            const plog::Severity severity, const char *func, const uint32_t line,
+            const char *file) : LogSuppressionSite(severity, func, line, file),
+        interval(1'000'000'000ULL / std::max(perSecond, 1U)),
+        tolerance(interval * (std::max(burst, 1U) - 1)) {}
+
+    /**
+     * @brief Check whether a record may be logged
+     *
+     * If so, any suppressed records are reported first; otherwise, the record is counted as
+     * suppressed.
+     */
+    inline bool allow() {
+        const uint64_t now = detail::GetCoarseTime();
+
+        auto arrival = this->arrival.load(std::memory_order_relaxed);
+        uint64_t next;
+
+        do {
+            const auto start = std::max(arrival, now);
+            if(start - now > this->tolerance) {
+                this->suppress(now);
+                return false;
+            }
+            next = start + this->interval;
+        } while(!this->arrival.compare_exchange_weak(arrival, next, std::memory_order_relaxed));
+
+        this->flushSuppressed();
+        return true;
+    }
+};
+
+/**
+ * @brief Sampler that allows one in every N records from a call site
+ */
+struct LogSampler: public LogSuppressionSite {
+    /// Sampling period
+    const uint64_t period;
+    /// Number of records seen
+    std::atomic<uint64_t> count{0};
+
+    /**
+     * @brief Initialize a sampler
+     *
+     * @param period Log one out of this many records (starting with the first)
+     */
+    constexpr LogSampler(const uint64_t period, const plog::Severity severity, const char *func,
+            const uint32_t line, const char *file) : LogSuppressionSite(severity, func, line,
+                file), period(std::max(period, uint64_t{1})) {}
+
+    /**
+     * @brief Check whether a record may be logged
+     */
+    inline bool allow() {
+        if(this->count.fetch_add(1, std::memory_order_relaxed) % this->period) {
+            this->suppress(detail::GetCoarseTime());
+            return false;
+        }
+
+        this->flushSuppressed();
+        return true;
+    }
+};
+
+void ReportSuppressedLogs();
+}
+
+/**
+ * @brief Log a record tagged with a module, subject to a per call site rate limit
+ *
+ * @param module Module name (a string literal)
+ * @param severity plog severity of the record (a constant expression)
+ * @param perSecond Sustained number of records per second
+ * @param burst Number of records that may be logged in a burst
+ */
+#define TLOG_RATE_LIMITED_(module, severity, perSecond, burst) TLOG_IF_(module, severity) \
+    if(static TristLib::Core::LogRateLimiter _tlogLimiter{perSecond, burst, severity, \
+            PLOG_GET_FUNC(), __LINE__, PLOG_GET_FILE()}; !_tlogLimiter.allow()) {;} \
+    else TLOG_RECORD_(severity)
+
+/**
+ * @brief Log one out of every N records made at this call site
+ *
+ * @param module Module name (a string literal)
+ * @param severity plog severity of the record (a constant expression)
+ * @param period Log one out of this many records
+ */
+#define TLOG_SAMPLED_(module, severity, period) TLOG_IF_(module, severity) \
+    if(static TristLib::Core::LogSampler _tlogSampler{period, severity, PLOG_GET_FUNC(), \
+            __LINE__, PLOG_GET_FILE()}; !_tlogSampler.allow()) {;} \
+    else TLOG_RECORD_(severity)
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file
+ *
+ * @brief Per-module log levels and compile-time log level elision
+ *
+ * Log statements made with the `TLOG_*` macros are tagged with a module name (such as `"Socket"`)
+ * whose log level can be changed at runtime independently of the global log level, via
+ * `SetLogLevel(module, level)`. Each call site caches the level of its module, so checking
+ * whether a statement is enabled costs two loads and a compare.
+ *
+ * Statements less severe than `TRISTLIB_LOG_MAX_SEVERITY` (a plog severity) are removed at
+ * compile time; their arguments are never evaluated.
+ */
+#ifndef TRISTLIB_CORE_LOGMODULES_H
+#define TRISTLIB_CORE_LOGMODULES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include <plog/Log.h>
+
+/// Least severe log statements to compile in
+#ifndef TRISTLIB_LOG_MAX_SEVERITY
+#define TRISTLIB_LOG_MAX_SEVERITY plog::verbose
+#endif
+
+namespace TristLib::Core {
+/**
+ * @brief Check whether log statements of a given severity are compiled in
+ */
+constexpr static inline bool IsLogSeverityCompiled(const plog::Severity severity) {
+    return severity <= TRISTLIB_LOG_MAX_SEVERITY;
+}
+
+namespace detail {
+/// Incremented whenever any log level changes, invalidating the levels cached by call sites
+extern std::atomic<uint32_t> gLogLevelGeneration;
+/// Global log level (the logger's own level may be lower, if a ring log wants more records)
+extern std::atomic<plog::Severity> gLogSeverity;
+/**
+ * @brief Log level of the module whose record is being submitted on this thread
+ *
+ * Set by module call sites right before submitting a record, and consumed by the log level
+ * filter in front of the log destinations; `-1` (for records not tagged with a module) means the
+ * global log level applies.
+ */
+extern thread_local int gSubmittingSeverity;
+}
+
+/**
+ * @brief Log call site tagged with a module
+ *
+ * Caches the effective log level of the module and the ring log's level, along with the log
+ * level generation they were determined at.
+ */
+struct LogModuleSite {
+    /// Name of the module
+    const char *module;
+    /// Log level generation (upper 32 bits), ring log severity (second byte) and cached maximum
+    /// severity (low byte)
+    std::atomic<uint64_t> cached{0};
+
+    /**
+     * @brief Check whether a record of the given severity should be logged
+     *
+     * Records are logged if the module's level, or that of the ring log, allows them.
+     */
+    inline bool check(const plog::Severity severity) noexcept {
+        const uint64_t generation = detail::gLogLevelGeneration.load(std::memory_order_relaxed);
+        auto value = this->cached.load(std::memory_order_relaxed);
+
+        if((value >> 32) != generation) [[unlikely]] {
+            value = this->refresh();
+        }
+
+        return severity <= static_cast<plog::Severity>(std::max(value & 0xFF,
+                    (value >> 8) & 0xFF));
+    }
+
+    /**
+     * @brief Submit a record made at this call site to the logger
+     *
+     * The module's log level is passed along, so that the log destinations filter the record by
+     * it (rather than by the global log level.)
+     */
+    inline void operator+=(const plog::Record &record) {
+        detail::gSubmittingSeverity = static_cast<int>(
+                this->cached.load(std::memory_order_relaxed) & 0xFF);
+        (*plog::get<PLOG_DEFAULT_INSTANCE_ID>()) += record;
+    }
+
+    uint64_t refresh() noexcept;
+};
+}
+
+/**
+ * @brief Begin a log statement tagged with a module
+ *
+ * Expands to an if statement, whose final else branch is taken only if a record of the given
+ * severity is compiled in and enabled for the module.
+ */
+#define TLOG_IF_(module, severity) \
+    if constexpr(!TristLib::Core::IsLogSeverityCompiled(severity)) {;} else \
+    if(static TristLib::Core::LogModuleSite _tlogSite{module}; !_tlogSite.check(severity)) {;} \
+    else
+
+/**
+ * @brief Create a record and submit it through the call site, bypassing the logger's severity check
+ *
+ * Must be used in a branch of `TLOG_IF_()`, whose call site it refers to.
+ */
+#define TLOG_RECORD_(severity) \
+    _tlogSite += plog::Record(severity, PLOG_GET_FUNC(), __LINE__, PLOG_GET_FILE(), \
+            PLOG_GET_THIS(), PLOG_DEFAULT_INSTANCE_ID).ref()
+
+/**
+ * @brief Log a record tagged with a module
+ *
+ * Use like plog's `PLOG_()` macro: the record's message is streamed into it.
+ *
+ * @param module Module name (a string literal)
+ * @param severity plog severity of the record (a constant expression)
+ */
+#define TLOG_(module, severity) TLOG_IF_(module, severity) TLOG_RECORD_(severity)
+
+#define TLOG_VERBOSE(module) TLOG_(module, plog::verbose)
+#define TLOG_DEBUG(module) TLOG_(module, plog::debug)
+#define TLOG_INFO(module) TLOG_(module, plog::info)
+#define TLOG_WARNING(module) TLOG_(module, plog::warning)
+#define TLOG_ERROR(module) TLOG_(module, plog::error)
+#define TLOG_FATAL(module) TLOG_(module, plog::fatal)
+
+#endif
@@ -1,28 +1,103 @@
 #ifndef LOGGING_H
 #define LOGGING_H
 
+#include <chrono>
 #include <cstddef>
 #include <filesystem>
+#include <optional>
 #include <string_view>
 
 #include <plog/Log.h>
 
 namespace TristLib::Core {
+/// What asynchronous log destinations do when a thread's queue is full
+enum class LogOverflowPolicy {
+    /// Discard the record
+    Drop,
+    /// Discard the record, and periodically log how many records were discarded
+    Count,
+    /// Wait until the background writer makes space in the queue
+    Block,
+};
+
+/// Configuration for an asynchronous log destination
+struct AsyncLogConfig {
+    /// Maximum number of records queued per thread (rounded up to a power of two)
+    size_t queueDepth{1024};
+    /// What to do when a thread's queue is full
+    LogOverflowPolicy overflow{LogOverflowPolicy::Count};
+};
+
+/// When buffered log files are synced to disk
+enum class LogFileSync {
+    /// Never explicitly
+    Never,
+    /// When the file is rotated (before it's compressed)
+    OnRotate,
+    /// After the buffered records are written out periodically
+    Periodic,
+    /// Every time buffered records are written to the file
+    Always,
+};
+
+/// Configuration for a buffered log file destination
+struct FileLogConfig {
+    /// Size at which the file is rotated (0 to never rotate)
+    size_t maxFileSize{0};
+    /// Number of files (including the current one) to keep when rotating
+    size_t maxFiles{0};
+    /// Format records as CSV
+    bool csv{false};
+
+    /// Total size of the record buffers
+    size_t bufferSize{256 * 1024};
+    /// Interval at which buffered records are written, even if the buffers aren't full
+    std::chrono::milliseconds flushInterval{1000};
+    /// When the file is synced to disk
+    LogFileSync sync{LogFileSync::OnRotate};
+    /// Compress rotated files with gzip
+    bool compress{false};
+};
+
 /// Set up logger without any outputs
 void InitLogging(const int logLevel) noexcept;
 /// Set up logger and attach tty output
 void InitLogging(const int logLevel, const bool simple) noexcept;
 
 /// Add an output to the system console
-void AddLogDestinationStdout(const bool simple, const bool colorize = true) noexcept;
+void AddLogDestinationStdout(const bool simple, const bool colorize = true,
+        const std::optional<AsyncLogConfig> &async = std::nullopt);
 /// Add an output to syslog
-void AddLogDestinationSyslog(const int facility, const std::string_view ident) noexcept;
+void AddLogDestinationSyslog(const int facility, const std::string_view ident,
+        const std::optional<AsyncLogConfig> &async = std::nullopt);
+/// Add an output to the systemd journal (or syslog socket) that never blocks
+void AddLogDestinationJournal(const int facility, const std::string_view ident,
+        const std::optional<AsyncLogConfig> &async = std::nullopt);
 /// Add an output to the specified file
 void AddLogDestinationFile(const std::filesystem::path &file, const size_t maxFileSize = 0,
-        const size_t maxFiles = 0, const bool csv = false);
+        const size_t maxFiles = 0, const bool csv = false,
+        const std::optional<AsyncLogConfig> &async = std::nullopt);
+/// Add a buffered output to the specified file
+void AddLogDestinationFile(const std::filesystem::path &file, const FileLogConfig &config,
+        const std::optional<AsyncLogConfig> &async = std::nullopt);
+/// Add an output to a memory mapped ring file, which keeps the most recent records (at its own log
+/// level, independent of the global log level)
+void AddLogDestinationRing(const std::filesystem::path &file, const size_t size = 16 * 1024 * 1024,
+        const int level = 2);
+/// Add a binary (deferred formatting) output to the specified file
+void AddLogDestinationBinary(const std::filesystem::path &file);
 
 /// Update the log level
 void SetLogLevel(const int logLevel);
+/// Override the log level of a single module
+void SetLogLevel(const std::string_view module, const int logLevel);
+/// Remove a module's log level override
+void ClearLogLevel(const std::string_view module);
+
+/// Wait for all asynchronous log destinations to write their queued records
+void FlushLogs();
+/// Get the total number of log records dropped
+size_t GetDroppedLogCount() noexcept;
 };
 
 #endif
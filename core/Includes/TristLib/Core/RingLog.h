@@ -0,0 +1,83 @@
+/**
+ * @file
+ *
+ * @brief Memory mapped ring log file format
+ *
+ * A ring log file starts with a header page, followed by a fixed number of equally sized
+ * chunks. Writing threads reserve a whole chunk at a time (in a round robin fashion, overwriting
+ * the oldest data) and then append records to it without further synchronization. Each record is
+ * tagged with a global sequence number, so the `tristlib-ringdump` tool can extract the records
+ * in order, even after the process crashed.
+ */
+#ifndef TRISTLIB_CORE_RINGLOG_H
+#define TRISTLIB_CORE_RINGLOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace TristLib::Core::RingLog {
+/// Magic value at the start of the file
+constexpr static const std::string_view kMagic{"TristLib ring log"};
+/// Current version of the file format
+constexpr static const uint32_t kVersion{1};
+
+/// Size of the file header (the data area starts after it)
+constexpr static const size_t kHeaderSize{4096};
+/// Size of a single chunk
+constexpr static const size_t kChunkSize{16 * 1024};
+
+/**
+ * @brief File header
+ */
+struct FileHeader {
+    /// Magic value (`kMagic`, zero padded)
+    char magic[24];
+    /// File format version
+    uint32_t version;
+    /// Size of each chunk, in bytes
+    uint32_t chunkSize;
+    /// Number of chunks in the file
+    uint64_t numChunks;
+
+    /// Number of chunks ever reserved; the next chunk goes into slot `nextChunk % numChunks`
+    alignas(64) std::atomic<uint64_t> nextChunk;
+    /// Sequence number of the next record
+    alignas(64) std::atomic<uint64_t> nextSequence;
+};
+static_assert(sizeof(FileHeader) <= kHeaderSize);
+
+/**
+ * @brief Header at the start of each chunk
+ */
+struct ChunkHeader {
+    /// Number of the chunk, plus one (zero if the chunk was never used)
+    std::atomic<uint64_t> number;
+    /// Thread that reserved the chunk
+    uint64_t tid;
+};
+
+/**
+ * @brief Header preceding each record in a chunk
+ *
+ * Records are aligned to 8 bytes. The record is only valid once its size is nonzero.
+ */
+struct RecordHeader {
+    /// Total size of the record (header, message and padding); written last
+    std::atomic<uint32_t> size;
+    /// Length of the message
+    uint32_t length;
+    /// Global sequence number
+    uint64_t sequence;
+    /// Low 32 bits of the chunk number the record was written in (to detect stale records)
+    uint32_t chunkTag;
+    uint32_t reserved;
+};
+
+/// Maximum message length that fits in a chunk
+constexpr static const size_t kMaxMessageLength{kChunkSize - sizeof(ChunkHeader) -
+    sizeof(RecordHeader)};
+}
+
+#endif
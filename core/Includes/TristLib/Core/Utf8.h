@@ -0,0 +1,29 @@
+/**
+ * @file
+ *
+ * @brief UTF-8 validation
+ *
+ * Checks that strings are well-formed UTF-8 (per the Unicode standard, table 3-7): no overlong
+ * encodings, surrogates, code points past U+10FFFF, or truncated/stray continuation bytes.
+ *
+ * The check is vectorized (with AVX2 or SSSE3, whichever the processor supports best) using the
+ * lookup algorithm of Keiser and Lemire; other processors use a scalar implementation.
+ */
+#ifndef TRISTLIB_CORE_UTF8_H
+#define TRISTLIB_CORE_UTF8_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace TristLib::Core {
+bool IsValidUtf8(const void *data, const size_t length);
+
+/**
+ * @brief Determine whether a string is well-formed UTF-8
+ */
+inline bool IsValidUtf8(const std::string_view str) {
+    return IsValidUtf8(str.data(), str.size());
+}
+}
+
+#endif
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <stdexcept>
+
+#include "AsyncAppender.h"
+
+using namespace TristLib::Core;
+
+/**
+ * @brief Interval at which the writer checks for dropped records and exited threads
+ */
+constexpr static const std::chrono::milliseconds kWriterIdleInterval{250};
+
+/**
+ * @brief Source of unique appender identifiers
+ */
+static std::atomic<uint64_t> gNextAppenderId{1};
+
+thread_local AsyncAppenderBase::ThreadQueues AsyncAppenderBase::gThreadQueues;
+
+
+
+/**
+ * @brief Allocate a record queue
+ *
+ * @param capacity Minimum number of records the queue can hold
+ */
+AsyncAppenderBase::Queue::Queue(const size_t capacity) :
+    entries(std::make_unique<Entry[]>(std::bit_ceil(capacity))),
+    mask(std::bit_ceil(capacity) - 1) {
+}
+
+/**
+ * @brief Mark all of a thread's queues as abandoned
+ */
+AsyncAppenderBase::ThreadQueues::~ThreadQueues() {
+    for(auto &[id, queue] : this->queues) {
+        queue->abandoned = true;
+    }
+}
+
+
+
+/**
+ * @brief Initialize an asynchronous appender
+ *
+ * Start the writer thread.
+ *
+ * @param next Appender to pass formatted records to; we take ownership of it
+ * @param config Queue depth and overflow policy
+ */
+AsyncAppenderBase::AsyncAppenderBase(plog::IAppender *next, const AsyncLogConfig &config) :
+    id(gNextAppenderId++), next(next), config(config) {
+    if(!config.queueDepth) {
+        throw std::invalid_argument("invalid queue depth");
+    }
+
+    this->writer = std::thread(&AsyncAppenderBase::writerMain, this);
+}
+
+/**
+ * @brief Shut down the appender
+ *
+ * All queued records are written before the writer thread exits.
+ */
+AsyncAppenderBase::~AsyncAppenderBase() {
+    {
+        std::lock_guard lg(this->sleepLock);
+        this->shutdown = true;
+    }
+    this->wakeCond.notify_all();
+
+    this->writer.join();
+}
+
+/**
+ * @brief Queue a formatted record
+ *
+ * Place the record in the calling thread's queue, waking the writer if it's idle. If the queue is
+ * full, the overflow policy decides whether the record is dropped, or we wait for space.
+ *
+ * @param record Record that was formatted
+ * @param formatted Formatted record
+ */
+void AsyncAppenderBase::enqueue(const plog::Record &record, plog::util::nstring &&formatted) {
+    auto &queue = this->getQueue();
+
+    const auto tail = queue.tail.load(std::memory_order_relaxed);
+    while((tail - queue.head.load(std::memory_order_acquire)) > queue.mask) {
+        if(this->config.overflow != LogOverflowPolicy::Block) {
+            if(this->config.overflow == LogOverflowPolicy::Count) {
+                queue.dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            gDroppedLogRecords.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        this->wakeWriter();
+        std::this_thread::yield();
+    }
+
+    auto &entry = queue.entries[tail & queue.mask];
+    entry.severity = record.getSeverity();
+    entry.func = record.getFunc();
+    entry.line = record.getLine();
+    entry.file = record.getFile();
+    entry.object = record.getObject();
+    entry.instanceId = record.getInstanceId();
+    entry.message = std::move(formatted);
+
+    queue.tail.store(tail + 1, std::memory_order_seq_cst);
+
+    if(this->writerSleeping.load(std::memory_order_seq_cst)) {
+        this->wakeWriter();
+    }
+}
+
+/**
+ * @brief Get the calling thread's queue, creating it if needed
+ */
+AsyncAppenderBase::Queue &AsyncAppenderBase::getQueue() {
+    for(auto &[id, queue] : gThreadQueues.queues) {
+        if(id == this->id) {
+            return *queue;
+        }
+    }
+
+    auto queue = std::make_shared<Queue>(this->config.queueDepth);
+    {
+        std::lock_guard lg(this->queuesLock);
+        this->queues.emplace_back(queue);
+    }
+
+    gThreadQueues.queues.emplace_back(this->id, queue);
+    return *queue;
+}
+
+/**
+ * @brief Wake the writer thread
+ */
+void AsyncAppenderBase::wakeWriter() {
+    {
+        std::lock_guard lg(this->sleepLock);
+    }
+    this->wakeCond.notify_one();
+}
+
+/**
+ * @brief Wait for all queued records to be written
+ *
+ * Blocks until the writer has drained all records that were queued before this call.
+ */
+void AsyncAppenderBase::flush() {
+    std::unique_lock ul(this->sleepLock);
+    const auto generation = ++this->flushRequested;
+
+    this->wakeCond.notify_one();
+    this->flushCond.wait(ul, [this, generation] {
+        return this->flushCompleted >= generation;
+    });
+}
+
+
+
+/**
+ * @brief Writer thread entry point
+ *
+ * Drain all queues until they're empty, then sleep until woken by a producer (or the idle
+ * interval elapses, to report drops and release queues of exited threads.)
+ */
+void AsyncAppenderBase::writerMain() {
+    while(true) {
+        // flushes requested up to here are complete once a drain finds nothing left to write
+        uint64_t requested;
+        {
+            std::lock_guard lg(this->sleepLock);
+            requested = this->flushRequested;
+        }
+
+        if(this->drain()) {
+            continue;
+        }
+
+        this->reportDrops();
+
+        std::unique_lock ul(this->sleepLock);
+
+        if(this->flushCompleted < requested) {
+            this->flushCompleted = requested;
+            this->flushCond.notify_all();
+        }
+
+        // flushes requested during the drain may be for records it missed: drain again
+        if(this->flushCompleted != this->flushRequested) {
+            continue;
+        }
+
+        if(this->shutdown) {
+            break;
+        }
+
+        // go to sleep, unless records were queued while we checked
+        this->writerSleeping.store(true, std::memory_order_seq_cst);
+
+        bool pending{false};
+        {
+            std::lock_guard lg(this->queuesLock);
+            pending = std::any_of(this->queues.begin(), this->queues.end(), [](const auto &queue) {
+                return queue->tail.load(std::memory_order_seq_cst) !=
+                    queue->head.load(std::memory_order_relaxed);
+            });
+        }
+
+        if(!pending) {
+            this->wakeCond.wait_for(ul, kWriterIdleInterval);
+        }
+
+        this->writerSleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Write all queued records
+ *
+ * @return Whether any records were written
+ */
+bool AsyncAppenderBase::drain() {
+    bool written{false};
+
+    std::lock_guard lg(this->queuesLock);
+
+    for(auto &queue : this->queues) {
+        auto head = queue->head.load(std::memory_order_relaxed);
+        const auto tail = queue->tail.load(std::memory_order_acquire);
+
+        while(head != tail) {
+            auto &entry = queue->entries[head & queue->mask];
+
+            plog::Record record(entry.severity, entry.func.c_str(), entry.line, entry.file,
+                    entry.object, entry.instanceId);
+            record << entry.message;
+            this->next->write(record);
+
+            entry.message.clear();
+            queue->head.store(++head, std::memory_order_release);
+            written = true;
+        }
+    }
+
+    // release the queues of threads that exited
+    std::erase_if(this->queues, [](const auto &queue) {
+        return queue->abandoned && queue->head == queue->tail;
+    });
+
+    return written;
+}
+
+/**
+ * @brief Report records dropped since the last call
+ *
+ * For queues with the counting overflow policy, a notice with the number of dropped records is
+ * written.
+ */
+void AsyncAppenderBase::reportDrops() {
+    if(this->config.overflow != LogOverflowPolicy::Count) {
+        return;
+    }
+
+    size_t dropped{0};
+    {
+        std::lock_guard lg(this->queuesLock);
+        for(auto &queue : this->queues) {
+            dropped += queue->dropped.exchange(0, std::memory_order_relaxed);
+        }
+    }
+
+    if(dropped) {
+        plog::Record notice(plog::Severity::warning, __FUNCTION__, __LINE__, __FILE__, nullptr, 0);
+        notice << dropped << " log records dropped (queue full)";
+
+        plog::Record record(plog::Severity::warning, __FUNCTION__, __LINE__, __FILE__, nullptr, 0);
+        record << this->formatNotice(notice);
+        this->next->write(record);
+    }
+}
@@ -0,0 +1,171 @@
+/**
+ * @file
+ *
+ * @brief Asynchronous output appender
+ *
+ * Formats records on the calling thread, then hands them to a background thread which passes them
+ * on to another appender.
+ */
+#ifndef ASYNCAPPENDER_H
+#define ASYNCAPPENDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+#include "FlushableAppender.h"
+#include "TristLib/Core/Logging.h"
+
+namespace TristLib::Core {
+/**
+ * @brief Background writer for asynchronous appenders
+ *
+ * Each thread that logs gets its own bounded, single producer single consumer queue of formatted
+ * records; a background thread drains all queues, and passes the records on to the wrapped
+ * appender. That appender must use a `PreformattedFormatter`.
+ */
+class AsyncAppenderBase: public FlushableAppender {
+    private:
+        /**
+         * @brief A single formatted record
+         */
+        struct Entry {
+            plog::Severity severity;
+            /// Function name; copied, since the record only holds it for the log statement
+            std::string func;
+            size_t line;
+            const char *file;
+            const void *object;
+            int instanceId;
+
+            /// Formatted message
+            plog::util::nstring message;
+        };
+
+        /**
+         * @brief Per thread record queue
+         */
+        struct Queue {
+            Queue(const size_t capacity);
+
+            /// Storage for records; its size is a power of two
+            std::unique_ptr<Entry[]> entries;
+            /// Mask to apply to a position to get an index into `entries`
+            const size_t mask;
+
+            /// Next position to write (written by the producer)
+            alignas(64) std::atomic<size_t> tail{0};
+            /// Next position to read (written by the writer thread)
+            alignas(64) std::atomic<size_t> head{0};
+
+            /// Number of records dropped since the last report
+            std::atomic<size_t> dropped{0};
+            /// Set once the producing thread has exited
+            std::atomic_bool abandoned{false};
+        };
+
+        /**
+         * @brief Queues owned by the calling thread
+         *
+         * On thread exit, all of its queues are marked as abandoned, so the writer can release
+         * them once drained.
+         */
+        struct ThreadQueues {
+            ~ThreadQueues();
+
+            /// Appender id and queue pairs
+            std::vector<std::pair<uint64_t, std::shared_ptr<Queue>>> queues;
+        };
+
+    public:
+        AsyncAppenderBase(plog::IAppender *next, const AsyncLogConfig &config);
+        ~AsyncAppenderBase() override;
+
+        void flush() override;
+
+    protected:
+        void enqueue(const plog::Record &record, plog::util::nstring &&formatted);
+
+        /**
+         * @brief Format a record generated by the appender itself
+         */
+        virtual plog::util::nstring formatNotice(const plog::Record &record) = 0;
+
+    private:
+        Queue &getQueue();
+        void wakeWriter();
+
+        void writerMain();
+        bool drain();
+        void reportDrops();
+
+    private:
+        static thread_local ThreadQueues gThreadQueues;
+
+        /// Unique identifier of this appender
+        const uint64_t id;
+        /// Appender to pass records on to
+        std::unique_ptr<plog::IAppender> next;
+        /// Configuration
+        const AsyncLogConfig config;
+
+        /// Lock protecting the list of queues
+        std::mutex queuesLock;
+        /// All queues
+        std::vector<std::shared_ptr<Queue>> queues;
+
+        /// Lock for the writer to sleep on
+        std::mutex sleepLock;
+        /// Condition signalled to wake the writer
+        std::condition_variable wakeCond;
+        /// Condition signalled when the writer completes a flush
+        std::condition_variable flushCond;
+        /// Set while the writer is waiting for records
+        std::atomic_bool writerSleeping{false};
+        /// Most recently requested flush
+        uint64_t flushRequested{0};
+        /// Most recently completed flush
+        uint64_t flushCompleted{0};
+        /// Set to request the writer to exit
+        bool shutdown{false};
+
+        /// Background writer thread
+        std::thread writer;
+};
+
+/**
+ * @brief plog Appender that writes records in the background
+ *
+ * Records are formatted with `Formatter` on the calling thread; the wrapped appender (which must
+ * be set up with `PreformattedFormatter<Formatter>`) is invoked on a background thread.
+ */
+template<class Formatter>
+class AsyncAppender: public AsyncAppenderBase {
+    public:
+        AsyncAppender(plog::IAppender *next, const AsyncLogConfig &config) :
+            AsyncAppenderBase(next, config) {}
+
+        /**
+         * @brief Format message and queue it for output
+         */
+        void write(const plog::Record &record) override {
+            this->enqueue(record, Formatter::format(record));
+        }
+
+    protected:
+        plog::util::nstring formatNotice(const plog::Record &record) override {
+            return Formatter::format(record);
+        }
+};
+}
+
+#endif
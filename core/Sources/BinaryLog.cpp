@@ -0,0 +1,264 @@
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+
+#include "BinaryLogAppender.h"
+#include "TristLib/Core/BinaryLog.h"
+
+using namespace TristLib::Core;
+
+/**
+ * @brief All registered binary log appenders
+ */
+static std::atomic<BinaryLogAppender *> gAppenders[BinaryLogAppender::kMaxAppenders];
+/**
+ * @brief Number of registered binary log appenders
+ */
+static std::atomic<size_t> gNumAppenders{0};
+
+/**
+ * @brief Lock serializing registration of call sites
+ */
+static std::mutex gSitesLock;
+/**
+ * @brief Identifier to assign to the next call site
+ */
+static uint32_t gNextSiteId{1};
+
+
+
+/**
+ * @brief Get the current time, in nanoseconds since the UNIX epoch
+ */
+static inline uint64_t GetTimestamp() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Get the calling thread's id
+ */
+static inline uint64_t GetThreadId() {
+    static thread_local const uint64_t gTid = plog::util::gettid();
+    return gTid;
+}
+
+/**
+ * @brief Check whether binary records of the given severity are logged
+ *
+ * @param severity Severity of the record
+ */
+bool BinaryLog::IsEnabled(const plog::Severity severity) noexcept {
+    if(!gNumAppenders.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    return plog::get() && severity <= Core::detail::gLogSeverity.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Write an encoded record to all binary log destinations
+ *
+ * Assigns the call site its identifier, if this is the first record logged there.
+ *
+ * @param site Call site of the record
+ * @param args CBOR array of the record's arguments
+ */
+void BinaryLog::Submit(BinaryLogSite &site, std::span<const std::byte> args) {
+    if(!site.id.load(std::memory_order_acquire)) {
+        std::lock_guard lg(gSitesLock);
+        if(!site.id.load(std::memory_order_relaxed)) {
+            site.id.store(gNextSiteId++, std::memory_order_release);
+        }
+    }
+
+    const auto timestamp = GetTimestamp();
+    const auto tid = GetThreadId();
+
+    const auto numAppenders = gNumAppenders.load(std::memory_order_acquire);
+    for(size_t i = 0; i < numAppenders; i++) {
+        gAppenders[i].load(std::memory_order_relaxed)->writeEvent(site, timestamp, tid, args);
+    }
+}
+
+
+
+/**
+ * @brief Open a binary log file
+ *
+ * The file is created if needed, and new records are appended to it. A header record is written
+ * at the start of each session.
+ *
+ * @param path Path to the log file
+ */
+BinaryLogAppender::BinaryLogAppender(const std::filesystem::path &path) {
+    this->fd = open(path.native().c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(this->fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "open binary log");
+    }
+
+    this->buffer.reserve(kFlushThreshold * 2);
+
+    CborVectorSink sink(this->buffer);
+    CborWriter writer(sink);
+
+    writer.beginArray(3);
+    writer.writeUint(BinaryLog::RecordType::Header);
+    writer.writeString(BinaryLog::kMagic);
+    writer.writeUint(BinaryLog::kVersion);
+}
+
+/**
+ * @brief Write any buffered records and close the file
+ */
+BinaryLogAppender::~BinaryLogAppender() {
+    this->flush();
+    close(this->fd);
+}
+
+/**
+ * @brief Register an appender to receive binary records
+ *
+ * @param appender Appender to register; it may never be deallocated
+ */
+void BinaryLogAppender::Register(BinaryLogAppender *appender) {
+    static std::mutex gRegisterLock;
+    std::lock_guard lg(gRegisterLock);
+
+    const auto index = gNumAppenders.load(std::memory_order_relaxed);
+    if(index == kMaxAppenders) {
+        throw std::runtime_error("too many binary log destinations");
+    }
+
+    gAppenders[index].store(appender, std::memory_order_relaxed);
+    gNumAppenders.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Write a regular (preformatted) record
+ */
+void BinaryLogAppender::write(const plog::Record &record) {
+    const auto &time = record.getTime();
+    const uint64_t timestamp = (static_cast<uint64_t>(time.time) * 1'000'000'000ULL) +
+        (static_cast<uint64_t>(time.millitm) * 1'000'000ULL);
+
+    std::lock_guard lg(this->lock);
+
+    CborVectorSink sink(this->buffer);
+    CborWriter writer(sink);
+
+    writer.beginArray(7);
+    writer.writeUint(BinaryLog::RecordType::Text);
+    writer.writeUint(timestamp);
+    writer.writeUint(record.getSeverity());
+    writer.writeUint(record.getTid());
+    writer.writeString(record.getFunc());
+    writer.writeUint(record.getLine());
+    writer.writeString(record.getMessage());
+
+    if(this->buffer.size() >= kFlushThreshold) {
+        this->flushLocked();
+    }
+}
+
+/**
+ * @brief Write a deferred record
+ *
+ * If this is the first record from this site to be written to the file, the site definition is
+ * written first.
+ *
+ * @param site Call site of the record (which must have been assigned an identifier)
+ * @param timestamp Time at which the record was logged (nanoseconds since the UNIX epoch)
+ * @param tid Thread that logged the record
+ * @param args Encoded arguments
+ */
+void BinaryLogAppender::writeEvent(BinaryLogSite &site, const uint64_t timestamp,
+        const uint64_t tid, std::span<const std::byte> args) {
+    const auto id = site.id.load(std::memory_order_relaxed);
+
+    std::lock_guard lg(this->lock);
+
+    if(id >= this->sitesWritten.size() || !this->sitesWritten[id]) {
+        this->writeSite(site);
+    }
+
+    CborVectorSink sink(this->buffer);
+    CborWriter writer(sink);
+
+    writer.beginArray(5);
+    writer.writeUint(BinaryLog::RecordType::Event);
+    writer.writeUint(id);
+    writer.writeUint(timestamp);
+    writer.writeUint(tid);
+    this->buffer.insert(this->buffer.end(), args.begin(), args.end());
+
+    if(this->buffer.size() >= kFlushThreshold) {
+        this->flushLocked();
+    }
+}
+
+/**
+ * @brief Write a call site definition
+ *
+ * @remark The lock must be held.
+ */
+void BinaryLogAppender::writeSite(const BinaryLogSite &site) {
+    const auto id = site.id.load(std::memory_order_relaxed);
+
+    CborVectorSink sink(this->buffer);
+    CborWriter writer(sink);
+
+    writer.beginArray(7);
+    writer.writeUint(BinaryLog::RecordType::Site);
+    writer.writeUint(id);
+    writer.writeUint(site.severity);
+    writer.writeString(site.file);
+    writer.writeUint(site.line);
+    writer.writeString(site.func);
+    writer.writeString(site.format);
+
+    if(id >= this->sitesWritten.size()) {
+        this->sitesWritten.resize(id + 1);
+    }
+    this->sitesWritten[id] = true;
+}
+
+/**
+ * @brief Write all buffered records to the file
+ */
+void BinaryLogAppender::flush() {
+    std::lock_guard lg(this->lock);
+    this->flushLocked();
+}
+
+/**
+ * @brief Write all buffered records to the file
+ *
+ * @remark The lock must be held.
+ */
+void BinaryLogAppender::flushLocked() {
+    size_t written{0};
+
+    while(written < this->buffer.size()) {
+        const auto ret = ::write(this->fd, this->buffer.data() + written,
+                this->buffer.size() - written);
+        if(ret == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            // nothing sensible we can do here; discard the records
+            break;
+        }
+
+        written += ret;
+    }
+
+    this->buffer.clear();
+}
@@ -0,0 +1,66 @@
+/**
+ * @file
+ *
+ * @brief Binary log output appender
+ *
+ * Writes deferred (binary) records, as well as regular plog records, to a CBOR sequence file.
+ */
+#ifndef BINARYLOGAPPENDER_H
+#define BINARYLOGAPPENDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+#include "FlushableAppender.h"
+#include "TristLib/Core/BinaryLog.h"
+
+namespace TristLib::Core {
+/**
+ * @brief plog Appender writing a binary log file
+ *
+ * Records are encoded into an in-memory buffer, which is written to the file once it fills up,
+ * or when the appender is flushed.
+ */
+class BinaryLogAppender: public FlushableAppender {
+    public:
+        /// Number of buffered bytes at which the buffer is written to the file
+        constexpr static const size_t kFlushThreshold{64 * 1024};
+        /// Maximum number of binary log destinations
+        constexpr static const size_t kMaxAppenders{8};
+
+    public:
+        BinaryLogAppender(const std::filesystem::path &path);
+        ~BinaryLogAppender() override;
+
+        static void Register(BinaryLogAppender *appender);
+
+        void write(const plog::Record &record) override;
+        void writeEvent(BinaryLogSite &site, const uint64_t timestamp, const uint64_t tid,
+                std::span<const std::byte> args);
+        void flush() override;
+
+    private:
+        void writeSite(const BinaryLogSite &site);
+        void flushLocked();
+
+    private:
+        /// File descriptor of the log file
+        int fd{-1};
+
+        /// Lock protecting the buffer and site state
+        std::mutex lock;
+        /// Encoded records not yet written to the file
+        std::vector<std::byte> buffer;
+        /// Identifiers of sites that have been written to the file
+        std::vector<bool> sitesWritten;
+};
+}
+
+#endif
@@ -0,0 +1,463 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef CONFIG_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "BufferedFileAppender.h"
+
+using namespace TristLib::Core;
+
+#ifdef CONFIG_WITH_ZLIB
+/**
+ * @brief Compress a file with gzip
+ *
+ * @param inFd File descriptor of the file to compress (read from the start)
+ * @param outPath Path to write the compressed file to
+ *
+ * @return Whether the file was compressed successfully
+ */
+static bool CompressFile(const int inFd, const std::filesystem::path &outPath) {
+    if(lseek(inFd, 0, SEEK_SET) == -1) {
+        return false;
+    }
+
+    int outFd = open(outPath.native().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(outFd == -1) {
+        return false;
+    }
+
+    auto gz = gzdopen(outFd, "wb");
+    if(!gz) {
+        close(outFd);
+        unlink(outPath.native().c_str());
+        return false;
+    }
+
+    char buf[64 * 1024];
+    bool success{true};
+
+    while(true) {
+        const auto nRead = read(inFd, buf, sizeof(buf));
+        if(nRead == -1 && errno == EINTR) {
+            continue;
+        } else if(nRead <= 0) {
+            success = (nRead == 0);
+            break;
+        }
+
+        if(gzwrite(gz, buf, static_cast<unsigned int>(nRead)) != nRead) {
+            success = false;
+            break;
+        }
+    }
+
+    if(gzclose(gz) != Z_OK) {
+        success = false;
+    }
+    if(!success) {
+        unlink(outPath.native().c_str());
+    }
+
+    return success;
+}
+#endif
+
+
+
+/**
+ * @brief Open the log file and start the background worker
+ *
+ * @param path Path to the log file; records are appended to it if it exists
+ * @param config File configuration
+ * @param header Header to write at the start of each new file
+ */
+BufferedFileAppenderBase::BufferedFileAppenderBase(const std::filesystem::path &path,
+        const FileLogConfig &config, const std::string_view header) : path(path),
+    config(config), header(header) {
+    // allocate buffers
+    size_t bufferSize = std::max(config.bufferSize / kNumBuffers, kBufferAlignment);
+    bufferSize = (bufferSize + kBufferAlignment - 1) & ~(kBufferAlignment - 1);
+
+    this->buffers.resize(kNumBuffers);
+    for(auto &buffer : this->buffers) {
+        buffer.data.reset(static_cast<char *>(aligned_alloc(kBufferAlignment, bufferSize)));
+        if(!buffer.data) {
+            throw std::bad_alloc();
+        }
+    }
+    this->bufferSize = bufferSize;
+    this->iov.reserve(kNumBuffers + 1);
+
+    // open the file
+    if(!this->openFile()) {
+        throw std::system_error(errno, std::generic_category(), "open log file");
+    }
+
+    this->worker = std::thread(&BufferedFileAppenderBase::workerMain, this);
+}
+
+/**
+ * @brief Write all records, and close the file
+ *
+ * Waits for the worker to finish processing any rotated files.
+ */
+BufferedFileAppenderBase::~BufferedFileAppenderBase() {
+    {
+        std::lock_guard lg(this->lock);
+        this->shutdown = true;
+    }
+    this->workCond.notify_all();
+    this->worker.join();
+
+    this->writeBuffers();
+
+    // release space preallocated past the end of the file
+    struct stat sb;
+    if(!fstat(this->fd, &sb)) {
+        [[maybe_unused]] auto ret = ftruncate(this->fd, sb.st_size);
+    }
+    close(this->fd);
+}
+
+/**
+ * @brief Write all buffered records to the file
+ *
+ * Additionally, wait for any previously rotated files to be processed.
+ */
+void BufferedFileAppenderBase::flush() {
+    std::unique_lock lg(this->lock);
+    this->writeBuffers();
+
+    this->idleCond.wait(lg, [&] {
+        return this->rotated.empty() && !this->processing;
+    });
+}
+
+/**
+ * @brief Append a formatted record to the file
+ *
+ * The record is copied into the current buffer; if all buffers are full, they're written out
+ * first. If the file exceeds its maximum size, it's rotated.
+ *
+ * @param str Formatted record
+ */
+void BufferedFileAppenderBase::append(std::string_view str) {
+    std::lock_guard lg(this->lock);
+
+    if(this->config.maxFileSize && this->config.maxFiles && this->fileSize &&
+            (this->fileSize + str.size()) > this->config.maxFileSize) {
+        this->writeBuffers();
+        this->rotate();
+    }
+
+    this->appendLocked(str);
+}
+
+/**
+ * @brief Append data to the buffers
+ *
+ * @remark The lock must be held.
+ */
+void BufferedFileAppenderBase::appendLocked(std::string_view str) {
+    this->fileSize += str.size();
+
+    auto *buffer = &this->buffers[this->currentBuffer];
+    if(str.size() > this->bufferSize - buffer->used) {
+        // advance to the next buffer, or write everything (including this record) out
+        if(str.size() <= this->bufferSize && this->currentBuffer + 1 < kNumBuffers) {
+            buffer = &this->buffers[++this->currentBuffer];
+        } else {
+            this->writeBuffers(str);
+            str = {};
+        }
+    }
+
+    if(!str.empty()) {
+        memcpy(buffer->data.get() + buffer->used, str.data(), str.size());
+        buffer->used += str.size();
+    }
+
+    if(this->fileSize > this->allocatedSize) {
+        this->preallocate();
+    }
+}
+
+/**
+ * @brief Open the log file
+ *
+ * If the file is empty, the header is written to it. Space for the file is preallocated. It's
+ * opened for reading as well, so it can be compressed once rotated.
+ *
+ * @remark The lock must be held (unless called from the constructor)
+ *
+ * @return Whether the file was opened; on failure, `errno` is set.
+ */
+bool BufferedFileAppenderBase::openFile() {
+    int newFd = open(this->path.native().c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC,
+            0644);
+    if(newFd == -1) {
+        return false;
+    }
+
+    struct stat sb;
+    if(fstat(newFd, &sb)) {
+        const auto err = errno;
+        close(newFd);
+        errno = err;
+        return false;
+    }
+
+    this->fd = newFd;
+    this->fileSize = sb.st_size;
+    this->allocatedSize = sb.st_size;
+
+    if(!this->fileSize && !this->header.empty()) {
+        this->appendLocked(this->header);
+    }
+    this->preallocate();
+
+    return true;
+}
+
+/**
+ * @brief Preallocate space for the log file
+ *
+ * Rotated files get their entire maximum size allocated up front; otherwise, space is allocated
+ * in fixed increments as the file grows. The file's size is not changed.
+ *
+ * @remark The lock must be held.
+ */
+void BufferedFileAppenderBase::preallocate() {
+    size_t target;
+    if(this->config.maxFileSize && this->config.maxFiles) {
+        target = std::max(this->config.maxFileSize, this->fileSize);
+    } else {
+        target = this->fileSize + kPreallocateSize;
+    }
+
+    if(target <= this->allocatedSize) {
+        return;
+    }
+
+    // failure is not fatal (the filesystem may not support it)
+    fallocate(this->fd, FALLOC_FL_KEEP_SIZE, this->allocatedSize,
+            target - this->allocatedSize);
+    this->allocatedSize = target;
+}
+
+/**
+ * @brief Write all buffered records to the file
+ *
+ * @param extra Additional data to write after the buffered records
+ *
+ * @remark The lock must be held.
+ */
+void BufferedFileAppenderBase::writeBuffers(std::string_view extra) {
+    this->iov.clear();
+    for(size_t i = 0; i <= this->currentBuffer; i++) {
+        auto &buffer = this->buffers[i];
+        if(buffer.used) {
+            this->iov.push_back({buffer.data.get(), buffer.used});
+        }
+    }
+    if(!extra.empty()) {
+        this->iov.push_back({const_cast<char *>(extra.data()), extra.size()});
+    }
+
+    // write it out, handling partial writes
+    auto *vec = this->iov.data();
+    size_t count = this->iov.size();
+
+    while(count) {
+        const auto written = writev(this->fd, vec, static_cast<int>(count));
+        if(written == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            // nothing sensible we can do here; discard the records
+            break;
+        }
+
+        size_t remaining = written;
+        while(count && remaining >= vec->iov_len) {
+            remaining -= vec->iov_len;
+            vec++;
+            count--;
+        }
+        if(count) {
+            vec->iov_base = static_cast<char *>(vec->iov_base) + remaining;
+            vec->iov_len -= remaining;
+        }
+    }
+
+    for(auto &buffer : this->buffers) {
+        buffer.used = 0;
+    }
+    this->currentBuffer = 0;
+
+    if(!this->iov.empty() && this->config.sync == LogFileSync::Always) {
+        fdatasync(this->fd);
+    }
+}
+
+/**
+ * @brief Rotate the log file
+ *
+ * The current file is renamed to a temporary name, and a new file is opened; the worker will
+ * then sync, compress and move the old file into place.
+ *
+ * @remark The lock must be held, and all buffered records must have been written.
+ */
+void BufferedFileAppenderBase::rotate() {
+    auto staged = this->path;
+    staged += ".rotating." + std::to_string(this->rotations++);
+
+    if(rename(this->path.native().c_str(), staged.native().c_str())) {
+        return;
+    }
+
+    // open a new file; if that fails, keep using the current one
+    const auto oldFd = this->fd;
+    const auto oldSize = this->fileSize, oldAllocated = this->allocatedSize;
+
+    if(!this->openFile()) {
+        rename(staged.native().c_str(), this->path.native().c_str());
+
+        this->fd = oldFd;
+        this->fileSize = oldSize;
+        this->allocatedSize = oldAllocated;
+        return;
+    }
+
+    this->rotated.push_back({oldFd, std::move(staged)});
+    this->workCond.notify_one();
+}
+
+/**
+ * @brief Background worker
+ *
+ * Periodically writes out buffered records, and processes rotated files.
+ */
+void BufferedFileAppenderBase::workerMain() {
+    std::unique_lock lg(this->lock);
+
+    while(true) {
+        this->workCond.wait_for(lg, this->config.flushInterval, [&] {
+            return this->shutdown || !this->rotated.empty();
+        });
+
+        this->writeBuffers();
+
+        const auto syncFd = this->fd;
+        auto files = std::move(this->rotated);
+        this->rotated.clear();
+        this->processing = !files.empty();
+
+        // sync and process files without holding the lock
+        lg.unlock();
+
+        if(this->config.sync == LogFileSync::Periodic) {
+            fdatasync(syncFd);
+        }
+        for(auto &file : files) {
+            this->processRotated(file);
+        }
+
+        lg.lock();
+        this->processing = false;
+        this->idleCond.notify_all();
+
+        if(this->shutdown) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Process a rotated file
+ *
+ * Sync the file (if required), compress it (if enabled), then shift all older files by one and
+ * move it into the first slot.
+ *
+ * @param file Rotated file; its file descriptor is closed
+ */
+void BufferedFileAppenderBase::processRotated(RotatedFile &file) {
+    std::error_code ec;
+
+    if(this->config.sync != LogFileSync::Never) {
+        fdatasync(file.fd);
+    }
+
+    // release space preallocated past the end of the file
+    struct stat sb;
+    if(!fstat(file.fd, &sb)) {
+        [[maybe_unused]] auto ret = ftruncate(file.fd, sb.st_size);
+    }
+
+    bool compressed{false};
+    auto compressedPath = this->getRotatedName(1, true);
+    compressedPath += ".tmp";
+
+#ifdef CONFIG_WITH_ZLIB
+    if(this->config.compress && this->config.maxFiles > 1) {
+        compressed = CompressFile(file.fd, compressedPath);
+    }
+#endif
+
+    close(file.fd);
+
+    if(this->config.maxFiles <= 1) {
+        std::filesystem::remove(file.path, ec);
+        return;
+    }
+
+    // shift older files, discarding the oldest
+    for(const bool gz : {false, true}) {
+        std::filesystem::remove(this->getRotatedName(this->config.maxFiles - 1, gz), ec);
+
+        for(size_t i = this->config.maxFiles - 2; i >= 1; i--) {
+            std::filesystem::rename(this->getRotatedName(i, gz), this->getRotatedName(i + 1, gz),
+                    ec);
+        }
+    }
+
+    // move the rotated file into place
+    if(compressed) {
+        std::filesystem::rename(compressedPath, this->getRotatedName(1, true), ec);
+        std::filesystem::remove(file.path, ec);
+    } else {
+        std::filesystem::rename(file.path, this->getRotatedName(1, false), ec);
+    }
+}
+
+/**
+ * @brief Get the name of a rotated log file
+ *
+ * The index is inserted before the extension, the same as plog's rolling file appender: for
+ * example, `app.log` is rotated to `app.1.log`, `app.2.log`, and so forth.
+ *
+ * @param index Index of the file (1 is the most recently rotated file)
+ * @param compressed Whether to get the compressed file's name
+ */
+std::filesystem::path BufferedFileAppenderBase::getRotatedName(const size_t index,
+        const bool compressed) const {
+    auto name = this->path.stem();
+    name += "." + std::to_string(index);
+    name += this->path.extension();
+    if(compressed) {
+        name += ".gz";
+    }
+
+    return this->path.parent_path() / name;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file
+ *
+ * @brief Buffered rolling file appender
+ *
+ * Collects formatted records in memory, and writes them to a log file in large batches. Rotated
+ * files are synced and compressed on a background thread.
+ */
+#ifndef BUFFEREDFILEAPPENDER_H
+#define BUFFEREDFILEAPPENDER_H
+
+#include <sys/uio.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+#include "FlushableAppender.h"
+#include "TristLib/Core/Logging.h"
+
+namespace TristLib::Core {
+/**
+ * @brief Buffered log file writer
+ *
+ * Records are copied into one of several page-aligned buffers; once all of them are full, they
+ * are written to the file with a single `writev()` call. A background thread writes out partially
+ * filled buffers periodically, and processes rotated files.
+ *
+ * Rotation on the logging thread only renames the current file to a temporary name and opens a
+ * new one: the background thread then syncs the old file, compresses it (if enabled) and moves
+ * it into place, shifting the older files.
+ */
+class BufferedFileAppenderBase: public FlushableAppender {
+    public:
+        /// Alignment of record buffers
+        constexpr static const size_t kBufferAlignment{4096};
+        /// Number of record buffers
+        constexpr static const size_t kNumBuffers{4};
+        /// Amount of space preallocated at a time, for files that aren't rotated
+        constexpr static const size_t kPreallocateSize{8 * 1024 * 1024};
+
+    private:
+        /// Page aligned record buffer
+        struct Buffer {
+            std::unique_ptr<char, decltype(&free)> data{nullptr, &free};
+            size_t used{0};
+        };
+
+        /// A rotated file waiting to be processed
+        struct RotatedFile {
+            /// File descriptor, still open
+            int fd;
+            /// Temporary name of the file
+            std::filesystem::path path;
+        };
+
+    public:
+        BufferedFileAppenderBase(const std::filesystem::path &path, const FileLogConfig &config,
+                const std::string_view header);
+        ~BufferedFileAppenderBase() override;
+
+        void flush() override;
+
+    protected:
+        void append(std::string_view str);
+
+    private:
+        void appendLocked(std::string_view str);
+        bool openFile();
+        void preallocate();
+        void writeBuffers(std::string_view extra = {});
+        void rotate();
+
+        void workerMain();
+        void processRotated(RotatedFile &file);
+        std::filesystem::path getRotatedName(const size_t index, const bool compressed) const;
+
+    private:
+        /// Path to the current log file
+        const std::filesystem::path path;
+        /// Configuration
+        const FileLogConfig config;
+        /// Header written at the start of each file
+        const std::string header;
+
+        /// Lock protecting the file and buffers
+        std::mutex lock;
+        /// Current log file
+        int fd{-1};
+        /// Size of the current log file, including buffered records
+        size_t fileSize{0};
+        /// Amount of space allocated for the file
+        size_t allocatedSize{0};
+        /// Record buffers
+        std::vector<Buffer> buffers;
+        /// Size of each record buffer
+        size_t bufferSize;
+        /// Index of the buffer currently being filled
+        size_t currentBuffer{0};
+        /// IO vectors for writing the buffers
+        std::vector<struct iovec> iov;
+        /// Number of rotations so far (used for temporary file names)
+        uint64_t rotations{0};
+
+        /// Files waiting to be processed by the worker
+        std::vector<RotatedFile> rotated;
+        /// Set while the worker is processing rotated files
+        bool processing{false};
+        /// Signalled to wake the worker
+        std::condition_variable workCond;
+        /// Signalled when the worker finishes processing rotated files
+        std::condition_variable idleCond;
+        /// Set to request the worker to exit
+        bool shutdown{false};
+
+        /// Background worker thread
+        std::thread worker;
+};
+
+/**
+ * @brief plog Appender writing to a buffered, rolling log file
+ */
+template<class Formatter>
+class BufferedFileAppender: public BufferedFileAppenderBase {
+    public:
+        BufferedFileAppender(const std::filesystem::path &path, const FileLogConfig &config) :
+            BufferedFileAppenderBase(path, config, Formatter::header()) {}
+
+        /**
+         * @brief Format message and buffer it
+         */
+        void write(const plog::Record &record) override {
+            this->append(Formatter::format(record));
+        }
+};
+}
+
+#endif
@@ -0,0 +1,431 @@
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+#include "TristLib/Core/CborJson.h"
+#include "TristLib/Core/Utf8.h"
+
+using namespace TristLib::Core;
+
+namespace {
+/**
+ * @brief Escape sequences for each byte
+ *
+ * Zero if the byte is written as is, `u` if it's written as `\u00XX`, or the character following
+ * the backslash otherwise.
+ */
+constexpr auto kEscapes = []() {
+    std::array<char, 256> table{};
+    for(size_t i = 0; i < 0x20; i++) {
+        table[i] = 'u';
+    }
+    table['\b'] = 'b';
+    table['\t'] = 't';
+    table['\n'] = 'n';
+    table['\f'] = 'f';
+    table['\r'] = 'r';
+    table['"'] = '"';
+    table['\\'] = '\\';
+    return table;
+}();
+
+/// Alphabet for base64url encoding (RFC 4648, section 5)
+constexpr std::string_view kBase64Alphabet{
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"};
+
+/**
+ * @brief Find the first byte in a string that must be escaped
+ *
+ * @return Offset of the byte, or the length of the string if there is none
+ */
+size_t FindEscape(const char *data, const size_t length) {
+    size_t i{0};
+
+#if defined(__x86_64__)
+    // check 16 bytes at a time: quotes, backslashes and control characters (<= 0x1F)
+    const auto quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'),
+          control = _mm_set1_epi8(0x1F);
+
+    for(; i + 16 <= length; i += 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const auto special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+
+        if(const int mask = _mm_movemask_epi8(special)) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for(; i < length; i++) {
+        if(kEscapes[static_cast<uint8_t>(data[i])]) {
+            return i;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief Write a string as a quoted and escaped JSON string
+ *
+ * Runs of bytes that don't need escaping are copied as a whole.
+ */
+void WriteEscaped(std::string &out, std::string_view str) {
+    out.push_back('"');
+
+    while(!str.empty()) {
+        const auto run = FindEscape(str.data(), str.size());
+        out.append(str.data(), run);
+        if(run == str.size()) {
+            break;
+        }
+
+        const auto byte = static_cast<uint8_t>(str[run]);
+        const char escape = kEscapes[byte];
+
+        if(escape == 'u') {
+            constexpr std::string_view kHex{"0123456789abcdef"};
+            const char sequence[6]{'\\', 'u', '0', '0', kHex[byte >> 4], kHex[byte & 0xF]};
+            out.append(sequence, sizeof(sequence));
+        } else {
+            const char sequence[2]{'\\', escape};
+            out.append(sequence, sizeof(sequence));
+        }
+
+        str.remove_prefix(run + 1);
+    }
+
+    out.push_back('"');
+}
+
+/**
+ * @brief Write bytes as a quoted base64url string, without padding
+ */
+void WriteBase64(std::string &out, std::string_view data) {
+    const auto start = out.size();
+    out.resize(start + 2 + (data.size() * 4 + 2) / 3);
+
+    auto dest = out.data() + start;
+    auto src = reinterpret_cast<const uint8_t *>(data.data());
+    size_t remaining = data.size();
+
+    *dest++ = '"';
+    for(; remaining >= 3; remaining -= 3, src += 3) {
+        const uint32_t triple = (src[0] << 16) | (src[1] << 8) | src[2];
+        *dest++ = kBase64Alphabet[(triple >> 18) & 0x3F];
+        *dest++ = kBase64Alphabet[(triple >> 12) & 0x3F];
+        *dest++ = kBase64Alphabet[(triple >> 6) & 0x3F];
+        *dest++ = kBase64Alphabet[triple & 0x3F];
+    }
+    if(remaining) {
+        const uint32_t triple = (src[0] << 16) | ((remaining == 2) ? (src[1] << 8) : 0);
+        *dest++ = kBase64Alphabet[(triple >> 18) & 0x3F];
+        *dest++ = kBase64Alphabet[(triple >> 12) & 0x3F];
+        if(remaining == 2) {
+            *dest++ = kBase64Alphabet[(triple >> 6) & 0x3F];
+        }
+    }
+    *dest = '"';
+}
+
+/**
+ * @brief Append a value formatted with `std::to_chars()`
+ */
+template<typename T>
+void WriteChars(std::string &out, const T value) {
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+}
+
+
+
+/**
+ * @brief Convert the given data
+ *
+ * @param data Next segment of the CBOR input
+ *
+ * All complete items in the input are converted; if the segment ends in the middle of an item,
+ * the rest of it is read from the next segment.
+ */
+void CborJsonTranscoder::feed(std::span<const std::byte> data) {
+    this->reader.feed(data);
+
+    while(true) {
+        const auto item = this->reader.next();
+        if(item.type == CborReader::Type::NeedMore) {
+            break;
+        }
+        this->writeItem(item);
+    }
+}
+
+/**
+ * @brief Write the separator preceding an item
+ *
+ * This is a comma between items in arrays (and between key/value pairs in maps), a colon
+ * between a key and its value, or a newline between top level items.
+ */
+void CborJsonTranscoder::writeSeparator(const CborReader::Item &item) {
+    // separator was written before the item's tag
+    if(std::exchange(this->separated, false)) {
+        return;
+    }
+
+    if(!item.depth) {
+        if(std::exchange(this->wroteItem, true)) {
+            this->output.push_back('\n');
+        }
+        return;
+    }
+
+    const auto index = item.depth - 1;
+    if(this->containers[index] == Container::Map && !item.isKey) {
+        this->output.push_back(':');
+    } else if(!std::exchange(this->first[index], false)) {
+        this->output.push_back(',');
+    }
+}
+
+/**
+ * @brief Convert a single item produced by the reader
+ */
+void CborJsonTranscoder::writeItem(const CborReader::Item &item) {
+    using Type = CborReader::Type;
+
+    // chunk of an indefinite length string
+    if(item.depth && this->containers[item.depth - 1] == Container::String) {
+        this->scratch.append(item.getString());
+        return;
+    }
+    // remainder of a definite length string that was split across input segments
+    if(this->inString) {
+        this->scratch.append(item.getString());
+        if(!item.partial) {
+            this->inString = false;
+            this->writeString(item.type, this->scratch);
+        }
+        return;
+    }
+
+    if(item.type == Type::End) {
+        switch(this->containers[item.depth]) {
+            case Container::Array:
+                this->output.push_back(']');
+                break;
+            case Container::Map:
+                this->output.push_back('}');
+                break;
+            case Container::String:
+                this->writeString(this->stringType, this->scratch);
+                break;
+        }
+        return;
+    }
+
+    this->writeSeparator(item);
+    const auto tag = std::exchange(this->tag, 0);
+
+    switch(item.type) {
+        case Type::Tag:
+            this->tag = item.value;
+            this->separated = true;
+            break;
+
+        case Type::ArrayStart:
+        case Type::MapStart:
+            if(item.isKey) {
+                throw std::runtime_error("unsupported CBOR map key");
+            }
+            this->containers[item.depth] = (item.type == Type::MapStart) ? Container::Map :
+                Container::Array;
+            this->first[item.depth] = true;
+            this->output.push_back((item.type == Type::MapStart) ? '{' : '[');
+            break;
+
+        case Type::ByteString:
+        case Type::TextString:
+            if(item.value == CborReader::kIndefinite) {
+                this->containers[item.depth] = Container::String;
+                this->stringType = item.type;
+                this->scratch.clear();
+            } else if(item.partial) {
+                this->inString = true;
+                this->scratch.assign(item.getString());
+            } else {
+                this->writeString(item.type, item.getString());
+            }
+            break;
+
+        case Type::Unsigned:
+        case Type::Negative:
+        case Type::Float:
+            if(tag == 1) {
+                this->writeTimestamp(item);
+            } else {
+                this->writeNumber(item);
+            }
+            break;
+
+        default:
+            if(item.isKey) {
+                this->output.push_back('"');
+            }
+            if(item.type == Type::Bool) {
+                this->output.append(item.value ? "true" : "false");
+            } else {
+                this->output.append("null");
+            }
+            if(item.isKey) {
+                this->output.push_back('"');
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Write a complete text or byte string
+ */
+void CborJsonTranscoder::writeString(const CborReader::Type type, std::string_view data) {
+    if(type == CborReader::Type::ByteString) {
+        WriteBase64(this->output, data);
+        return;
+    }
+
+    if(!IsValidUtf8(data)) {
+        throw std::runtime_error("invalid UTF-8 in CBOR text string");
+    }
+    WriteEscaped(this->output, data);
+}
+
+/**
+ * @brief Write an integer or floating point number
+ *
+ * Floating point values are written in the shortest form that reads back to the same value; for
+ * values encoded at single (or half) precision, that's the shortest single precision form. NaN
+ * and infinities can't be represented in JSON, and are written as `null`.
+ */
+void CborJsonTranscoder::writeNumber(const CborReader::Item &item) {
+    using Type = CborReader::Type;
+
+    // map keys must be strings
+    if(item.isKey) {
+        this->output.push_back('"');
+    }
+
+    if(item.type == Type::Unsigned) {
+        WriteChars(this->output, item.value);
+    } else if(item.type == Type::Negative) {
+        // -1 - value; the most negative value doesn't fit in 64 bits
+        this->output.push_back('-');
+        if(item.value == std::numeric_limits<uint64_t>::max()) {
+            this->output.append("18446744073709551616");
+        } else {
+            WriteChars(this->output, item.value + 1);
+        }
+    } else if(!std::isfinite(item.number)) {
+        this->output.append("null");
+    } else if(item.value < 8) {
+        WriteChars(this->output, static_cast<float>(item.number));
+    } else {
+        WriteChars(this->output, item.number);
+    }
+
+    if(item.isKey) {
+        this->output.push_back('"');
+    }
+}
+
+/**
+ * @brief Write a timestamp (tag 1) as an ISO 8601 string
+ *
+ * Timestamps are written in UTC, with millisecond resolution if that's exact, microseconds
+ * otherwise. Values that can't be represented this way (years outside of 0 to 9999) are written
+ * as plain numbers instead.
+ */
+void CborJsonTranscoder::writeTimestamp(const CborReader::Item &item) {
+    using Type = CborReader::Type;
+
+    // range of years 0 to 9999, in seconds since the epoch
+    constexpr double kMinTime{-62167219200.}, kMaxTime{253402300800.};
+
+    double seconds;
+    switch(item.type) {
+        case Type::Unsigned:
+            seconds = static_cast<double>(item.value);
+            break;
+        case Type::Negative:
+            seconds = -1. - static_cast<double>(item.value);
+            break;
+        default:
+            seconds = item.number;
+            break;
+    }
+
+    if(!(seconds >= kMinTime && seconds < kMaxTime)) {
+        return this->writeNumber(item);
+    }
+
+    const auto micros = std::llround(seconds * 1e6);
+    auto whole = micros / 1'000'000, fraction = micros % 1'000'000;
+    if(fraction < 0) {
+        whole--;
+        fraction += 1'000'000;
+    }
+
+    const std::time_t time = whole;
+    struct tm parts;
+    char buffer[48];
+    if(!gmtime_r(&time, &parts)) {
+        return this->writeNumber(item);
+    }
+
+    // strftime's %Y doesn't pad years before 1000 to the four digits RFC 3339 requires
+    size_t length = snprintf(buffer, sizeof(buffer), "\"%04d-%02d-%02dT%02d:%02d:%02d",
+            parts.tm_year + 1900, parts.tm_mon + 1, parts.tm_mday, parts.tm_hour, parts.tm_min,
+            parts.tm_sec);
+    if(fraction % 1000) {
+        length += snprintf(buffer + length, sizeof(buffer) - length, ".%06ldZ\"",
+                static_cast<long>(fraction));
+    } else if(fraction || item.type == Type::Float) {
+        length += snprintf(buffer + length, sizeof(buffer) - length, ".%03ldZ\"",
+                static_cast<long>(fraction / 1000));
+    } else {
+        length += snprintf(buffer + length, sizeof(buffer) - length, "Z\"");
+    }
+
+    this->output.append(buffer, length);
+}
+
+
+
+/**
+ * @brief Convert CBOR data to JSON
+ *
+ * @param data Encoded CBOR data (one or more items)
+ *
+ * @return JSON text; one line for each top level item
+ */
+std::string TristLib::Core::CborToJson(std::span<const std::byte> data) {
+    std::string output;
+    output.reserve(data.size() * 2);
+
+    CborJsonTranscoder transcoder(output);
+    transcoder.feed(data);
+
+    if(!transcoder.isAtBoundary()) {
+        throw std::runtime_error("truncated CBOR data");
+    }
+    return output;
+}
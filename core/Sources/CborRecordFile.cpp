@@ -0,0 +1,519 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <plog/Log.h>
+
+#include "TristLib/Core/CborReader.h"
+#include "TristLib/Core/CborRecordFile.h"
+#include "TristLib/Core/CborWriter.h"
+
+using namespace TristLib::Core;
+using namespace TristLib::Core::CborRecordFile;
+
+namespace {
+/// Size of the fixed part of a record: array head, tagged timestamp, tag of the payload
+constexpr size_t kRecordPrefixSize{1 + 1 + 9 + 2};
+
+/**
+ * @brief Encode the file header
+ */
+std::vector<std::byte> EncodeHeader() {
+    std::vector<std::byte> header;
+    CborVectorSink sink(header);
+    CborWriter writer(sink);
+
+    writer.writeTag(55800);
+    writer.beginArray(2).writeString(kMagic).writeUint(kVersion);
+    return header;
+}
+
+/**
+ * @brief Convert a time point to the timestamp stored in the file
+ */
+double ToTimestamp(const Clock::time_point time) {
+    using namespace std::chrono;
+    return duration_cast<duration<double>>(time.time_since_epoch()).count();
+}
+
+/**
+ * @brief Convert a stored timestamp to a time point
+ */
+Clock::time_point FromTimestamp(const double secs) {
+    using namespace std::chrono;
+    return Clock::time_point(duration_cast<Clock::duration>(duration<double>(secs)));
+}
+
+/**
+ * @brief Read a big endian integer
+ */
+uint64_t LoadBigEndian(const std::byte *data, const size_t bytes) {
+    uint64_t value{0};
+    for(size_t i = 0; i < bytes; i++) {
+        value = (value << 8) | static_cast<uint8_t>(data[i]);
+    }
+    return value;
+}
+
+/**
+ * @brief Determine whether a record at the given offset should get an index entry
+ */
+bool NeedsIndexEntry(const std::vector<IndexEntry> &index, const uint64_t offset) {
+    return index.empty() || offset - index.back().offset >= kIndexInterval;
+}
+}
+
+
+
+/**
+ * @brief Open a record file for writing
+ *
+ * If the file exists, records are appended to it.
+ *
+ * @param path Path to the record file
+ */
+CborRecordWriter::CborRecordWriter(const std::filesystem::path &path) {
+    this->buffer.reserve(kBufferSize);
+
+    this->fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(this->fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "open record file");
+    }
+
+    try {
+        struct stat sb;
+        if(fstat(this->fd, &sb)) {
+            throw std::system_error(errno, std::generic_category(), "stat record file");
+        }
+
+        // new file: start with the header
+        if(!sb.st_size) {
+            const auto header = EncodeHeader();
+            this->buffer.insert(this->buffer.end(), header.begin(), header.end());
+        }
+        // existing file: pick up its index, then remove it (along with any partial record)
+        else {
+            CborRecordReader reader(path);
+            this->index = reader.getIndex();
+            this->offset = reader.getDataEnd();
+
+            if(!this->index.empty()) {
+                this->lastTime = this->index.back().time;
+            }
+            for(const auto &record : reader.getRange(FromTimestamp(this->lastTime),
+                        Clock::time_point::max())) {
+                this->lastTime = ToTimestamp(record.time);
+            }
+
+            if(ftruncate(this->fd, this->offset)) {
+                throw std::system_error(errno, std::generic_category(), "truncate record file");
+            }
+        }
+    } catch(...) {
+        ::close(this->fd);
+        throw;
+    }
+}
+
+/**
+ * @brief Close the file, writing its index
+ */
+CborRecordWriter::~CborRecordWriter() {
+    try {
+        this->close();
+    } catch(const std::exception &e) {
+        PLOG_ERROR << "failed to close record file: " << e.what();
+    }
+}
+
+/**
+ * @brief Append a record
+ *
+ * @param time Timestamp of the record; it may not be earlier than that of the previous record
+ * @param payload Encoded CBOR item
+ */
+void CborRecordWriter::append(const Clock::time_point time, std::span<const std::byte> payload) {
+    if(this->fd == -1) {
+        throw std::logic_error("record file is closed");
+    }
+
+    const auto timestamp = ToTimestamp(time);
+    if(timestamp < this->lastTime) {
+        throw std::invalid_argument("records must be appended in order of their timestamps");
+    }
+    this->lastTime = timestamp;
+
+    const auto recordOffset = this->offset + this->buffer.size();
+    if(NeedsIndexEntry(this->index, recordOffset)) {
+        this->index.push_back({timestamp, recordOffset});
+    }
+
+    // encode the record into the buffer; large payloads are written directly
+    CborVectorSink sink(this->buffer);
+    CborWriter writer(sink);
+
+    writer.beginArray(2).writeTag(1).writeDouble(timestamp);
+    writer.writeTag(24).writeHead(CborWriter<CborVectorSink>::MajorType::ByteString,
+            payload.size());
+
+    if(payload.size() >= kBufferSize) {
+        this->flush();
+        this->writeAll(payload);
+    } else {
+        this->buffer.insert(this->buffer.end(), payload.begin(), payload.end());
+        if(this->buffer.size() >= kBufferSize) {
+            this->flush();
+        }
+    }
+}
+
+/**
+ * @brief Write all buffered records to the file
+ *
+ * The file doesn't have an index until it's closed, but readers can still access all records
+ * written so far.
+ */
+void CborRecordWriter::flush() {
+    if(this->buffer.empty()) {
+        return;
+    }
+
+    this->writeAll(this->buffer);
+    this->buffer.clear();
+}
+
+/**
+ * @brief Write the index and trailer, and close the file
+ */
+void CborRecordWriter::close() {
+    if(this->fd == -1) {
+        return;
+    }
+
+    CborVectorSink sink(this->buffer);
+    CborWriter writer(sink);
+
+    const auto indexOffset = this->offset + this->buffer.size();
+    writer.beginArray(this->index.size());
+    for(const auto &entry : this->index) {
+        writer.beginArray(2).writeDouble(entry.time).writeUint(entry.offset);
+    }
+
+    std::byte trailer[16];
+    memcpy(trailer, kTrailerMagic.data(), kTrailerMagic.size());
+    for(size_t i = 0; i < 8; i++) {
+        trailer[8 + i] = static_cast<std::byte>(indexOffset >> (56 - (i * 8)));
+    }
+    writer.writeBytes(trailer);
+
+    try {
+        this->flush();
+    } catch(...) {
+        ::close(this->fd);
+        this->fd = -1;
+        throw;
+    }
+
+    ::close(this->fd);
+    this->fd = -1;
+}
+
+/**
+ * @brief Write data at the end of the file
+ */
+void CborRecordWriter::writeAll(std::span<const std::byte> data) {
+    while(!data.empty()) {
+        const auto written = pwrite(this->fd, data.data(), data.size(), this->offset);
+        if(written == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "write record file");
+        }
+
+        data = data.subspan(written);
+        this->offset += written;
+    }
+}
+
+
+
+/**
+ * @brief Open a record file for reading
+ *
+ * @param path Path to the record file
+ */
+CborRecordReader::CborRecordReader(const std::filesystem::path &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "open record file");
+    }
+
+    struct stat sb;
+    if(fstat(fd, &sb)) {
+        const auto error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "stat record file");
+    }
+    this->size = sb.st_size;
+
+    if(this->size) {
+        auto ptr = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+        if(ptr == MAP_FAILED) {
+            const auto error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "map record file");
+        }
+        this->data = static_cast<const std::byte *>(ptr);
+    }
+    ::close(fd);
+
+    // validate the header
+    const auto header = EncodeHeader();
+    if(this->size < header.size() || memcmp(this->data, header.data(), header.size())) {
+        if(this->data) {
+            munmap(const_cast<std::byte *>(this->data), this->size);
+        }
+        throw std::runtime_error("invalid record file header");
+    }
+    this->dataStart = header.size();
+
+    if(!(this->indexValid = this->loadIndex())) {
+        this->rebuildIndex();
+    }
+}
+
+/**
+ * @brief Unmap the file
+ */
+CborRecordReader::~CborRecordReader() {
+    if(this->data) {
+        munmap(const_cast<std::byte *>(this->data), this->size);
+        this->data = nullptr;
+    }
+}
+
+/**
+ * @brief Get an iterator to the first record
+ */
+CborRecordReader::Iterator CborRecordReader::begin() const {
+    return Iterator(this, this->dataStart, std::numeric_limits<double>::infinity());
+}
+
+/**
+ * @brief Get an iterator past the last record
+ */
+CborRecordReader::Iterator CborRecordReader::end() const {
+    return Iterator(this, this->dataEnd, 0);
+}
+
+/**
+ * @brief Get all records in a time range
+ *
+ * The index is used to find the last indexed record before the start of the range; from there,
+ * records are scanned until the first one in the range.
+ *
+ * @param start Start of the range (inclusive)
+ * @param end End of the range (exclusive)
+ */
+CborRecordReader::Range CborRecordReader::getRange(const Clock::time_point start,
+        const Clock::time_point end) const {
+    const auto startTime = ToTimestamp(start);
+    const auto endTime = (end == Clock::time_point::max()) ?
+        std::numeric_limits<double>::infinity() : ToTimestamp(end);
+
+    // find the last index entry strictly before the start time
+    auto it = std::lower_bound(this->index.begin(), this->index.end(), startTime,
+            [](const auto &entry, const double time) {
+        return entry.time < time;
+    });
+    const uint64_t offset = (it == this->index.begin()) ? this->dataStart : (it - 1)->offset;
+
+    // then skip records preceding the range
+    Iterator first(this, offset, endTime);
+    while(first.current.offset != this->dataEnd && first.timestamp < startTime) {
+        ++first;
+    }
+
+    return {first, this->end()};
+}
+
+/**
+ * @brief Read the record at the given offset
+ *
+ * @return Record, or an empty optional if there is no valid record at that offset
+ */
+std::optional<CborRecordReader::Record> CborRecordReader::readAt(const uint64_t offset) const {
+    Record record;
+    double timestamp;
+    uint64_t next;
+
+    if(offset < this->dataStart || offset >= this->dataEnd ||
+            !this->parseRecord(offset, record, timestamp, next) || next > this->dataEnd) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+/**
+ * @brief Read the index from the file's footer
+ *
+ * @return Whether a valid index was found
+ */
+bool CborRecordReader::loadIndex() {
+    if(this->size < this->dataStart + kTrailerSize) {
+        return false;
+    }
+
+    // validate trailer
+    const auto trailer = this->data + this->size - kTrailerSize;
+    if(static_cast<uint8_t>(trailer[0]) != 0x50 ||
+            memcmp(trailer + 1, kTrailerMagic.data(), kTrailerMagic.size())) {
+        return false;
+    }
+
+    const auto indexOffset = LoadBigEndian(trailer + 1 + kTrailerMagic.size(), 8);
+    if(indexOffset < this->dataStart || indexOffset > this->size - kTrailerSize) {
+        return false;
+    }
+
+    // then decode the index
+    try {
+        CborReader reader;
+        reader.feed({this->data + indexOffset, this->size - kTrailerSize - indexOffset});
+
+        auto item = reader.next();
+        if(item.type != CborReader::Type::ArrayStart || item.value == CborReader::kIndefinite) {
+            return false;
+        }
+        this->index.reserve(std::min<uint64_t>(item.value, this->size / kIndexInterval + 1));
+
+        for(uint64_t i = 0; i < item.value; i++) {
+            const auto start = reader.next(), time = reader.next(), offset = reader.next(),
+                  end = reader.next();
+            if(start.type != CborReader::Type::ArrayStart || start.value != 2 ||
+                    time.type != CborReader::Type::Float ||
+                    offset.type != CborReader::Type::Unsigned ||
+                    offset.value < this->dataStart || offset.value >= indexOffset ||
+                    end.type != CborReader::Type::End) {
+                this->index.clear();
+                return false;
+            }
+
+            this->index.push_back({time.number, offset.value});
+        }
+    } catch(const std::exception &) {
+        this->index.clear();
+        return false;
+    }
+
+    this->dataEnd = indexOffset;
+    return true;
+}
+
+/**
+ * @brief Rebuild the index by walking all records
+ *
+ * This stops at the first incomplete (or otherwise invalid) record, such as one that was being
+ * written when the writer crashed.
+ */
+void CborRecordReader::rebuildIndex() {
+    uint64_t offset{this->dataStart}, next;
+    Record record;
+    double timestamp;
+
+    while(this->parseRecord(offset, record, timestamp, next) && next <= this->size) {
+        if(NeedsIndexEntry(this->index, offset)) {
+            this->index.push_back({timestamp, offset});
+        }
+        offset = next;
+    }
+
+    this->dataEnd = offset;
+}
+
+/**
+ * @brief Decode a record's header
+ *
+ * @param offset Offset of the record
+ * @param record Record to fill in
+ * @param timestamp Set to the record's timestamp, as stored in the file
+ * @param next Set to the offset of the following record
+ *
+ * @return Whether a record was decoded
+ */
+bool CborRecordReader::parseRecord(const uint64_t offset, Record &record, double &timestamp,
+        uint64_t &next) const {
+    if(this->size - offset < kRecordPrefixSize + 1) {
+        return false;
+    }
+
+    const auto ptr = this->data + offset;
+    if(static_cast<uint8_t>(ptr[0]) != 0x82 || static_cast<uint8_t>(ptr[1]) != 0xC1 ||
+            static_cast<uint8_t>(ptr[2]) != 0xFB || static_cast<uint8_t>(ptr[11]) != 0xD8 ||
+            static_cast<uint8_t>(ptr[12]) != 0x18) {
+        return false;
+    }
+
+    // decode the payload byte string's head
+    const uint8_t initial = static_cast<uint8_t>(ptr[kRecordPrefixSize]);
+    if((initial >> 5) != 2) {
+        return false;
+    }
+
+    uint64_t length;
+    size_t headSize{1};
+    const auto info = initial & 0x1F;
+    if(info < 24) {
+        length = info;
+    } else if(info <= 27) {
+        headSize += 1U << (info - 24);
+        if(this->size - offset < kRecordPrefixSize + headSize) {
+            return false;
+        }
+        length = LoadBigEndian(ptr + kRecordPrefixSize + 1, headSize - 1);
+    } else {
+        return false;
+    }
+
+    const auto payloadOffset = offset + kRecordPrefixSize + headSize;
+    if(length > this->size - payloadOffset) {
+        return false;
+    }
+
+    timestamp = std::bit_cast<double>(LoadBigEndian(ptr + 3, 8));
+    record.time = FromTimestamp(timestamp);
+    record.payload = {this->data + payloadOffset, static_cast<size_t>(length)};
+    record.offset = offset;
+    next = payloadOffset + length;
+    return true;
+}
+
+
+
+/**
+ * @brief Load the record at the given offset
+ *
+ * If there is no record there (the end was reached) or it's past the iterator's time limit, the
+ * iterator becomes equal to the end iterator.
+ */
+void CborRecordReader::Iterator::load(const uint64_t offset) {
+    const auto end = this->reader->dataEnd;
+
+    if(offset >= end ||
+            !this->reader->parseRecord(offset, this->current, this->timestamp, this->next) ||
+            this->next > end || this->timestamp >= this->limit) {
+        this->current = {};
+        this->current.offset = end;
+        this->next = end;
+    }
+}
@@ -0,0 +1,144 @@
+/**
+ * @file
+ *
+ * @brief Fast text log formatter
+ *
+ * Produces the same output as plog's `TxtFormatter`, without going through output streams.
+ */
+#ifndef FASTTXTFORMATTER_H
+#define FASTTXTFORMATTER_H
+
+#include <time.h>
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+namespace TristLib::Core {
+/**
+ * @brief plog Formatter equivalent to `TxtFormatter`
+ *
+ * The calendar date and time is converted and formatted at most once per second per thread;
+ * for other records, only the milliseconds are formatted. The record is assembled in a thread
+ * local buffer.
+ *
+ * @tparam useUtcTime Output timestamps in UTC, rather than local time
+ */
+template<bool useUtcTime>
+class FastTxtFormatterImpl {
+    private:
+        /**
+         * @brief Per thread formatting state
+         */
+        struct State {
+            /// Second for which the time prefix was formatted
+            time_t cachedTime{-1};
+            /// Formatted date and time (`YYYY-MM-DD HH:MM:SS.`)
+            char timePrefix[32];
+            /// Length of the formatted date and time
+            size_t timePrefixLength{0};
+            /// Output buffer
+            std::string buffer;
+        };
+
+    public:
+        static plog::util::nstring header() {
+            return plog::util::nstring();
+        }
+
+        static plog::util::nstring format(const plog::Record &record) {
+            static thread_local State state;
+            auto &buf = state.buffer;
+            buf.clear();
+
+            // date and time (cached), then milliseconds
+            const auto &time = record.getTime();
+            if(time.time != state.cachedTime) {
+                UpdateTimePrefix(state, time.time);
+            }
+            buf.append(state.timePrefix, state.timePrefixLength);
+
+            const unsigned int millis = time.millitm;
+            buf.push_back('0' + ((millis / 100) % 10));
+            buf.push_back('0' + ((millis / 10) % 10));
+            buf.push_back('0' + (millis % 10));
+            buf.push_back(' ');
+
+            // severity, padded to 5 characters
+            const std::string_view severity = plog::severityToString(record.getSeverity());
+            buf.append(severity);
+            if(severity.size() < 5) {
+                buf.append(5 - severity.size(), ' ');
+            }
+            buf.push_back(' ');
+
+            // thread id, function and line
+            buf.push_back('[');
+            AppendNumber(buf, record.getTid());
+            buf.append("] [");
+            buf.append(record.getFunc());
+            buf.push_back('@');
+            AppendNumber(buf, record.getLine());
+            buf.append("] ");
+
+            buf.append(record.getMessage());
+            buf.push_back('\n');
+
+            return plog::util::nstring(buf);
+        }
+
+    private:
+        /**
+         * @brief Format the date and time prefix for a new second
+         */
+        static void UpdateTimePrefix(State &state, const time_t time) {
+            struct tm t;
+            if constexpr(useUtcTime) {
+                plog::util::gmtime_s(&t, &time);
+            } else {
+                plog::util::localtime_s(&t, &time);
+            }
+
+            // years are not zero padded (same as TxtFormatter)
+            char *p = std::to_chars(state.timePrefix, state.timePrefix + 12, t.tm_year + 1900).ptr;
+
+            auto put2 = [&p](const char sep, const int value) {
+                *p++ = sep;
+                *p++ = '0' + ((value / 10) % 10);
+                *p++ = '0' + (value % 10);
+            };
+
+            put2('-', t.tm_mon + 1);
+            put2('-', t.tm_mday);
+            put2(' ', t.tm_hour);
+            put2(':', t.tm_min);
+            put2(':', t.tm_sec);
+            *p++ = '.';
+
+            state.timePrefixLength = p - state.timePrefix;
+            state.cachedTime = time;
+        }
+
+        /**
+         * @brief Append a decimal number to the buffer
+         */
+        template<class T>
+        static inline void AppendNumber(std::string &buf, const T value) {
+            char temp[24];
+            const auto end = std::to_chars(temp, temp + sizeof(temp), value).ptr;
+            buf.append(temp, end - temp);
+        }
+};
+
+/// Fast formatter equivalent to `plog::TxtFormatter`
+using FastTxtFormatter = FastTxtFormatterImpl<false>;
+/// Fast formatter equivalent to `plog::TxtFormatterUtcTime`
+using FastTxtFormatterUtcTime = FastTxtFormatterImpl<true>;
+}
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * @file
+ *
+ * @brief Appender interface for buffering outputs
+ */
+#ifndef FLUSHABLEAPPENDER_H
+#define FLUSHABLEAPPENDER_H
+
+#include <atomic>
+#include <cstddef>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+namespace TristLib::Core {
+/// Total number of log records dropped by all destinations
+extern std::atomic<size_t> gDroppedLogRecords;
+
+/**
+ * @brief plog Appender that may buffer records internally
+ *
+ * Such appenders are flushed by `FlushLogs()`, which is also invoked on exit.
+ */
+class FlushableAppender: public plog::IAppender {
+    public:
+        /**
+         * @brief Write out any buffered records
+         */
+        virtual void flush() = 0;
+};
+}
+
+#endif
@@ -0,0 +1,268 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "TristLib/Core/HexDump.h"
+
+using namespace TristLib::Core;
+
+namespace {
+/// Number of lines formatted as one unit of work
+constexpr size_t kLinesPerChunk{16 * 1024};
+/// Maximum number of formatted chunks held in memory (per thread)
+constexpr size_t kChunksPerThread{2};
+
+/**
+ * @brief Bytes to dump, and how to dump them
+ */
+struct Input {
+    /// First byte to dump
+    const unsigned char *data;
+    /// Number of bytes to dump
+    size_t size;
+    /// File offset of the first byte
+    size_t offset;
+    /// Whether repeated lines are collapsed
+    bool collapse;
+
+    /// Get the number of lines in the dump
+    constexpr size_t getNumLines() const {
+        return (this->size + HexDump::BytesPerLine - 1) / HexDump::BytesPerLine;
+    }
+
+    /**
+     * @brief Determine whether a line is skipped, because it repeats the previous line
+     *
+     * Only full lines can repeat; a partial last line is always printed.
+     */
+    inline bool isRepeat(const size_t line) const {
+        if(!this->collapse || !line || (line + 1) * HexDump::BytesPerLine > this->size) {
+            return false;
+        }
+
+        const auto bytes = this->data + line * HexDump::BytesPerLine;
+        return !memcmp(bytes, bytes - HexDump::BytesPerLine, HexDump::BytesPerLine);
+    }
+};
+
+/**
+ * @brief Format a range of lines
+ *
+ * Whether lines repeat depends only on the input, so chunks can be formatted independently.
+ */
+void FormatChunk(const Input &input, const size_t firstLine, const size_t lastLine,
+        std::string &output) {
+    output.resize((lastLine - firstLine) * HexDump::MaxLineLength);
+    auto out = output.data();
+
+    for(size_t line = firstLine; line < lastLine; line++) {
+        // print a marker for the first of a run of repeated lines
+        if(input.isRepeat(line)) {
+            if(!input.isRepeat(line - 1)) {
+                *out++ = '*';
+                *out++ = '\n';
+            }
+            continue;
+        }
+
+        const auto start = line * HexDump::BytesPerLine;
+        out += HexDump::FormatHexLine(out, input.offset + start, input.data + start,
+                std::min(HexDump::BytesPerLine, input.size - start));
+    }
+
+    output.resize(out - output.data());
+}
+
+/**
+ * @brief Format all lines on the calling thread, and write them out
+ */
+void FormatSerial(const Input &input, std::ostream &output) {
+    std::string buffer;
+    for(size_t line = 0; line < input.getNumLines(); line += kLinesPerChunk) {
+        FormatChunk(input, line, std::min(input.getNumLines(), line + kLinesPerChunk), buffer);
+        output.write(buffer.data(), buffer.size());
+    }
+}
+
+/**
+ * @brief Format all lines, on multiple threads, and write them out in order
+ *
+ * Workers claim chunks in order, and format each into a slot of a ring; the calling thread
+ * writes out the slots in order. Workers wait if they get too far ahead of it.
+ *
+ * If not all workers can be started, the dump proceeds with those that were; if none were, the
+ * lines are formatted on the calling thread instead.
+ */
+void FormatParallel(const Input &input, std::ostream &output, const size_t numThreads) {
+    const size_t numLines = input.getNumLines();
+    const size_t numChunks = (numLines + kLinesPerChunk - 1) / kLinesPerChunk;
+
+    struct Slot {
+        std::string data;
+        bool ready{false};
+    };
+    std::vector<Slot> slots(numThreads * kChunksPerThread);
+
+    std::mutex lock;
+    std::condition_variable readyCond, writtenCond;
+    std::atomic_size_t nextChunk{0};
+    size_t written{0};
+
+    auto worker = [&]() {
+        size_t chunk;
+        while((chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) < numChunks) {
+            auto &slot = slots[chunk % slots.size()];
+            {
+                std::unique_lock guard(lock);
+                writtenCond.wait(guard, [&]() {
+                    return chunk < written + slots.size();
+                });
+            }
+
+            FormatChunk(input, chunk * kLinesPerChunk,
+                    std::min(numLines, (chunk + 1) * kLinesPerChunk), slot.data);
+
+            {
+                std::lock_guard guard(lock);
+                slot.ready = true;
+            }
+            readyCond.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for(size_t i = 0; i < numThreads; i++) {
+        try {
+            threads.emplace_back(worker);
+        } catch(const std::system_error &) {
+            break;
+        }
+    }
+
+    if(threads.empty()) {
+        return FormatSerial(input, output);
+    }
+
+    try {
+        for(size_t chunk = 0; chunk < numChunks; chunk++) {
+            auto &slot = slots[chunk % slots.size()];
+            {
+                std::unique_lock guard(lock);
+                readyCond.wait(guard, [&]() {
+                    return slot.ready;
+                });
+            }
+
+            output.write(slot.data.data(), slot.data.size());
+
+            {
+                std::lock_guard guard(lock);
+                slot.ready = false;
+                written++;
+            }
+            writtenCond.notify_all();
+        }
+    } catch(...) {
+        // stop workers from claiming more chunks, and release any that are waiting
+        nextChunk = numChunks;
+        {
+            std::lock_guard guard(lock);
+            written = numChunks;
+        }
+        writtenCond.notify_all();
+
+        for(auto &thread : threads) {
+            thread.join();
+        }
+        throw;
+    }
+
+    for(auto &thread : threads) {
+        thread.join();
+    }
+}
+}
+
+
+
+/**
+ * @param output Stream to write the dump to
+ * @param path File to dump
+ * @param offset Offset of the first byte to dump
+ * @param length Maximum number of bytes to dump, or `ToEnd`
+ * @param collapse Whether to replace repeated lines by a `*` line
+ */
+void HexDump::DumpFile(std::ostream &output, const std::filesystem::path &path, size_t offset,
+        size_t length, bool collapse) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "open dump file");
+    }
+
+    struct stat sb;
+    if(fstat(fd, &sb)) {
+        const auto error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "stat dump file");
+    }
+
+    const size_t fileSize = sb.st_size;
+    if(offset >= fileSize || !length) {
+        close(fd);
+        return;
+    }
+    length = std::min(length, fileSize - offset);
+
+    // map the requested range (starting at a page boundary)
+    const size_t pageOffset = offset & ~(static_cast<size_t>(sysconf(_SC_PAGESIZE)) - 1);
+    const size_t mapSize = offset + length - pageOffset;
+
+    auto ptr = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, pageOffset);
+    const auto error = errno;
+    close(fd);
+    if(ptr == MAP_FAILED) {
+        throw std::system_error(error, std::generic_category(), "map dump file");
+    }
+    madvise(ptr, mapSize, MADV_SEQUENTIAL);
+
+    const Input input{static_cast<const unsigned char *>(ptr) + (offset - pageOffset), length,
+        offset, collapse};
+
+    try {
+        // small dumps aren't worth starting threads for
+        const size_t numThreads = std::max(1U, std::thread::hardware_concurrency());
+
+        if(numThreads == 1 || input.getNumLines() <= kLinesPerChunk) {
+            FormatSerial(input, output);
+        } else {
+            FormatParallel(input, output, numThreads);
+        }
+
+        // mark the end of the dump, if it's hidden by a run of repeated lines
+        if(input.isRepeat(input.getNumLines() - 1)) {
+            char end[24];
+            const auto endLength = snprintf(end, sizeof(end), "%08zx\n", offset + length);
+            output.write(end, endLength);
+        }
+    } catch(...) {
+        munmap(ptr, mapSize);
+        throw;
+    }
+
+    munmap(ptr, mapSize);
+    output.flush();
+}
@@ -0,0 +1,307 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include "JournalAppender.h"
+#include "SyslogAppender.h"
+
+using namespace TristLib::Core;
+
+/**
+ * @brief Open a datagram socket connected to the given path
+ *
+ * @return Socket file descriptor, or -1 on error
+ */
+static int ConnectDatagramSocket(const std::string_view path) {
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(addr.sun_path, path.data(), path.size());
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd == -1) {
+        return -1;
+    }
+
+    if(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr))) {
+        const auto err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Append a field in the journal native protocol format
+ *
+ * Values containing newlines use the binary (length prefixed) form.
+ */
+static void AppendField(std::string &out, const std::string_view key,
+        const std::string_view value) {
+    out.append(key);
+
+    if(value.find('\n') == std::string_view::npos) {
+        out.push_back('=');
+        out.append(value);
+    } else {
+        out.push_back('\n');
+
+        const uint64_t length = value.size();
+        for(size_t i = 0; i < sizeof(length); i++) {
+            out.push_back(static_cast<char>(length >> (i * 8)));
+        }
+        out.append(value);
+    }
+
+    out.push_back('\n');
+}
+
+
+
+/**
+ * @brief Connect to the journal
+ *
+ * Prefer the journal's native socket, and fall back to the syslog socket. Then start the thread
+ * sending the records.
+ *
+ * @param facility syslog facility for records
+ * @param ident Identifier (usually, the program name) for records
+ */
+JournalAppenderBase::JournalAppenderBase(const int facility, const std::string_view ident) :
+    facility(facility), ident(ident), pid(std::to_string(getpid())) {
+    this->fd = ConnectDatagramSocket(kJournalSocketPath);
+    if(this->fd != -1) {
+        this->native = true;
+    } else {
+        this->fd = ConnectDatagramSocket(kSyslogSocketPath);
+        if(this->fd == -1) {
+            throw std::system_error(errno, std::generic_category(), "connect journal socket");
+        }
+    }
+
+    try {
+        this->batch.reserve(kMaxBatchSize);
+        this->batchIov.resize(kMaxBatchSize);
+        this->batchMsgs.resize(kMaxBatchSize);
+
+        this->sender = std::thread(&JournalAppenderBase::senderMain, this);
+    } catch(...) {
+        close(this->fd);
+        throw;
+    }
+}
+
+/**
+ * @brief Send any pending records, then close the socket
+ */
+JournalAppenderBase::~JournalAppenderBase() {
+    {
+        std::lock_guard lg(this->lock);
+        this->shutdown = true;
+    }
+    this->wakeSender.notify_all();
+
+    this->sender.join();
+    close(this->fd);
+}
+
+/**
+ * @brief Wait for all queued records to be sent
+ */
+void JournalAppenderBase::flush() {
+    std::unique_lock lg(this->lock);
+    if(this->pending.empty() && !this->sending) {
+        return;
+    }
+
+    this->flushRequested = true;
+    this->wakeSender.notify_all();
+
+    this->sendDone.wait(lg, [&] {
+        return this->pending.empty() && !this->sending;
+    });
+}
+
+/**
+ * @brief Encode a record and queue it for sending
+ *
+ * The sender is woken once a full batch is queued; otherwise, it sends the records once the
+ * batch delay expires.
+ *
+ * @param record Record to send
+ * @param message Formatted message text (a single trailing newline is removed)
+ */
+void JournalAppenderBase::submit(const plog::Record &record, std::string_view message) {
+    if(!message.empty() && message.back() == '\n') {
+        message.remove_suffix(1);
+    }
+
+    std::string datagram;
+    if(this->native) {
+        this->encodeNative(datagram, record, message);
+    } else {
+        this->encodeSyslog(datagram, record, message);
+    }
+
+    std::unique_lock lg(this->lock);
+    if(this->pending.size() >= kMaxPending) {
+        gDroppedLogRecords.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    this->pending.emplace_back(std::move(datagram));
+    const auto numPending = this->pending.size();
+    lg.unlock();
+
+    if(numPending == 1 || numPending == kMaxBatchSize) {
+        this->wakeSender.notify_one();
+    }
+}
+
+/**
+ * @brief Encode a record in the journal native protocol
+ */
+void JournalAppenderBase::encodeNative(std::string &out, const plog::Record &record,
+        const std::string_view message) {
+    const auto priority = ConvertSeverityToSyslog(record.getSeverity());
+
+    out.reserve(message.size() + 160);
+
+    AppendField(out, "MESSAGE", message);
+    AppendField(out, "PRIORITY", std::to_string(priority));
+    AppendField(out, "SYSLOG_FACILITY", std::to_string(this->facility >> 3));
+    AppendField(out, "SYSLOG_IDENTIFIER", this->ident);
+    AppendField(out, "TID", std::to_string(record.getTid()));
+    AppendField(out, "CODE_FUNC", record.getFunc());
+    AppendField(out, "CODE_LINE", std::to_string(record.getLine()));
+
+    if(auto file = record.getFile(); file && *file) {
+        AppendField(out, "CODE_FILE", file);
+    }
+}
+
+/**
+ * @brief Encode a record as a syslog message
+ *
+ * The local syslog daemon adds the timestamp and host name.
+ */
+void JournalAppenderBase::encodeSyslog(std::string &out, const plog::Record &record,
+        const std::string_view message) {
+    const auto priority = ConvertSeverityToSyslog(record.getSeverity());
+
+    out.reserve(message.size() + this->ident.size() + 24);
+
+    out.push_back('<');
+    out.append(std::to_string(this->facility | priority));
+    out.push_back('>');
+    out.append(this->ident);
+    out.push_back('[');
+    out.append(this->pid);
+    out.append("]: ");
+    out.append(message);
+}
+
+/**
+ * @brief Sender thread entry point
+ *
+ * Waits for a record to be queued, then for more records to batch with it: until a full batch is
+ * queued, a flush is requested, or the batch delay expires. Then all pending records are sent.
+ */
+void JournalAppenderBase::senderMain() {
+    std::unique_lock lg(this->lock);
+
+    while(true) {
+        this->wakeSender.wait(lg, [&] {
+            return this->shutdown || !this->pending.empty();
+        });
+        if(this->pending.empty()) {
+            break;
+        }
+
+        this->wakeSender.wait_for(lg, kBatchDelay, [&] {
+            return this->shutdown || this->flushRequested ||
+                this->pending.size() >= kMaxBatchSize;
+        });
+
+        this->sendPending(lg);
+        this->flushRequested = false;
+    }
+}
+
+/**
+ * @brief Send all pending datagrams
+ *
+ * The lock is dropped while sending, so other threads can queue more datagrams; these are sent
+ * as well, before returning.
+ *
+ * @param lock Lock guard on the appender's lock (which must be held)
+ */
+void JournalAppenderBase::sendPending(std::unique_lock<std::mutex> &lock) {
+    this->sending = true;
+
+    while(!this->pending.empty()) {
+        const size_t count = std::min(this->pending.size(), kMaxBatchSize);
+        std::move(this->pending.begin(), this->pending.begin() + count,
+                std::back_inserter(this->batch));
+        this->pending.erase(this->pending.begin(), this->pending.begin() + count);
+
+        lock.unlock();
+        this->sendBatch();
+        lock.lock();
+    }
+
+    this->sending = false;
+    this->sendDone.notify_all();
+}
+
+/**
+ * @brief Send the current batch of datagrams
+ *
+ * If the socket buffer is full, the remaining datagrams are dropped; datagrams that can't be
+ * sent for any other reason (for example, because they're too large) are dropped individually.
+ */
+void JournalAppenderBase::sendBatch() {
+    const size_t count = this->batch.size();
+
+    for(size_t i = 0; i < count; i++) {
+        auto &iov = this->batchIov[i];
+        iov.iov_base = this->batch[i].data();
+        iov.iov_len = this->batch[i].size();
+
+        auto &msg = this->batchMsgs[i];
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_hdr.msg_iov = &iov;
+        msg.msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t sent{0};
+    while(sent < count) {
+        const int ret = sendmmsg(this->fd, this->batchMsgs.data() + sent, count - sent,
+                MSG_DONTWAIT | MSG_NOSIGNAL);
+        if(ret > 0) {
+            sent += ret;
+        } else if(errno == EINTR) {
+            continue;
+        } else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+            gDroppedLogRecords.fetch_add(count - sent, std::memory_order_relaxed);
+            break;
+        } else {
+            gDroppedLogRecords.fetch_add(1, std::memory_order_relaxed);
+            sent++;
+        }
+    }
+
+    this->batch.clear();
+}
@@ -0,0 +1,130 @@
+/**
+ * @file
+ *
+ * @brief Journal output appender
+ *
+ * Sends plog messages directly to the systemd journal's native socket (or the syslog socket, if
+ * the journal isn't available) without blocking.
+ */
+#ifndef JOURNALAPPENDER_H
+#define JOURNALAPPENDER_H
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+#include "FlushableAppender.h"
+
+namespace TristLib::Core {
+/**
+ * @brief Datagram sender for journal appenders
+ *
+ * Records are encoded into datagrams and queued; a background thread sends them in batches,
+ * once a full batch is queued, or `kBatchDelay` after the first record of a batch was queued
+ * (whichever comes first.) The socket is non-blocking: if it's full, the remaining records are
+ * dropped and counted.
+ */
+class JournalAppenderBase: public FlushableAppender {
+    public:
+        /// Path to the journal's native protocol socket
+        constexpr static const std::string_view kJournalSocketPath{"/run/systemd/journal/socket"};
+        /// Path to the syslog socket
+        constexpr static const std::string_view kSyslogSocketPath{"/dev/log"};
+
+        /// Maximum number of datagrams sent in one system call
+        constexpr static const size_t kMaxBatchSize{64};
+        /// Maximum number of datagrams queued while a send is in progress
+        constexpr static const size_t kMaxPending{1024};
+        /// Maximum time a record waits for more records to be batched with
+        constexpr static const std::chrono::milliseconds kBatchDelay{5};
+
+    public:
+        JournalAppenderBase(const int facility, const std::string_view ident);
+        ~JournalAppenderBase() override;
+
+        void flush() override;
+
+    protected:
+        void submit(const plog::Record &record, std::string_view message);
+
+    private:
+        void encodeNative(std::string &out, const plog::Record &record,
+                std::string_view message);
+        void encodeSyslog(std::string &out, const plog::Record &record,
+                std::string_view message);
+
+        void senderMain();
+        void sendPending(std::unique_lock<std::mutex> &lock);
+        void sendBatch();
+
+    private:
+        /// Datagram socket connected to the journal or syslog
+        int fd{-1};
+        /// Set if connected to the journal's native socket
+        bool native{false};
+
+        /// syslog facility
+        int facility;
+        /// Identifier (program name) for records
+        std::string ident;
+        /// Process id, in string form
+        std::string pid;
+
+        /// Lock protecting the pending datagrams and send state
+        std::mutex lock;
+        /// Signalled when datagrams are queued, or the sender should stop waiting for more
+        std::condition_variable wakeSender;
+        /// Signalled when a send completes
+        std::condition_variable sendDone;
+        /// Set while the sender is sending datagrams
+        bool sending{false};
+        /// Set to have the sender send the pending datagrams without waiting for more
+        bool flushRequested{false};
+        /// Set to request the sender to exit, once all datagrams are sent
+        bool shutdown{false};
+        /// Thread sending the datagrams
+        std::thread sender;
+        /// Datagrams waiting to be sent
+        std::vector<std::string> pending;
+
+        /// Datagrams being sent (only accessed by the sending thread)
+        std::vector<std::string> batch;
+        /// IO vectors for the batch
+        std::vector<struct iovec> batchIov;
+        /// Message headers for the batch
+        std::vector<struct mmsghdr> batchMsgs;
+};
+
+/**
+ * @brief plog Appender for writing messages to the journal
+ *
+ * The formatter produces the message text only: severity, function and source location are sent
+ * as separate structured fields.
+ */
+template<class Formatter>
+class JournalAppender: public JournalAppenderBase {
+    public:
+        using JournalAppenderBase::JournalAppenderBase;
+
+        /**
+         * @brief Format the message and send it to the journal
+         */
+        void write(const plog::Record &record) override {
+            const auto str = Formatter::format(record);
+            this->submit(record, str);
+        }
+};
+}
+
+#endif
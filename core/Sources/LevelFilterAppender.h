@@ -0,0 +1,60 @@
+/**
+ * @file
+ *
+ * @brief Log level filter in front of the log destinations
+ *
+ * The logger's level may be lower than the global log level, when a ring log wants to capture
+ * more records; this filter keeps those records away from all other destinations.
+ */
+#ifndef LEVELFILTERAPPENDER_H
+#define LEVELFILTERAPPENDER_H
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+#include "TristLib/Core/LogModules.h"
+
+namespace TristLib::Core {
+/**
+ * @brief plog Appender that forwards records passing the log level to other appenders
+ *
+ * Records submitted by module call sites are filtered by the module's log level; all others by
+ * the global log level.
+ */
+class LevelFilterAppender: public plog::IAppender {
+    public:
+        /**
+         * @brief Add an appender to receive the filtered records
+         */
+        void addAppender(plog::IAppender *appender) {
+            this->appenders.push_back(appender);
+        }
+
+        /**
+         * @brief Forward the record to all appenders, if it passes the log level
+         */
+        void write(const plog::Record &record) override {
+            const auto level = std::exchange(detail::gSubmittingSeverity, -1);
+            const auto max = (level >= 0) ? static_cast<plog::Severity>(level) :
+                detail::gLogSeverity.load(std::memory_order_relaxed);
+
+            if(record.getSeverity() > max) {
+                return;
+            }
+
+            for(auto appender : this->appenders) {
+                appender->write(record);
+            }
+        }
+
+    private:
+        /// Appenders receiving the records
+        std::vector<plog::IAppender *> appenders;
+};
+}
+
+#endif
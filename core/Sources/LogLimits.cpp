@@ -0,0 +1,91 @@
+#include <atomic>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+#include "TristLib/Core/LogLimits.h"
+
+using namespace TristLib::Core;
+
+/**
+ * @brief Head of the list of all sites that have suppressed records
+ */
+static std::atomic<LogSuppressionSite *> gSuppressionSites{nullptr};
+
+/**
+ * @brief Time at which suppressed records are next summarized
+ *
+ * Zero until the first record is suppressed, which starts the first interval.
+ */
+std::atomic<uint64_t> detail::gNextSuppressionReport{0};
+
+/**
+ * @brief Add the site to the global list of sites
+ */
+void LogSuppressionSite::registerSite() noexcept {
+    bool expected{false};
+    if(!this->registered.compare_exchange_strong(expected, true, std::memory_order_relaxed)) {
+        return;
+    }
+
+    auto head = gSuppressionSites.load(std::memory_order_relaxed);
+    do {
+        this->next = head;
+    } while(!gSuppressionSites.compare_exchange_weak(head, this, std::memory_order_release,
+                std::memory_order_relaxed));
+}
+
+/**
+ * @brief Log the number of suppressed records, and reset the count
+ *
+ * The summary is logged with the site's severity and source location.
+ */
+void LogSuppressionSite::report() {
+    const auto count = this->suppressed.exchange(0, std::memory_order_relaxed);
+    auto logger = plog::get<PLOG_DEFAULT_INSTANCE_ID>();
+
+    if(!count || !logger) {
+        return;
+    }
+
+    plog::Record record(this->severity, this->func, this->line, this->file, nullptr,
+            PLOG_DEFAULT_INSTANCE_ID);
+    record << "message at " << this->func << "@" << this->line << " suppressed " << count
+        << " times";
+    (*logger) += record;
+}
+
+
+
+/**
+ * @brief Report suppressed records of all call sites
+ *
+ * Logs a summary for each rate limited or sampled call site that suppressed any records since
+ * it was last reported. This happens automatically every `kSuppressedLogReportInterval` (when
+ * records are suppressed) but may be invoked to report them right away, such as before exiting.
+ */
+void TristLib::Core::ReportSuppressedLogs() {
+    for(auto site = gSuppressionSites.load(std::memory_order_acquire); site; site = site->next) {
+        site->report();
+    }
+}
+
+/**
+ * @brief Report suppressed records of all call sites, if the summary interval elapsed
+ *
+ * Only one of the threads that find the interval elapsed reports; the first call merely starts
+ * the interval.
+ *
+ * @param now Current time, from `GetCoarseTime()`
+ */
+void TristLib::Core::detail::ReportSuppressedLogsPeriodic(const uint64_t now) {
+    auto deadline = gNextSuppressionReport.load(std::memory_order_relaxed);
+    if(now < deadline || !gNextSuppressionReport.compare_exchange_strong(deadline,
+                now + kSuppressedLogReportInterval, std::memory_order_relaxed)) {
+        return;
+    }
+
+    if(deadline) {
+        ReportSuppressedLogs();
+    }
+}
@@ -1,9 +1,14 @@
 #include <syslog.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <list>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <type_traits>
 
 // when including plog, omit macros that clash with syslog macros
 #define PLOG_OMIT_LOG_DEFINES 1
@@ -14,10 +19,20 @@
 #include <plog/Appenders/RollingFileAppender.h>
 #include <plog/Formatters/CsvFormatter.h>
 #include <plog/Formatters/FuncMessageFormatter.h>
+#include <plog/Formatters/MessageOnlyFormatter.h>
 #include <plog/Formatters/TxtFormatter.h>
 #include <plog/Init.h>
 
+#include "AsyncAppender.h"
+#include "BinaryLogAppender.h"
+#include "BufferedFileAppender.h"
+#include "FastTxtFormatter.h"
+#include "JournalAppender.h"
+#include "LevelFilterAppender.h"
+#include "PreformattedFormatter.h"
+#include "RingLogAppender.h"
 #include "SyslogAppender.h"
+#include "TristLib/Core/LogModules.h"
 #include "TristLib/Core/Logging.h"
 
 namespace TristLib::Core {
@@ -26,6 +41,46 @@ namespace TristLib::Core {
  */
 static std::list<plog::IAppender *> gAppenders;
 
+/**
+ * @brief Filter in front of all destinations, except for the ring log
+ */
+static LevelFilterAppender gLevelFilter;
+
+/**
+ * @brief Number of log records dropped by all destinations
+ */
+std::atomic<size_t> gDroppedLogRecords{0};
+
+/**
+ * @brief Current log level generation
+ *
+ * Starts at 1, so that call sites (whose cache is zero-initialized) refresh on first use.
+ */
+std::atomic<uint32_t> detail::gLogLevelGeneration{1};
+
+/**
+ * @brief Global log level
+ */
+std::atomic<plog::Severity> detail::gLogSeverity{plog::none};
+/**
+ * @brief Log level of the ring log (`none` if there's no ring log)
+ */
+static std::atomic<plog::Severity> gRingLogSeverity{plog::none};
+
+/**
+ * @brief Log level of the module whose record is being submitted on this thread (if any)
+ */
+thread_local int detail::gSubmittingSeverity{-1};
+
+/**
+ * @brief Lock protecting module log levels (and serializing generation updates)
+ */
+static std::mutex gModuleLevelsLock;
+/**
+ * @brief Log level overrides for modules
+ */
+static std::map<std::string, plog::Severity, std::less<>> gModuleLevels;
+
 
 
 /**
@@ -53,14 +108,71 @@ constexpr static inline auto TranslateLogLevel(const int level) noexcept {
     }
 }
 
+/**
+ * @brief Invalidate log levels cached by module call sites
+ */
+static void InvalidateLogLevels() {
+    std::lock_guard lg(gModuleLevelsLock);
+    detail::gLogLevelGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Update the logger's level
+ *
+ * The logger lets through all records wanted by either the global log level or the ring log;
+ * records that only the ring log wants are filtered out again in front of all other destinations.
+ */
+static void UpdateLoggerSeverity() {
+    plog::get()->setMaxSeverity(std::max(detail::gLogSeverity.load(std::memory_order_relaxed),
+                gRingLogSeverity.load(std::memory_order_relaxed)));
+    InvalidateLogLevels();
+}
+
 /**
  * @brief Install a logging appender
+ *
+ * It receives the records that pass the log level.
  */
 static void InstallAppender(plog::IAppender *appender) {
-    plog::get()->addAppender(appender);
+    gLevelFilter.addAppender(appender);
     gAppenders.push_back(appender);
 }
 
+/**
+ * @brief Ensure log destinations are flushed on exit
+ */
+static void RegisterFlushAtExit() {
+    static std::once_flag gRegisterFlush;
+    std::call_once(gRegisterFlush, [] {
+        std::atexit(FlushLogs);
+    });
+}
+
+/**
+ * @brief Create a logging appender
+ *
+ * Invoke the factory to create an appender using the given formatter. If an asynchronous
+ * configuration is provided, the appender is instead created with a formatter that passes through
+ * preformatted messages, and wrapped in an asynchronous appender; this also ensures queued
+ * records are written on exit.
+ *
+ * @param factory Function invoked with a `std::type_identity` of the formatter to use, which
+ *        returns a newly allocated appender
+ * @param async Asynchronous configuration, if any
+ */
+template<class Formatter, class Factory>
+static plog::IAppender *CreateAppender(Factory factory,
+        const std::optional<AsyncLogConfig> &async) {
+    if(!async) {
+        return factory(std::type_identity<Formatter>{});
+    }
+
+    RegisterFlushAtExit();
+
+    return new AsyncAppender<Formatter>(
+            factory(std::type_identity<PreformattedFormatter<Formatter>>{}), *async);
+}
+
 /**
  * @brief Initialize logging
  *
@@ -69,7 +181,9 @@ static void InstallAppender(plog::IAppender *appender) {
  * @param level Minimum log level to output
  */
 static void InitPlog(const plog::Severity level) {
-    plog::init(level);
+    detail::gLogSeverity.store(level, std::memory_order_relaxed);
+    plog::init(level, &gLevelFilter);
+    UpdateLoggerSeverity();
 }
 
 
@@ -108,26 +222,30 @@ void InitLogging(const int level, const bool simple) noexcept {
  *
  * @param simple Whether the simple message output format (no timestamps) is used
  * @param colorize Apply color to messages iff stdout is a terminal
+ * @param async If specified, messages are written to the console on a background thread
+ *
+ * @remark Starting the background thread may fail, in which case an exception is thrown.
  */
-void AddLogDestinationStdout(const bool simple, const bool colorize) noexcept {
+void AddLogDestinationStdout(const bool simple, const bool colorize,
+        const std::optional<AsyncLogConfig> &async) {
     plog::IAppender *appender{nullptr};
 
     // figure out if the console is a tty
-    const bool isTty = (isatty(fileno(stdout)) == 1);
+    const bool color = (isatty(fileno(stdout)) == 1) && colorize;
 
-    // set up the logger
-    if(simple) {
-        if(isTty && colorize) {
-            appender = new plog::ColorConsoleAppender<plog::FuncMessageFormatter>();
+    auto factory = [color]<class Formatter>(std::type_identity<Formatter>) -> plog::IAppender * {
+        if(color) {
+            return new plog::ColorConsoleAppender<Formatter>();
         } else {
-            appender = new plog::ConsoleAppender<plog::FuncMessageFormatter>();
+            return new plog::ConsoleAppender<Formatter>();
         }
+    };
+
+    // set up the logger
+    if(simple) {
+        appender = CreateAppender<plog::FuncMessageFormatter>(factory, async);
     } else {
-        if(isTty && colorize) {
-            appender = new plog::ColorConsoleAppender<plog::TxtFormatter>();
-        } else {
-            appender = new plog::ConsoleAppender<plog::TxtFormatter>();
-        }
+        appender = CreateAppender<FastTxtFormatter>(factory, async);
     }
     InstallAppender(appender);
 }
@@ -137,13 +255,43 @@ void AddLogDestinationStdout(const bool simple, const bool colorize) noexcept {
  *
  * Log messages are sent to the system log via the C library's `syslog()` function under the given
  * facility.
+ *
+ * @param async If specified, messages are sent to syslog on a background thread
+ *
+ * @remark Starting the background thread may fail, in which case an exception is thrown.
  */
-void AddLogDestinationSyslog(const int facility, const std::string_view ident) noexcept {
+void AddLogDestinationSyslog(const int facility, const std::string_view ident,
+        const std::optional<AsyncLogConfig> &async) {
     // open the log connection
     openlog(ident.data(), 0, facility);
 
     // create an appender
-    auto appender = new SyslogAppender<plog::FuncMessageFormatter>();
+    auto appender = CreateAppender<plog::FuncMessageFormatter>(
+            []<class Formatter>(std::type_identity<Formatter>) -> plog::IAppender * {
+        return new SyslogAppender<Formatter>();
+    }, async);
+    InstallAppender(appender);
+}
+
+/**
+ * @brief Send log messages to the systemd journal
+ *
+ * Records are sent directly to the journal's native socket, with the severity, function, line
+ * and thread as separate fields; if the journal isn't running, the local syslog socket is used
+ * instead. Unlike `AddLogDestinationSyslog()`, this never blocks: records are dropped (and
+ * counted) if the socket's buffer is full.
+ *
+ * @param facility syslog facility for records
+ * @param ident Identifier (usually, the program name) for records
+ * @param async If specified, messages are sent on a background thread
+ */
+void AddLogDestinationJournal(const int facility, const std::string_view ident,
+        const std::optional<AsyncLogConfig> &async) {
+    auto appender = CreateAppender<plog::MessageOnlyFormatter>(
+            [&]<class Formatter>(std::type_identity<Formatter>) -> plog::IAppender * {
+        return new JournalAppender<Formatter>(facility, ident);
+    }, async);
+    RegisterFlushAtExit();
     InstallAppender(appender);
 }
 
@@ -161,21 +309,109 @@ void AddLogDestinationSyslog(const int facility, const std::string_view ident) n
  * @param maxFileSize Maximum size of the log file, in bytes
  * @param maxFiles Maximum number of log files
  * @param csv Whether the log file is formatted as a CSV
+ * @param async If specified, messages are written to the file on a background thread
  */
 void AddLogDestinationFile(const std::filesystem::path &path, const size_t maxFileSize,
-        const size_t maxFiles, const bool csv) {
+        const size_t maxFiles, const bool csv, const std::optional<AsyncLogConfig> &async) {
     plog::IAppender *appender{nullptr};
 
+    auto factory = [&]<class Formatter>(std::type_identity<Formatter>) -> plog::IAppender * {
+        return new plog::RollingFileAppender<Formatter>(path.native().c_str(), maxFileSize,
+                maxFiles);
+    };
+
     if(csv) {
-        appender = new plog::RollingFileAppender<plog::CsvFormatter>(path.native().c_str(),
-                maxFileSize, maxFiles);
+        appender = CreateAppender<plog::CsvFormatter>(factory, async);
     } else {
-        appender = new plog::RollingFileAppender<plog::FuncMessageFormatter>(path.native().c_str(),
-                maxFileSize, maxFiles);
+        appender = CreateAppender<plog::FuncMessageFormatter>(factory, async);
     }
     InstallAppender(appender);
 }
 
+/**
+ * @brief Send log messages to a buffered log file
+ *
+ * Unlike the other overload, records are collected in memory and written to the file in large
+ * batches: when the buffers fill up, periodically (at the configured flush interval) and when
+ * `FlushLogs()` is called. Rotated files are synced and compressed on a background thread.
+ *
+ * @param path Path to the log file; records are appended to it if it exists
+ * @param config Buffering, rotation and sync configuration
+ * @param async If specified, messages are formatted and buffered on a background thread
+ */
+void AddLogDestinationFile(const std::filesystem::path &path, const FileLogConfig &config,
+        const std::optional<AsyncLogConfig> &async) {
+    plog::IAppender *appender{nullptr};
+
+    auto factory = [&]<class Formatter>(std::type_identity<Formatter>) -> plog::IAppender * {
+        return new BufferedFileAppender<Formatter>(path, config);
+    };
+
+    if(config.csv) {
+        appender = CreateAppender<plog::CsvFormatter>(factory, async);
+    } else {
+        appender = CreateAppender<plog::FuncMessageFormatter>(factory, async);
+    }
+    RegisterFlushAtExit();
+    InstallAppender(appender);
+}
+
+/**
+ * @brief Send log messages to a memory mapped ring file
+ *
+ * Records are copied into a fixed size ring in a shared file mapping, overwriting the oldest
+ * records once it fills up. No system calls are made to log a record, and since the records
+ * live in the page cache, they survive the process crashing. Use the `tristlib-ringdump` tool to
+ * extract the records.
+ *
+ * The ring has its own log level, independent of the global (and module) log levels: it can
+ * keep a verbose history of recent activity, while the other destinations only receive the
+ * records that pass the log level.
+ *
+ * @remark An existing file at the path is renamed (by appending `.prev`) rather than overwritten.
+ *
+ * @param path Path to the ring file
+ * @param size Size of the ring, in bytes
+ * @param level What level messages to keep in the ring ([-3, 2]) where 2 is the most
+ */
+void AddLogDestinationRing(const std::filesystem::path &path, const size_t size,
+        const int level) {
+    if(level < -3 || level > 2) {
+        throw std::invalid_argument("invalid log level (must be [-3, 2])");
+    }
+
+    const auto severity = TranslateLogLevel(level);
+    auto appender = new RingLogAppender<FastTxtFormatter>(path, size, severity);
+
+    plog::get()->addAppender(appender);
+    gAppenders.push_back(appender);
+
+    gRingLogSeverity.store(std::max(gRingLogSeverity.load(std::memory_order_relaxed), severity),
+            std::memory_order_relaxed);
+    UpdateLoggerSeverity();
+}
+
+
+/**
+ * @brief Send log messages to a binary log file
+ *
+ * Records logged with the `TLOGB_*` macros are written to the file without being formatted;
+ * regular log messages are written to it as well, preformatted. The file can be converted to
+ * text with the `tristlib-logdecode` tool.
+ *
+ * @remark Records are buffered in memory; they're written to the file when the buffer fills up,
+ *         or when `FlushLogs()` is called (which happens on exit.)
+ *
+ * @param path Path to the log file; records are appended to it if it exists
+ */
+void AddLogDestinationBinary(const std::filesystem::path &path) {
+    auto appender = new BinaryLogAppender(path);
+    RegisterFlushAtExit();
+
+    BinaryLogAppender::Register(appender);
+    InstallAppender(appender);
+}
+
 
 
 /**
@@ -186,6 +422,91 @@ void SetLogLevel(const int logLevel) {
         throw std::invalid_argument("invalid log level (must be [-3, 2])");
     }
 
-    plog::get()->setMaxSeverity(TranslateLogLevel(logLevel));
+    detail::gLogSeverity.store(TranslateLogLevel(logLevel), std::memory_order_relaxed);
+    UpdateLoggerSeverity();
+}
+
+/**
+ * @brief Update the log level of a module
+ *
+ * Records logged with the `TLOG_*` macros for this module use this level, rather than the global
+ * log level. It can be both higher and lower than the global level.
+ *
+ * @param module Name of the module
+ * @param logLevel What level messages to output ([-3, 2]) where 2 is the most
+ */
+void SetLogLevel(const std::string_view module, const int logLevel) {
+    if(logLevel < -3 || logLevel > 2) {
+        throw std::invalid_argument("invalid log level (must be [-3, 2])");
+    }
+
+    std::lock_guard lg(gModuleLevelsLock);
+    gModuleLevels.insert_or_assign(std::string(module), TranslateLogLevel(logLevel));
+    detail::gLogLevelGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Remove the log level override of a module
+ *
+ * The module's records are subsequently filtered by the global log level.
+ *
+ * @param module Name of the module
+ */
+void ClearLogLevel(const std::string_view module) {
+    std::lock_guard lg(gModuleLevelsLock);
+    if(auto it = gModuleLevels.find(module); it != gModuleLevels.end()) {
+        gModuleLevels.erase(it);
+        detail::gLogLevelGeneration.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Determine the effective log level of a call site's module
+ *
+ * This is the module's override, if one is set, otherwise the global log level; if logging has
+ * not been initialized, nothing is logged.
+ *
+ * @return New cached value (generation, ring log severity and maximum severity)
+ */
+uint64_t LogModuleSite::refresh() noexcept {
+    std::lock_guard lg(gModuleLevelsLock);
+    const uint64_t generation = detail::gLogLevelGeneration.load(std::memory_order_relaxed);
+
+    plog::Severity level{plog::none}, ringLevel{plog::none};
+    if(plog::get()) {
+        auto it = gModuleLevels.find(this->module);
+        level = (it != gModuleLevels.end()) ? it->second :
+            detail::gLogSeverity.load(std::memory_order_relaxed);
+        ringLevel = gRingLogSeverity.load(std::memory_order_relaxed);
+    }
+
+    const uint64_t value = (generation << 32) | (ringLevel << 8) | level;
+    this->cached.store(value, std::memory_order_relaxed);
+    return value;
+}
+
+/**
+ * @brief Flush asynchronous and buffered log destinations
+ *
+ * Wait until all records queued or buffered by log destinations so far have been written. This
+ * is invoked automatically on exit.
+ */
+void FlushLogs() {
+    for(auto appender : gAppenders) {
+        if(auto flushable = dynamic_cast<FlushableAppender *>(appender)) {
+            flushable->flush();
+        }
+    }
+}
+
+/**
+ * @brief Get the number of dropped log records
+ *
+ * Records may be dropped by asynchronous log destinations whose queues overflowed.
+ *
+ * @return Total number of records dropped since startup
+ */
+size_t GetDroppedLogCount() noexcept {
+    return gDroppedLogRecords.load(std::memory_order_relaxed);
 }
 }
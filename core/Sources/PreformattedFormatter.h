@@ -0,0 +1,35 @@
+/**
+ * @file
+ *
+ * @brief Formatter for records that were formatted already
+ *
+ * Used by appenders that are wrapped by an asynchronous appender: the record is formatted on the
+ * thread that logged it, and the resulting string is passed through unmodified.
+ */
+#ifndef PREFORMATTEDFORMATTER_H
+#define PREFORMATTEDFORMATTER_H
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+namespace TristLib::Core {
+/**
+ * @brief plog Formatter that outputs a record's message as-is
+ *
+ * The message of the record must already have been formatted with `Formatter`; that formatter's
+ * header is still used for new files.
+ */
+template<class Formatter>
+class PreformattedFormatter {
+    public:
+        static plog::util::nstring header() {
+            return Formatter::header();
+        }
+
+        static plog::util::nstring format(const plog::Record &record) {
+            return record.getMessage();
+        }
+};
+}
+
+#endif
@@ -0,0 +1,199 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include "RingLogAppender.h"
+
+using namespace TristLib::Core;
+
+thread_local std::vector<RingLogAppenderBase::ThreadChunk> RingLogAppenderBase::gThreadChunks;
+
+/**
+ * @brief Identifier to assign to the next ring log appender
+ */
+static std::atomic<uint64_t> gNextAppenderId{1};
+
+/**
+ * @brief Create the ring file
+ *
+ * Any existing file at the path is first renamed (by appending `.prev` to its name) so that the
+ * ring of a previous, possibly crashed, run isn't overwritten.
+ *
+ * @param path Path to the ring file
+ * @param size Size of the ring (excluding the header); rounded down to a whole number of chunks
+ * @param maxSeverity Least severe records to keep in the ring
+ */
+RingLogAppenderBase::RingLogAppenderBase(const std::filesystem::path &path, const size_t size,
+        const plog::Severity maxSeverity) : maxSeverity(maxSeverity), id(gNextAppenderId++) {
+    using namespace RingLog;
+
+    this->numChunks = std::max(size / kChunkSize, size_t{4});
+    this->mapSize = kHeaderSize + (this->numChunks * kChunkSize);
+    this->chunkStates = std::make_unique<std::atomic<uint32_t>[]>(this->numChunks);
+
+    // preserve the previous ring, and create the file
+    std::error_code ec;
+    if(std::filesystem::exists(path, ec)) {
+        auto prevPath = path;
+        prevPath += ".prev";
+        std::filesystem::rename(path, prevPath, ec);
+    }
+
+    this->fd = open(path.native().c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(this->fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "open ring log");
+    }
+
+    // allocate the entire file now, so writes to the mapping can't fail later
+    if(const auto err = posix_fallocate(this->fd, 0, this->mapSize)) {
+        close(this->fd);
+        throw std::system_error(err, std::generic_category(), "allocate ring log");
+    }
+
+    auto ptr = mmap(nullptr, this->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if(ptr == MAP_FAILED) {
+        const auto err = errno;
+        close(this->fd);
+        throw std::system_error(err, std::generic_category(), "map ring log");
+    }
+    this->base = static_cast<std::byte *>(ptr);
+
+    // write the header
+    auto header = new(this->base) FileHeader{};
+    memcpy(header->magic, kMagic.data(), kMagic.size());
+    header->version = kVersion;
+    header->chunkSize = kChunkSize;
+    header->numChunks = this->numChunks;
+}
+
+/**
+ * @brief Unmap and close the ring file
+ */
+RingLogAppenderBase::~RingLogAppenderBase() {
+    munmap(this->base, this->mapSize);
+    close(this->fd);
+}
+
+/**
+ * @brief Copy a formatted record into the ring
+ *
+ * Messages that don't fit into a single chunk are truncated.
+ *
+ * @param message Formatted record
+ */
+void RingLogAppenderBase::append(std::string_view message) {
+    using namespace RingLog;
+
+    if(message.size() > kMaxMessageLength) {
+        message = message.substr(0, kMaxMessageLength);
+    }
+    const size_t recordSize = (sizeof(RecordHeader) + message.size() + 7) & ~size_t{7};
+
+    auto header = reinterpret_cast<FileHeader *>(this->base);
+    auto &chunk = this->getThreadChunk();
+
+    // register as writer of the chunk, and make sure it wasn't reserved again in the meantime
+    std::atomic<uint32_t> *state;
+    while(true) {
+        if(!chunk.chunk || chunk.used + recordSize > kChunkSize) {
+            this->reserveChunk(chunk);
+        }
+
+        state = &this->chunkStates[chunk.slot];
+        state->fetch_add(1);
+
+        auto chunkHeader = reinterpret_cast<ChunkHeader *>(chunk.chunk);
+        if(chunkHeader->number.load() == chunk.number) {
+            break;
+        }
+
+        state->fetch_sub(1, std::memory_order_release);
+        chunk.chunk = nullptr;
+    }
+
+    auto record = reinterpret_cast<RecordHeader *>(chunk.chunk + chunk.used);
+
+    record->length = message.size();
+    record->sequence = header->nextSequence.fetch_add(1, std::memory_order_relaxed);
+    record->chunkTag = chunk.tag;
+    memcpy(chunk.chunk + chunk.used + sizeof(RecordHeader), message.data(), message.size());
+
+    record->size.store(recordSize, std::memory_order_release);
+    chunk.used += recordSize;
+
+    state->fetch_sub(1, std::memory_order_release);
+}
+
+/**
+ * @brief Get the calling thread's chunk for this appender
+ */
+RingLogAppenderBase::ThreadChunk &RingLogAppenderBase::getThreadChunk() {
+    for(auto &chunk : gThreadChunks) {
+        if(chunk.appenderId == this->id) {
+            return chunk;
+        }
+    }
+
+    return gThreadChunks.emplace_back(ThreadChunk{this->id, nullptr, 0, 0, 0, 0});
+}
+
+/**
+ * @brief Reserve the next chunk of the ring for the calling thread
+ *
+ * The chunk (which holds the oldest data in the ring) is cleared, so that stale records are not
+ * mistaken for new ones. Before clearing it, its number is zeroed, and any threads still writing
+ * to it are waited for; they'll notice that the number changed, and reserve another chunk.
+ *
+ * If the chunk was meanwhile reserved under a later number by another thread (which can happen
+ * when many threads are logging into a small ring) it's left alone, and the next one is taken.
+ */
+void RingLogAppenderBase::reserveChunk(ThreadChunk &chunk) {
+    using namespace RingLog;
+
+    auto header = reinterpret_cast<FileHeader *>(this->base);
+
+    while(true) {
+        const auto number = header->nextChunk.fetch_add(1, std::memory_order_relaxed);
+        const auto slot = number % this->numChunks;
+
+        auto ptr = this->base + kHeaderSize + (slot * kChunkSize);
+        auto chunkHeader = reinterpret_cast<ChunkHeader *>(ptr);
+        auto &state = this->chunkStates[slot];
+
+        // take exclusive ownership of the slot, unless it's already past this number
+        while(state.fetch_or(kReserving, std::memory_order_acquire) & kReserving) {
+            std::this_thread::yield();
+        }
+        if(chunkHeader->number.load(std::memory_order_relaxed) > number + 1) {
+            state.fetch_and(~kReserving, std::memory_order_release);
+            continue;
+        }
+
+        // invalidate the chunk, then wait for its writers to leave
+        chunkHeader->number.store(0);
+        while(state.load() != kReserving) {
+            std::this_thread::yield();
+        }
+
+        memset(ptr + sizeof(ChunkHeader), 0, kChunkSize - sizeof(ChunkHeader));
+        chunkHeader->tid = plog::util::gettid();
+        chunkHeader->number.store(number + 1, std::memory_order_release);
+
+        state.fetch_and(~kReserving, std::memory_order_release);
+
+        chunk.chunk = ptr;
+        chunk.used = sizeof(ChunkHeader);
+        chunk.number = number + 1;
+        chunk.slot = slot;
+        chunk.tag = static_cast<uint32_t>(number + 1);
+        return;
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file
+ *
+ * @brief Memory mapped ring log appender
+ *
+ * Writes formatted records into a fixed size, memory mapped ring file.
+ */
+#ifndef RINGLOGAPPENDER_H
+#define RINGLOGAPPENDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#define PLOG_OMIT_LOG_DEFINES 1
+#include <plog/Log.h>
+
+#include "TristLib/Core/RingLog.h"
+
+namespace TristLib::Core {
+/**
+ * @brief Ring log writer
+ *
+ * Each thread reserves a chunk of the ring with a single atomic increment, then copies records
+ * into it; records are committed by a release store of their size. Since the file is a shared
+ * mapping, records survive in the page cache even if the process crashes.
+ *
+ * Once the ring wraps around, a chunk may be reserved again while a thread is still filling it.
+ * Writers therefore register with the chunk's slot before writing, and check that the chunk
+ * number still matches theirs; a thread reserving the slot waits for registered writers to leave
+ * before clearing it, and a writer that finds its chunk was taken away reserves another one.
+ */
+class RingLogAppenderBase: public plog::IAppender {
+    private:
+        /**
+         * @brief Chunk currently being filled by a thread
+         */
+        struct ThreadChunk {
+            /// Appender that the chunk belongs to
+            uint64_t appenderId;
+            /// Start of the chunk
+            std::byte *chunk;
+            /// Number of bytes used in the chunk
+            size_t used;
+            /// Chunk number (as stored in its header) that the thread reserved
+            uint64_t number;
+            /// Index of the chunk in the ring
+            size_t slot;
+            /// Chunk tag for records
+            uint32_t tag;
+        };
+
+        /// Chunk state flag set while a thread is reserving (and clearing) the chunk
+        constexpr static const uint32_t kReserving{1U << 31};
+
+    public:
+        RingLogAppenderBase(const std::filesystem::path &path, const size_t size,
+                const plog::Severity maxSeverity);
+        ~RingLogAppenderBase() override;
+
+    protected:
+        void append(std::string_view message);
+
+        /// Least severe records to keep in the ring
+        const plog::Severity maxSeverity;
+
+    private:
+        ThreadChunk &getThreadChunk();
+        void reserveChunk(ThreadChunk &chunk);
+
+    private:
+        static thread_local std::vector<ThreadChunk> gThreadChunks;
+
+        /// Unique identifier of this appender
+        const uint64_t id;
+
+        /// File descriptor of the ring file
+        int fd{-1};
+        /// Base of the file mapping
+        std::byte *base{nullptr};
+        /// Total size of the mapping
+        size_t mapSize{0};
+        /// Number of chunks
+        size_t numChunks{0};
+        /**
+         * @brief State of each chunk
+         *
+         * Holds the number of threads currently writing to the chunk, and the `kReserving` flag.
+         */
+        std::unique_ptr<std::atomic<uint32_t>[]> chunkStates;
+};
+
+/**
+ * @brief plog Appender writing to a memory mapped ring file
+ */
+template<class Formatter>
+class RingLogAppender: public RingLogAppenderBase {
+    public:
+        using RingLogAppenderBase::RingLogAppenderBase;
+
+        /**
+         * @brief Format message and copy it into the ring, if it passes the ring's log level
+         */
+        void write(const plog::Record &record) override {
+            if(record.getSeverity() > this->maxSeverity) {
+                return;
+            }
+            this->append(Formatter::format(record));
+        }
+};
+}
+
+#endif
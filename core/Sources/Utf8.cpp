@@ -0,0 +1,408 @@
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+// vector helpers are only ever inlined into functions compiled for the matching instruction set
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#include "TristLib/Core/Utf8.h"
+
+using namespace TristLib::Core;
+
+namespace {
+/**
+ * @brief Validate UTF-8 one code point at a time
+ *
+ * Used on processors without vector support, and for short strings.
+ */
+bool ValidateScalar(const uint8_t *data, const size_t length) {
+    size_t i{0};
+
+    while(i < length) {
+        // skip runs of ASCII eight bytes at a time
+        if(i + 8 <= length) {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(word));
+            if(!(word & 0x8080'8080'8080'8080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        const uint8_t lead = data[i];
+        if(lead < 0x80) {
+            i++;
+            continue;
+        }
+
+        // determine sequence length and the valid range of the second byte
+        size_t numBytes;
+        uint8_t min{0x80}, max{0xBF};
+
+        if(lead >= 0xC2 && lead <= 0xDF) {
+            numBytes = 2;
+        } else if(lead >= 0xE0 && lead <= 0xEF) {
+            numBytes = 3;
+            if(lead == 0xE0) {
+                min = 0xA0;
+            } else if(lead == 0xED) {
+                max = 0x9F;
+            }
+        } else if(lead >= 0xF0 && lead <= 0xF4) {
+            numBytes = 4;
+            if(lead == 0xF0) {
+                min = 0x90;
+            } else if(lead == 0xF4) {
+                max = 0x8F;
+            }
+        } else {
+            return false;
+        }
+
+        if(length - i < numBytes || data[i + 1] < min || data[i + 1] > max) {
+            return false;
+        }
+        for(size_t j = 2; j < numBytes; j++) {
+            if((data[i + j] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+
+        i += numBytes;
+    }
+
+    return true;
+}
+
+#if defined(__x86_64__)
+/*
+ * Error bits produced by the lookup tables; each is set for the pair of (previous, current) byte
+ * classes that indicate that error.
+ */
+constexpr uint8_t kTooShort{1 << 0};
+constexpr uint8_t kTooLong{1 << 1};
+constexpr uint8_t kOverlong3{1 << 2};
+constexpr uint8_t kTooLarge{1 << 3};
+constexpr uint8_t kSurrogate{1 << 4};
+constexpr uint8_t kOverlong2{1 << 5};
+constexpr uint8_t kTooLarge1000{1 << 6};
+constexpr uint8_t kOverlong4{1 << 6};
+constexpr uint8_t kTwoConts{1 << 7};
+constexpr uint8_t kCarry{kTooShort | kTooLong | kTwoConts};
+
+/// Error flags, indexed by the high nibble of the previous byte
+alignas(32) constexpr uint8_t kByte1High[32]{
+    // 0___: ASCII
+    kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+    // 10__: continuation
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    // 1100, 1101: two byte lead
+    kTooShort | kOverlong2, kTooShort,
+    // 1110: three byte lead
+    kTooShort | kOverlong3 | kSurrogate,
+    // 1111: four byte lead
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+
+    kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    kTooShort | kOverlong2, kTooShort,
+    kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+
+/// Error flags, indexed by the low nibble of the previous byte
+alignas(32) constexpr uint8_t kByte1Low[32]{
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4, kCarry | kOverlong2, kCarry, kCarry,
+    kCarry | kTooLarge, kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4, kCarry | kOverlong2, kCarry, kCarry,
+    kCarry | kTooLarge, kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate, kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+
+/// Error flags, indexed by the high nibble of the current byte
+alignas(32) constexpr uint8_t kByte2High[32]{
+    // 0___: ASCII
+    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+    // 1000, 1001, 101_: continuation
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    // 11__: lead byte
+    kTooShort, kTooShort, kTooShort, kTooShort,
+
+    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort, kTooShort, kTooShort, kTooShort,
+};
+
+/// Largest value of the last bytes of a block that don't begin an incomplete sequence
+alignas(32) constexpr uint8_t kIncompleteMax[32]{
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0b1111'0000 - 1, 0b1110'0000 - 1, 0b1100'0000 - 1,
+};
+
+/**
+ * @brief SSSE3 implementation, processing 16 bytes at a time
+ */
+struct Sse {
+    using Vector = __m128i;
+    constexpr static const size_t kSize{16};
+
+    __attribute__((target("ssse3")))
+    static inline Vector Load(const uint8_t *ptr) {
+        return _mm_loadu_si128(reinterpret_cast<const Vector *>(ptr));
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector Zero() {
+        return _mm_setzero_si128();
+    }
+    __attribute__((target("ssse3")))
+    static inline bool IsAscii(const Vector v) {
+        return !_mm_movemask_epi8(v);
+    }
+    __attribute__((target("ssse3")))
+    static inline bool IsZero(const Vector v) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector Lookup(const uint8_t *table, const Vector index) {
+        return _mm_shuffle_epi8(Load(table), index);
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector HighNibble(const Vector v) {
+        return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector LowNibble(const Vector v) {
+        return _mm_and_si128(v, _mm_set1_epi8(0x0F));
+    }
+    template<int N>
+    __attribute__((target("ssse3")))
+    static inline Vector Prev(const Vector input, const Vector prev) {
+        return _mm_alignr_epi8(input, prev, 16 - N);
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector SubSat(const Vector a, const uint8_t b) {
+        return _mm_subs_epu8(a, _mm_set1_epi8(static_cast<char>(b)));
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector Incomplete(const Vector input) {
+        return _mm_subs_epu8(input, Load(kIncompleteMax + 16));
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector And(const Vector a, const Vector b) {
+        return _mm_and_si128(a, b);
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector Or(const Vector a, const Vector b) {
+        return _mm_or_si128(a, b);
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector Xor(const Vector a, const Vector b) {
+        return _mm_xor_si128(a, b);
+    }
+    __attribute__((target("ssse3")))
+    static inline Vector Set1(const uint8_t value) {
+        return _mm_set1_epi8(static_cast<char>(value));
+    }
+};
+
+/**
+ * @brief AVX2 implementation, processing 32 bytes at a time
+ */
+struct Avx2 {
+    using Vector = __m256i;
+    constexpr static const size_t kSize{32};
+
+    __attribute__((target("avx2")))
+    static inline Vector Load(const uint8_t *ptr) {
+        return _mm256_loadu_si256(reinterpret_cast<const Vector *>(ptr));
+    }
+    __attribute__((target("avx2")))
+    static inline Vector Zero() {
+        return _mm256_setzero_si256();
+    }
+    __attribute__((target("avx2")))
+    static inline bool IsAscii(const Vector v) {
+        return !_mm256_movemask_epi8(v);
+    }
+    __attribute__((target("avx2")))
+    static inline bool IsZero(const Vector v) {
+        return _mm256_testz_si256(v, v);
+    }
+    __attribute__((target("avx2")))
+    static inline Vector Lookup(const uint8_t *table, const Vector index) {
+        return _mm256_shuffle_epi8(Load(table), index);
+    }
+    __attribute__((target("avx2")))
+    static inline Vector HighNibble(const Vector v) {
+        return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+    }
+    __attribute__((target("avx2")))
+    static inline Vector LowNibble(const Vector v) {
+        return _mm256_and_si256(v, _mm256_set1_epi8(0x0F));
+    }
+    template<int N>
+    __attribute__((target("avx2")))
+    static inline Vector Prev(const Vector input, const Vector prev) {
+        // shifting across the 128-bit lanes needs the previous block's upper lane first
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+    }
+    __attribute__((target("avx2")))
+    static inline Vector SubSat(const Vector a, const uint8_t b) {
+        return _mm256_subs_epu8(a, _mm256_set1_epi8(static_cast<char>(b)));
+    }
+    __attribute__((target("avx2")))
+    static inline Vector Incomplete(const Vector input) {
+        return _mm256_subs_epu8(input, Load(kIncompleteMax));
+    }
+    __attribute__((target("avx2")))
+    static inline Vector And(const Vector a, const Vector b) {
+        return _mm256_and_si256(a, b);
+    }
+    __attribute__((target("avx2")))
+    static inline Vector Or(const Vector a, const Vector b) {
+        return _mm256_or_si256(a, b);
+    }
+    __attribute__((target("avx2")))
+    static inline Vector Xor(const Vector a, const Vector b) {
+        return _mm256_xor_si256(a, b);
+    }
+    __attribute__((target("avx2")))
+    static inline Vector Set1(const uint8_t value) {
+        return _mm256_set1_epi8(static_cast<char>(value));
+    }
+};
+
+/**
+ * @brief Vectorized validator state
+ *
+ * Errors are accumulated across blocks, and only checked at the end.
+ */
+template<class Impl>
+struct Validator {
+    using Vector = typename Impl::Vector;
+
+    /// Accumulated errors
+    Vector error;
+    /// Previous block
+    Vector prevInput;
+    /// Whether the previous block ended with an incomplete sequence
+    Vector prevIncomplete;
+
+    /**
+     * @brief Check a block of input
+     */
+    inline void check(const Vector &input) {
+        if(Impl::IsAscii(input)) {
+            this->error = Impl::Or(this->error, this->prevIncomplete);
+        } else {
+            // check for invalid byte pairs
+            const auto prev1 = Impl::template Prev<1>(input, this->prevInput);
+            const auto special = Impl::And(Impl::And(
+                        Impl::Lookup(kByte1High, Impl::HighNibble(prev1)),
+                        Impl::Lookup(kByte1Low, Impl::LowNibble(prev1))),
+                    Impl::Lookup(kByte2High, Impl::HighNibble(input)));
+
+            // check that third and fourth bytes of sequences are continuations
+            const auto prev2 = Impl::template Prev<2>(input, this->prevInput);
+            const auto prev3 = Impl::template Prev<3>(input, this->prevInput);
+            const auto must23 = Impl::Or(Impl::SubSat(prev2, 0xE0 - 0x80),
+                    Impl::SubSat(prev3, 0xF0 - 0x80));
+            const auto must23_80 = Impl::And(must23, Impl::Set1(0x80));
+
+            this->error = Impl::Or(this->error, Impl::Xor(must23_80, special));
+            this->prevIncomplete = Impl::Incomplete(input);
+        }
+
+        this->prevInput = input;
+    }
+};
+
+/**
+ * @brief Validate a string using the given vector implementation
+ */
+template<class Impl>
+inline bool ValidateVector(const uint8_t *data, const size_t length) {
+    constexpr auto kSize = Impl::kSize;
+
+    Validator<Impl> state{Impl::Zero(), Impl::Zero(), Impl::Zero()};
+
+    size_t i{0};
+    for(; i + kSize <= length; i += kSize) {
+        state.check(Impl::Load(data + i));
+    }
+
+    // pad the tail with ASCII (zero) bytes
+    if(i < length) {
+        alignas(32) uint8_t tail[kSize]{};
+        memcpy(tail, data + i, length - i);
+        state.check(Impl::Load(tail));
+    }
+
+    return Impl::IsZero(Impl::Or(state.error, state.prevIncomplete));
+}
+
+__attribute__((target("ssse3"), flatten))
+bool ValidateSse(const uint8_t *data, const size_t length) {
+    return ValidateVector<Sse>(data, length);
+}
+
+__attribute__((target("avx2"), flatten))
+bool ValidateAvx2(const uint8_t *data, const size_t length) {
+    return ValidateVector<Avx2>(data, length);
+}
+#endif
+
+/**
+ * @brief Select the best validator for this processor
+ */
+auto SelectValidator() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2")) {
+        return &ValidateAvx2;
+    } else if(__builtin_cpu_supports("ssse3")) {
+        return &ValidateSse;
+    }
+#endif
+    return &ValidateScalar;
+}
+}
+
+/**
+ * @brief Determine whether a buffer contains well-formed UTF-8
+ *
+ * @param data Buffer to check
+ * @param length Number of bytes in the buffer
+ *
+ * @return Whether the buffer is valid UTF-8
+ */
+bool TristLib::Core::IsValidUtf8(const void *data, const size_t length) {
+    // short strings aren't worth the setup of the vector code
+    if(length < 16) {
+        return ValidateScalar(static_cast<const uint8_t *>(data), length);
+    }
+
+    static const auto validator = SelectValidator();
+    return validator(static_cast<const uint8_t *>(data), length);
+}
@@ -0,0 +1,312 @@
+/**
+ * @file
+ *
+ * @brief Binary log decoder
+ *
+ * Renders a binary log file (written by a binary log destination) as text, in the same format as
+ * the regular text log destinations.
+ *
+ * Usage: `tristlib-logdecode <file>`
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "TristLib/Core/BinaryLog.h"
+#include "TristLib/Core/CborReader.h"
+
+namespace {
+/**
+ * @brief Decoded CBOR item
+ *
+ * Only the subset of CBOR written by the binary log encoder is supported.
+ */
+struct Item {
+    std::variant<std::monostate, uint64_t, int64_t, double, bool, std::string,
+        std::vector<Item>> value;
+
+    /// Get the item's value as an unsigned integer
+    uint64_t getUnsigned() const {
+        if(auto val = std::get_if<uint64_t>(&this->value)) {
+            return *val;
+        }
+        throw std::runtime_error("expected unsigned integer");
+    }
+
+    /// Get the item's value as a string
+    const std::string &getString() const {
+        if(auto val = std::get_if<std::string>(&this->value)) {
+            return *val;
+        }
+        throw std::runtime_error("expected string");
+    }
+
+    /// Get the item's value as an array
+    const std::vector<Item> &getArray() const {
+        if(auto val = std::get_if<std::vector<Item>>(&this->value)) {
+            return *val;
+        }
+        throw std::runtime_error("expected array");
+    }
+};
+
+/**
+ * @brief Call site definition read from the log
+ */
+struct Site {
+    std::string format, file, func;
+    uint64_t line;
+    plog::Severity severity;
+};
+
+/**
+ * @brief Read a complete item from the reader
+ *
+ * The entire file is fed to the reader at once, so running out of data means it's truncated.
+ *
+ * @return Item read, or an empty optional if the end of a container was reached
+ */
+std::optional<Item> ReadItem(TristLib::Core::CborReader &reader) {
+    using Type = TristLib::Core::CborReader::Type;
+
+    auto item = reader.next();
+    while(item.type == Type::Tag) {
+        item = reader.next();
+    }
+
+    switch(item.type) {
+        case Type::NeedMore:
+            throw std::runtime_error("unexpected end of file");
+        case Type::End:
+            return std::nullopt;
+
+        case Type::Unsigned:
+            return Item{item.value};
+        case Type::Negative:
+            return Item{item.getInt()};
+        case Type::Float:
+            return Item{item.number};
+        case Type::Bool:
+            return Item{item.value != 0};
+        case Type::Null:
+        case Type::Undefined:
+            return Item{};
+
+        case Type::ByteString:
+        case Type::TextString: {
+            std::string str;
+            if(item.value == TristLib::Core::CborReader::kIndefinite) {
+                while(auto chunk = ReadItem(reader)) {
+                    str.append(chunk->getString());
+                }
+                return Item{std::move(str)};
+            }
+
+            str.append(item.getString());
+            while(item.partial) {
+                item = reader.next();
+                if(item.type == Type::NeedMore) {
+                    throw std::runtime_error("unexpected end of file");
+                }
+                str.append(item.getString());
+            }
+            return Item{std::move(str)};
+        }
+
+        case Type::ArrayStart: {
+            std::vector<Item> items;
+            while(auto child = ReadItem(reader)) {
+                items.emplace_back(std::move(*child));
+            }
+            return Item{std::move(items)};
+        }
+
+        case Type::MapStart:
+            // not written by the encoder; ignore its contents
+            reader.skip();
+            return Item{};
+
+        default:
+            throw std::runtime_error("unsupported item type");
+    }
+}
+
+/**
+ * @brief Render a log argument as text
+ */
+std::string FormatArg(const Item &item) {
+    return std::visit([](const auto &value) -> std::string {
+        using Type = std::decay_t<decltype(value)>;
+
+        if constexpr(std::is_same_v<Type, std::monostate>) {
+            return "null";
+        } else if constexpr(std::is_same_v<Type, bool>) {
+            return value ? "true" : "false";
+        } else if constexpr(std::is_same_v<Type, std::string>) {
+            return value;
+        } else if constexpr(std::is_same_v<Type, double>) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%g", value);
+            return buf;
+        } else if constexpr(std::is_same_v<Type, std::vector<Item>>) {
+            return "[array]";
+        } else {
+            return std::to_string(value);
+        }
+    }, item.value);
+}
+
+/**
+ * @brief Substitute arguments into a format string
+ *
+ * Each `{}` placeholder is replaced with the next argument; any excess arguments are appended.
+ */
+std::string FormatMessage(std::string_view format, const std::vector<Item> &args) {
+    std::string out;
+    size_t next{0};
+
+    while(!format.empty()) {
+        const auto pos = format.find("{}");
+        if(pos == std::string_view::npos || next == args.size()) {
+            out.append(format);
+            break;
+        }
+
+        out.append(format.substr(0, pos));
+        out.append(FormatArg(args[next++]));
+        format.remove_prefix(pos + 2);
+    }
+
+    for(; next < args.size(); next++) {
+        out.push_back(' ');
+        out.append(FormatArg(args[next]));
+    }
+
+    return out;
+}
+
+/**
+ * @brief Print a record in the same layout as the plog text formatter
+ */
+void PrintRecord(const uint64_t timestamp, const plog::Severity severity, const uint64_t tid,
+        std::string_view func, const uint64_t line, std::string_view message) {
+    const time_t secs = timestamp / 1'000'000'000ULL;
+    const unsigned int millis = (timestamp / 1'000'000ULL) % 1000;
+
+    struct tm tm;
+    localtime_r(&secs, &tm);
+    char timeBuf[32];
+    strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S", &tm);
+
+    printf("%s.%03u %-5s [%llu] [%.*s@%llu] %.*s\n", timeBuf, millis,
+            plog::severityToString(severity), static_cast<unsigned long long>(tid),
+            static_cast<int>(func.size()), func.data(), static_cast<unsigned long long>(line),
+            static_cast<int>(message.size()), message.data());
+}
+}
+
+int main(int argc, const char **argv) {
+    using namespace TristLib::Core;
+
+    if(argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if(!file) {
+        std::cerr << "failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+    const std::string data{std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>()};
+
+    CborReader reader;
+    reader.feed(std::as_bytes(std::span{data}));
+    std::unordered_map<uint64_t, Site> sites;
+
+    try {
+        while(reader.getOffset() != data.size()) {
+            const auto item = ReadItem(reader);
+            if(!item) {
+                throw std::runtime_error("unexpected end of container");
+            }
+            const auto &record = item->getArray();
+            if(record.empty()) {
+                throw std::runtime_error("empty record");
+            }
+
+            switch(record[0].getUnsigned()) {
+                case BinaryLog::RecordType::Header:
+                    if(record.size() < 3 || record[1].getString() != BinaryLog::kMagic) {
+                        throw std::runtime_error("invalid header");
+                    } else if(record[2].getUnsigned() > BinaryLog::kVersion) {
+                        throw std::runtime_error("unsupported version");
+                    }
+                    // a new session starts; site identifiers are reassigned
+                    sites.clear();
+                    break;
+
+                case BinaryLog::RecordType::Site:
+                    if(record.size() < 7) {
+                        throw std::runtime_error("invalid site record");
+                    }
+                    sites[record[1].getUnsigned()] = {
+                        .format = record[6].getString(),
+                        .file = record[3].getString(),
+                        .func = record[5].getString(),
+                        .line = record[4].getUnsigned(),
+                        .severity = static_cast<plog::Severity>(record[2].getUnsigned()),
+                    };
+                    break;
+
+                case BinaryLog::RecordType::Event: {
+                    if(record.size() < 5) {
+                        throw std::runtime_error("invalid event record");
+                    }
+                    const auto site = sites.find(record[1].getUnsigned());
+                    if(site == sites.end()) {
+                        throw std::runtime_error("event references unknown site");
+                    }
+                    const auto &info = site->second;
+
+                    PrintRecord(record[2].getUnsigned(), info.severity, record[3].getUnsigned(),
+                            info.func, info.line, FormatMessage(info.format,
+                                record[4].getArray()));
+                    break;
+                }
+
+                case BinaryLog::RecordType::Text:
+                    if(record.size() < 7) {
+                        throw std::runtime_error("invalid text record");
+                    }
+                    PrintRecord(record[1].getUnsigned(),
+                            static_cast<plog::Severity>(record[2].getUnsigned()),
+                            record[3].getUnsigned(), record[4].getString(),
+                            record[5].getUnsigned(), record[6].getString());
+                    break;
+
+                // skip unknown record types
+                default:
+                    break;
+            }
+        }
+    } catch(const std::exception &e) {
+        std::cerr << "failed to decode log: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
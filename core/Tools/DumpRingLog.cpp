@@ -0,0 +1,126 @@
+/**
+ * @file
+ *
+ * @brief Ring log extractor
+ *
+ * Prints the records stored in a ring log file (written by a ring log destination) in the order
+ * they were logged. This works on the files of crashed processes as well.
+ *
+ * Usage: `tristlib-ringdump <file>`
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "TristLib/Core/RingLog.h"
+
+using namespace TristLib::Core::RingLog;
+
+namespace {
+/**
+ * @brief A record found in the ring
+ */
+struct Record {
+    uint64_t sequence;
+    std::string_view message;
+};
+
+/**
+ * @brief Collect all valid records from a chunk
+ *
+ * Stops at the first record that isn't committed, or is inconsistent (for example, because it's
+ * left over from an older chunk, or was being written when the process crashed.)
+ */
+void ReadChunk(const std::byte *chunk, const size_t chunkSize, std::vector<Record> &records) {
+    auto header = reinterpret_cast<const ChunkHeader *>(chunk);
+    const auto number = header->number.load(std::memory_order_acquire);
+    if(!number) {
+        return;
+    }
+
+    size_t offset = sizeof(ChunkHeader);
+    while(offset + sizeof(RecordHeader) <= chunkSize) {
+        auto record = reinterpret_cast<const RecordHeader *>(chunk + offset);
+        const auto size = record->size.load(std::memory_order_acquire);
+
+        if(!size || size < sizeof(RecordHeader) || offset + size > chunkSize ||
+                record->length > size - sizeof(RecordHeader) ||
+                record->chunkTag != static_cast<uint32_t>(number)) {
+            break;
+        }
+
+        records.push_back({record->sequence, std::string_view(
+                    reinterpret_cast<const char *>(chunk + offset + sizeof(RecordHeader)),
+                    record->length)});
+        offset += size;
+    }
+}
+}
+
+int main(int argc, const char **argv) {
+    if(argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <file>" << std::endl;
+        return 1;
+    }
+
+    // map the file
+    const int fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+    if(fd == -1) {
+        std::cerr << "failed to open " << argv[1] << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    struct stat sb;
+    if(fstat(fd, &sb) || static_cast<size_t>(sb.st_size) < kHeaderSize) {
+        std::cerr << "invalid ring log (too small)" << std::endl;
+        return 1;
+    }
+
+    const size_t fileSize = sb.st_size;
+    auto ptr = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    if(ptr == MAP_FAILED) {
+        std::cerr << "failed to map file: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    auto base = static_cast<const std::byte *>(ptr);
+
+    // validate header
+    auto header = reinterpret_cast<const FileHeader *>(base);
+    if(std::string_view(header->magic, strnlen(header->magic, sizeof(header->magic))) != kMagic) {
+        std::cerr << "invalid ring log (bad magic)" << std::endl;
+        return 1;
+    } else if(header->version != kVersion) {
+        std::cerr << "unsupported ring log version " << header->version << std::endl;
+        return 1;
+    } else if(header->chunkSize < sizeof(ChunkHeader) + sizeof(RecordHeader) ||
+            (fileSize - kHeaderSize) / header->chunkSize < header->numChunks) {
+        std::cerr << "invalid ring log (bad geometry)" << std::endl;
+        return 1;
+    }
+
+    // collect records from all chunks, then print them in order
+    std::vector<Record> records;
+    for(size_t i = 0; i < header->numChunks; i++) {
+        ReadChunk(base + kHeaderSize + (i * header->chunkSize), header->chunkSize, records);
+    }
+
+    std::sort(records.begin(), records.end(), [](const auto &a, const auto &b) {
+        return a.sequence < b.sequence;
+    });
+
+    for(const auto &record : records) {
+        fwrite(record.message.data(), 1, record.message.size(), stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file
+ *
+ * @brief File hex dumper
+ *
+ * Prints the contents of a file in side-by-side hex and text formats (like `hexdump -C`); large
+ * files are formatted on multiple threads. Repeated lines are collapsed into a single `*` line,
+ * unless `-v` is specified.
+ *
+ * Usage: `tristlib-hexdump [-v] [-s offset] [-n length] <file>`
+ */
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <system_error>
+
+#include "TristLib/Core/HexDump.h"
+
+using namespace TristLib::Core;
+
+namespace {
+/**
+ * @brief Parse a size argument (decimal, or hex with a `0x` prefix)
+ */
+bool ParseSize(const char *str, size_t &out) {
+    char *end;
+    errno = 0;
+    const auto value = strtoull(str, &end, 0);
+    if(errno || end == str || *end) {
+        return false;
+    }
+    out = value;
+    return true;
+}
+}
+
+int main(int argc, char * const *argv) {
+    size_t offset{0}, length{HexDump::ToEnd};
+    bool collapse{true};
+
+    int c;
+    while((c = getopt(argc, argv, "vs:n:")) != -1) {
+        switch(c) {
+            case 'v':
+                collapse = false;
+                break;
+            case 's':
+                if(!ParseSize(optarg, offset)) {
+                    std::cerr << "invalid offset: " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            case 'n':
+                if(!ParseSize(optarg, length)) {
+                    std::cerr << "invalid length: " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            default:
+                std::cerr << "usage: " << argv[0] << " [-v] [-s offset] [-n length] <file>"
+                    << std::endl;
+                return 1;
+        }
+    }
+    if(optind != argc - 1) {
+        std::cerr << "usage: " << argv[0] << " [-v] [-s offset] [-n length] <file>" << std::endl;
+        return 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    try {
+        HexDump::DumpFile(std::cout, argv[optind], offset, length, collapse);
+    } catch(const std::system_error &e) {
+        std::cerr << "failed to dump " << argv[optind] << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
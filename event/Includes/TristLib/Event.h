@@ -2,10 +2,19 @@
 #define TRISTLIB_EVENT_H
 
 #include <TristLib/Event/RunLoop.h>
+#include <TristLib/Event/CborSink.h>
+#include <TristLib/Event/CborSource.h>
+#include <TristLib/Event/CountingFlag.h>
 #include <TristLib/Event/FileDescriptor.h>
+#include <TristLib/Event/FileQueue.h>
 #include <TristLib/Event/Flag.h>
+#include <TristLib/Event/InplaceFunction.h>
 #include <TristLib/Event/ListenSocket.h>
+#include <TristLib/Event/LoopAllocator.h>
+#include <TristLib/Event/SharedMemoryChannel.h>
+#include <TristLib/Event/SharedMemoryRing.h>
 #include <TristLib/Event/Timer.h>
+#include <TristLib/Event/WorkPool.h>
 #include <TristLib/Event/Signal.h>
 #include <TristLib/Event/Socket.h>
 #include <TristLib/Event/SystemWatchdog.h>
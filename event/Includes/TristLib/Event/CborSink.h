@@ -0,0 +1,65 @@
+#ifndef TRISTLIB_EVENT_CBORSINK_H
+#define TRISTLIB_EVENT_CBORSINK_H
+
+#include <cstddef>
+#include <cstring>
+
+struct evbuffer;
+
+namespace TristLib::Event {
+class Socket;
+
+/**
+ * @brief CBOR sink writing into a libevent buffer
+ *
+ * Use this as the sink of a `TristLib::Core::CborWriter` to encode directly into the output
+ * buffer of a socket (or any other evbuffer.) Space is reserved in the buffer in large blocks,
+ * and items are copied straight into it; the data only becomes part of the buffer once it's
+ * committed, which happens when the sink is destroyed, or by calling `commit()` explicitly.
+ *
+ * @remark The buffer must not be modified in any other way while the sink has uncommitted data.
+ */
+class EvbufferCborSink {
+    public:
+        /// Amount of space reserved in the buffer at a time
+        constexpr static const size_t kReserveSize{4096};
+
+    public:
+        EvbufferCborSink(struct evbuffer *buffer);
+        EvbufferCborSink(Socket &socket);
+        ~EvbufferCborSink();
+
+        EvbufferCborSink(const EvbufferCborSink &) = delete;
+        EvbufferCborSink &operator=(const EvbufferCborSink &) = delete;
+
+        /**
+         * @brief Copy encoded data into the buffer
+         */
+        inline void write(const void *data, const size_t length) {
+            if(length > static_cast<size_t>(this->end - this->cursor)) [[unlikely]] {
+                return this->writeSlow(data, length);
+            }
+
+            memcpy(this->cursor, data, length);
+            this->cursor += length;
+        }
+
+        void commit();
+
+    private:
+        void writeSlow(const void *data, const size_t length);
+
+    private:
+        /// Buffer to write to
+        struct evbuffer *buffer;
+
+        /// Start of the reserved space
+        std::byte *start{nullptr};
+        /// Current write position in the reserved space
+        std::byte *cursor{nullptr};
+        /// End of the reserved space
+        std::byte *end{nullptr};
+};
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef TRISTLIB_EVENT_CBORSOURCE_H
+#define TRISTLIB_EVENT_CBORSOURCE_H
+
+#include <cstddef>
+#include <type_traits>
+
+#include <TristLib/Core/CborReader.h>
+
+struct evbuffer;
+
+namespace TristLib::Event {
+class Socket;
+
+size_t ReadCbor(Core::CborReader &reader, struct evbuffer *buffer,
+        bool (*callback)(void *, const Core::CborReader::Item &), void *context);
+
+/**
+ * @brief Decode CBOR data from a libevent buffer
+ *
+ * All data currently in the buffer is fed to the reader, segment by segment, without copying or
+ * linearizing it. The callback is invoked for each item read; once the buffer's data has been
+ * consumed, it's drained. Any partial item remains in the reader's state, so this can be called
+ * again whenever more data arrives (such as from a socket's read callback.)
+ *
+ * The callback may return `false` to stop reading: any data past the last item read remains in
+ * the buffer.
+ *
+ * @param reader CBOR reader to feed data to
+ * @param buffer Buffer to read from
+ * @param callback Function invoked for each item, as `bool(const Core::CborReader::Item &)`
+ *
+ * @return Number of bytes consumed from the buffer
+ *
+ * @remark String data in items points into the buffer; it must be copied before returning from
+ *         the callback, if needed beyond that.
+ */
+template<class Callback>
+inline size_t ReadCbor(Core::CborReader &reader, struct evbuffer *buffer, Callback &&callback) {
+    using CallbackType = std::remove_reference_t<Callback>;
+
+    return ReadCbor(reader, buffer, [](void *ctx, const Core::CborReader::Item &item) -> bool {
+        return (*static_cast<CallbackType *>(ctx))(item);
+    }, const_cast<void *>(static_cast<const void *>(&callback)));
+}
+
+size_t ReadCbor(Core::CborReader &reader, Socket &socket,
+        bool (*callback)(void *, const Core::CborReader::Item &), void *context);
+
+/**
+ * @brief Decode CBOR data from a socket's input buffer
+ *
+ * @seeAlso ReadCbor
+ */
+template<class Callback>
+inline size_t ReadCbor(Core::CborReader &reader, Socket &socket, Callback &&callback) {
+    using CallbackType = std::remove_reference_t<Callback>;
+
+    return ReadCbor(reader, socket, [](void *ctx, const Core::CborReader::Item &item) -> bool {
+        return (*static_cast<CallbackType *>(ctx))(item);
+    }, const_cast<void *>(static_cast<const void *>(&callback)));
+}
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef TRISTLIB_EVENT_COUNTINGFLAG_H
+#define TRISTLIB_EVENT_COUNTINGFLAG_H
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "TristLib/Event/InplaceFunction.h"
+
+struct event;
+
+namespace TristLib::Event {
+class RunLoop;
+
+/**
+ * @brief Manually signalled event, backed by an eventfd
+ *
+ * Like `Flag`, this is an event that's signalled manually; but since it's backed by an eventfd
+ * rather than activating the libevent event directly, it may be signalled from any thread, from
+ * signal handlers, or even from other processes that share the descriptor.
+ *
+ * Any number of signals that arrive before the run loop gets around to handling the event are
+ * coalesced into a single invocation of the callback, which receives the accumulated count.
+ */
+class CountingFlag {
+    public:
+        /// Callback invoked when the flag is signalled, with the number of times it was signalled
+        using SignalCallback = InplaceFunction<void(CountingFlag *, const uint64_t)>;
+
+    public:
+        CountingFlag(const std::shared_ptr<RunLoop> &loop);
+        CountingFlag(const std::shared_ptr<RunLoop> &loop, const int fd, const bool closeFd = true);
+        ~CountingFlag();
+
+        void signal(const uint64_t count = 1) noexcept;
+
+        /**
+         * @brief Set event callback
+         *
+         * @param newCallback New callback to be invoked when the event is signalled
+         */
+        inline void setCallback(SignalCallback newCallback) {
+            this->callback = std::move(newCallback);
+        }
+
+        /**
+         * @brief Get the underlying eventfd
+         *
+         * This descriptor may be passed to another process, which can then signal the flag by
+         * writing an 8-byte count to it.
+         */
+        constexpr inline auto getFd() const {
+            return this->fd;
+        }
+
+        /**
+         * @brief Return the underlying libevent object
+         */
+        inline auto getEvent() const {
+            return this->event;
+        }
+
+    private:
+        void makeEvent(const std::shared_ptr<RunLoop> &);
+        void handleEvent();
+
+    private:
+        /// eventfd backing the flag
+        const int fd{-1};
+        /// Whether the eventfd is closed on deallocation
+        const bool closeFd{true};
+
+        /// event added to the event loop
+        struct event *event{nullptr};
+
+        /// Callback to invoke when the event is triggered
+        SignalCallback callback;
+};
+}
+
+#endif
@@ -2,12 +2,12 @@
 #define TRISTLIB_EVENT_FILEDESCRIPTOR_H
 
 #include <cstddef>
-#include <functional>
 #include <memory>
-#include <optional>
 #include <span>
 #include <utility>
 
+#include "TristLib/Event/InplaceFunction.h"
+
 struct event;
 
 namespace TristLib::Event {
@@ -22,7 +22,7 @@ class RunLoop;
 class FileDescriptor {
     public:
         /// Callback type for any events
-        typedef typename std::function<void(FileDescriptor *)> Callback;
+        typedef InplaceFunction<void(FileDescriptor *)> Callback;
 
     public:
         FileDescriptor(const std::shared_ptr<RunLoop> &loop, const int fd);
@@ -38,24 +38,24 @@ class FileDescriptor {
          *
          * @param newCallback New callback to be invoked whenever data is ready to be read
          */
-        inline void setReadCallback(const Callback &newCallback) {
-            this->readCallback = newCallback;
+        inline void setReadCallback(Callback newCallback) {
+            this->readCallback = std::move(newCallback);
         }
         /**
          * @brief Set write callback
          *
          * @param newCallback New callback to be invoked whenever write data can be accepted
          */
-        inline void setWriteCallback(const Callback &newCallback) {
-            this->writeCallback = newCallback;
+        inline void setWriteCallback(Callback newCallback) {
+            this->writeCallback = std::move(newCallback);
         }
         /**
          * @brief Set event callback
          *
          * @param newCallback New callback to be invoked for any error event
          */
-        inline void setEventCallback(const Callback &newCallback) {
-            this->eventCallback = newCallback;
+        inline void setEventCallback(Callback newCallback) {
+            this->eventCallback = std::move(newCallback);
         }
 
         /**
@@ -78,11 +78,11 @@ class FileDescriptor {
         bool readEnabled{false}, writeEnabled{false};
 
         /// Read callback
-        std::optional<Callback> readCallback;
+        Callback readCallback;
         /// Write callback
-        std::optional<Callback> writeCallback;
+        Callback writeCallback;
         /// Event callback
-        std::optional<Callback> eventCallback;
+        Callback eventCallback;
 
 };
 }
@@ -0,0 +1,146 @@
+#ifndef TRISTLIB_EVENT_FILEQUEUE_H
+#define TRISTLIB_EVENT_FILEQUEUE_H
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+struct event;
+struct io_uring;
+
+namespace TristLib::Event {
+class RunLoop;
+class WorkPool;
+
+/**
+ * @brief Asynchronous file IO
+ *
+ * Performs file IO (opening, reading, writing, syncing and allocating space) without blocking the
+ * run loop; when each operation completes, its callback is invoked on the run loop.
+ *
+ * Requests made during a single run loop iteration are collected, then submitted as a batch at
+ * the end of the iteration. If the system supports it, requests are executed through io_uring;
+ * otherwise, they are executed on a small thread pool.
+ *
+ * @remark Any buffers passed to requests must remain valid until the request's callback has been
+ *         invoked.
+ */
+class FileQueue {
+    public:
+        /**
+         * @brief Callback invoked when a request completes
+         *
+         * It receives the result of the operation: for reads and writes, the number of bytes
+         * transferred; for opens, the new file descriptor; otherwise zero. On failure, it receives
+         * a negated `errno` value instead.
+         */
+        using Callback = std::function<void(const int64_t)>;
+
+        /// Default number of requests that may be in flight on io_uring at once
+        constexpr static const size_t kDefaultDepth{64};
+        /// Number of threads in the fallback thread pool
+        constexpr static const size_t kPoolThreads{4};
+
+    private:
+        /// Types of requests
+        enum class Operation {
+            Open,
+            Read,
+            Write,
+            Sync,
+            Allocate,
+        };
+
+        /**
+         * @brief A single IO request
+         */
+        struct Request {
+            /// Type of request
+            Operation op;
+            /// File descriptor to operate on
+            int fd{-1};
+            /// Path to open
+            std::string path;
+            /// Flags to open the file with; for syncs, whether only data is synced; for
+            /// allocations, the `fallocate()` mode
+            int flags{0};
+            /// File mode to create the file with
+            mode_t mode{0};
+            /// Buffer to read into or write from
+            void *buffer{nullptr};
+            /// Length of the buffer, or the length of the region to allocate
+            size_t length{0};
+            /// File offset
+            off_t offset{0};
+
+            /// Function to invoke on completion
+            Callback callback;
+        };
+
+    public:
+        FileQueue(const std::shared_ptr<RunLoop> &loop, const size_t depth = kDefaultDepth);
+        ~FileQueue();
+
+        static bool SupportsIoUring() noexcept;
+
+        /**
+         * @brief Check whether this queue is backed by io_uring
+         */
+        inline bool isUsingIoUring() const {
+            return !!this->ring;
+        }
+
+        void open(const std::filesystem::path &path, const int flags, const mode_t mode,
+                const Callback &callback);
+        void read(const int fd, std::span<std::byte> buffer, const off_t offset,
+                const Callback &callback);
+        void write(const int fd, std::span<const std::byte> buffer, const off_t offset,
+                const Callback &callback);
+        void sync(const int fd, const bool dataOnly, const Callback &callback);
+        void allocate(const int fd, const int mode, const off_t offset, const off_t length,
+                const Callback &callback);
+
+    private:
+        void enqueue(std::unique_ptr<Request> &&request);
+        void submitPending();
+
+        void submitRing();
+        void reapRing();
+
+        void submitPool();
+
+        void release();
+
+        static int64_t Execute(const Request &request);
+
+    private:
+        /// Run loop on which requests complete
+        std::weak_ptr<RunLoop> loop;
+
+        /// Requests made during the current run loop iteration
+        std::vector<std::unique_ptr<Request>> pending;
+        /// Event activated to submit pending requests at the end of the run loop iteration
+        struct event *submitEvent{nullptr};
+
+        /// io_uring instance (if supported)
+        struct io_uring *ring{nullptr};
+        /// eventfd signalled by io_uring on completions
+        int ringEventFd{-1};
+        /// Event observing the completion eventfd; pending only while requests are in flight
+        struct event *ringEvent{nullptr};
+        /// Number of requests in flight on io_uring
+        size_t ringInFlight{0};
+
+        /// Fallback thread pool (if io_uring isn't supported)
+        std::unique_ptr<WorkPool> pool;
+};
+}
+
+#endif
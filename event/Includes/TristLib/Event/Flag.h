@@ -1,8 +1,10 @@
 #ifndef TRISTLIB_EVENT_FLAG_H
 #define TRISTLIB_EVENT_FLAG_H
 
-#include <functional>
 #include <memory>
+#include <utility>
+
+#include "TristLib/Event/InplaceFunction.h"
 
 struct event;
 
@@ -18,7 +20,7 @@ class RunLoop;
 class Flag {
     public:
         /// Callback invoked when the flag is signalled
-        typedef typename std::function<void(Flag *)> SignalCallback;
+        typedef InplaceFunction<void(Flag *)> SignalCallback;
 
     public:
         Flag(const std::shared_ptr<RunLoop> &loop);
@@ -31,8 +33,8 @@ class Flag {
          *
          * @param newCallback New callback to be invoked when the event is signalled
          */
-        inline void setCallback(const SignalCallback &newCallback) {
-            this->callback = newCallback;
+        inline void setCallback(SignalCallback newCallback) {
+            this->callback = std::move(newCallback);
         }
 
         /**
@@ -0,0 +1,200 @@
+#ifndef TRISTLIB_EVENT_INPLACEFUNCTION_H
+#define TRISTLIB_EVENT_INPLACEFUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace TristLib::Event {
+/// Default size of an inline callable's storage (enough for four pointers, or a `std::function`)
+constexpr static const size_t kInplaceFunctionSize{32};
+
+template<typename Signature, size_t Capacity = kInplaceFunctionSize>
+class InplaceFunction;
+
+namespace detail {
+/// Whether a callable may be null (and should then result in an empty function)
+template<typename F>
+constexpr static bool kIsNullable = std::is_pointer_v<F> || std::is_member_pointer_v<F>;
+template<typename... T>
+constexpr static bool kIsNullable<std::function<T...>> = true;
+}
+
+/**
+ * @brief Move-only callable wrapper with inline storage
+ *
+ * Works like `std::function`, except that the callable is always stored inside the wrapper:
+ * callables that don't fit (or can't be moved without throwing) are rejected at compile time,
+ * rather than moved to the heap. Invoking it is a single indirect call, through a static table
+ * of operations for the type of callable.
+ *
+ * Event sources hold their callbacks in these, so setting a callback never allocates. Callables
+ * with more state than fits should capture a pointer to it instead.
+ *
+ * Queues of arbitrary work, which can't bound the size of their callables, use `Box()` to move
+ * those that don't fit to the heap instead.
+ *
+ * Invoking an empty function throws `std::bad_function_call`.
+ */
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+    public:
+        InplaceFunction() = default;
+        InplaceFunction(std::nullptr_t) {}
+
+        /**
+         * @brief Store a callable
+         *
+         * Null function pointers and empty `std::function` objects result in an empty function.
+         */
+        template<typename F, typename Functor = std::decay_t<F>, typename = std::enable_if_t<
+            !std::is_same_v<Functor, InplaceFunction> &&
+            std::is_invocable_r_v<R, Functor &, Args...>>>
+        InplaceFunction(F &&f) {
+            static_assert(sizeof(Functor) <= Capacity, "callable too large for inline storage");
+            static_assert(alignof(Functor) <= alignof(Storage), "callable is overaligned");
+            static_assert(std::is_nothrow_move_constructible_v<Functor>,
+                    "callable must be nothrow move constructible");
+
+            if constexpr(detail::kIsNullable<Functor>) {
+                if(!f) {
+                    return;
+                }
+            }
+
+            ::new(static_cast<void *>(&this->storage)) Functor(std::forward<F>(f));
+            this->ops = &kOps<Functor>;
+        }
+
+        /**
+         * @brief Store any callable, moving it to the heap if it can't be stored inline
+         */
+        template<typename F, typename Functor = std::decay_t<F>>
+        static InplaceFunction Box(F &&f) {
+            if constexpr(std::is_same_v<Functor, InplaceFunction> || (sizeof(Functor) <= Capacity &&
+                    alignof(Functor) <= alignof(Storage) &&
+                    std::is_nothrow_move_constructible_v<Functor>)) {
+                return InplaceFunction(std::forward<F>(f));
+            } else {
+                return InplaceFunction([boxed = std::make_unique<Functor>(std::forward<F>(f))](
+                            Args... args) -> R {
+                    return std::invoke(*boxed, std::forward<Args>(args)...);
+                });
+            }
+        }
+
+        InplaceFunction(InplaceFunction &&other) noexcept {
+            this->take(other);
+        }
+        InplaceFunction &operator=(InplaceFunction &&other) noexcept {
+            if(this != &other) {
+                this->reset();
+                this->take(other);
+            }
+            return *this;
+        }
+        InplaceFunction &operator=(std::nullptr_t) noexcept {
+            this->reset();
+            return *this;
+        }
+
+        InplaceFunction(const InplaceFunction &) = delete;
+        InplaceFunction &operator=(const InplaceFunction &) = delete;
+
+        ~InplaceFunction() {
+            this->reset();
+        }
+
+        /**
+         * @brief Determine whether a callable is stored
+         */
+        explicit operator bool() const noexcept {
+            return this->ops->manage != nullptr;
+        }
+
+        /**
+         * @brief Invoke the stored callable
+         */
+        inline R operator()(Args... args) const {
+            return this->ops->invoke(&this->storage, std::forward<Args>(args)...);
+        }
+
+    private:
+        /// Storage for the callable
+        struct alignas(void *) Storage {
+            std::byte data[Capacity];
+        };
+
+        /// Invokes the callable in the given storage
+        using Invoker = R (*)(Storage *, Args &&...);
+        /**
+         * @brief Moves the callable from one storage to another, or destroys it
+         *
+         * The callable in `from` is always destroyed; if `to` is not `nullptr`, it's moved there
+         * first.
+         */
+        using Manager = void (*)(Storage *to, Storage *from);
+
+        template<typename Functor>
+        static R Invoke(Storage *storage, Args &&...args) {
+            auto &f = *std::launder(reinterpret_cast<Functor *>(storage));
+            if constexpr(std::is_void_v<R>) {
+                std::invoke(f, std::forward<Args>(args)...);
+            } else {
+                return std::invoke(f, std::forward<Args>(args)...);
+            }
+        }
+        static R InvokeEmpty(Storage *, Args &&...) {
+            throw std::bad_function_call();
+        }
+
+        template<typename Functor>
+        static void Manage(Storage *to, Storage *from) {
+            auto &f = *std::launder(reinterpret_cast<Functor *>(from));
+            if(to) {
+                ::new(static_cast<void *>(to)) Functor(std::move(f));
+            }
+            f.~Functor();
+        }
+
+        /**
+         * @brief Operations on a stored callable
+         */
+        struct Ops {
+            /// Invoke the callable
+            Invoker invoke;
+            /// Move or destroy the callable (`nullptr` if empty)
+            Manager manage;
+        };
+
+        template<typename Functor>
+        constexpr static const Ops kOps{&Invoke<Functor>, &Manage<Functor>};
+        constexpr static const Ops kEmptyOps{&InvokeEmpty, nullptr};
+
+        /// Destroy the stored callable, if any
+        inline void reset() noexcept {
+            if(this->ops->manage) {
+                this->ops->manage(nullptr, &this->storage);
+                this->ops = &kEmptyOps;
+            }
+        }
+        /// Move the callable out of another function into this (empty) one
+        inline void take(InplaceFunction &other) noexcept {
+            if(other.ops->manage) {
+                other.ops->manage(&this->storage, &other.storage);
+                this->ops = std::exchange(other.ops, &kEmptyOps);
+            }
+        }
+
+    private:
+        /// Operations for the stored callable; never `nullptr`, so invocation needn't test for it
+        const Ops *ops{&kEmptyOps};
+        /// The callable itself
+        mutable Storage storage;
+};
+}
+
+#endif
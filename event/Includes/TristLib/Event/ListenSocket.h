@@ -3,12 +3,16 @@
 
 #include <cstddef>
 #include <filesystem>
-#include <functional>
 #include <memory>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include <sys/socket.h>
 
+#include "TristLib/Event/InplaceFunction.h"
+
 namespace TristLib::Event {
 class RunLoop;
 
@@ -17,23 +21,45 @@ class RunLoop;
  *
  * Waits for clients to connect to the monitored socket; invokes a callback for every new client
  * and any error conditions.
+ *
+ * Listening sockets may also be inherited, rather than created: either from the service manager
+ * (systemd socket activation) or from a previous instance of the process, which passes its
+ * listeners over an UNIX domain socket during a restart. In the latter case, the old process
+ * should accept a connection on a handoff socket, call `SendHandoff()` and then stop accepting
+ * clients (via `suspend()`) and drain its existing connections; the new process receives the
+ * sockets with `ReceiveHandoff()`. Since the underlying sockets are never closed, pending clients
+ * remain in the accept queue throughout.
  */
 class ListenSocket {
     public:
         /// Accept callback
-        using AcceptCallback = std::function<void(ListenSocket *)>;
+        using AcceptCallback = InplaceFunction<void(ListenSocket *)>;
 
         /// Maximum number of pending clients to accept
         constexpr static const size_t kListenBacklog{10};
+        /// Maximum number of sockets that may be passed in a single handoff
+        constexpr static const size_t kMaxHandoffSockets{253};
 
     public:
-        ListenSocket(const std::shared_ptr<RunLoop> &loop, const AcceptCallback &callback,
+        ListenSocket(const std::shared_ptr<RunLoop> &loop, AcceptCallback callback,
                 const int fd, const bool closeFd = true);
-        ListenSocket(const std::shared_ptr<RunLoop> &loop, const AcceptCallback &callback,
+        ListenSocket(const std::shared_ptr<RunLoop> &loop, AcceptCallback callback,
                 const std::filesystem::path &fsPath, const bool unlinkOld, const int type);
 
         ~ListenSocket();
 
+        static bool SupportsSocketActivation() noexcept;
+        static std::vector<std::shared_ptr<ListenSocket>> FromSystemd(
+                const std::shared_ptr<RunLoop> &loop, AcceptCallback callback);
+        static std::shared_ptr<ListenSocket> FromSystemd(const std::shared_ptr<RunLoop> &loop,
+                AcceptCallback callback, const std::string_view name);
+
+        static void SendHandoff(const int channel,
+                std::span<const std::shared_ptr<ListenSocket>> sockets);
+        static std::vector<std::shared_ptr<ListenSocket>> ReceiveHandoff(
+                const std::shared_ptr<RunLoop> &loop, AcceptCallback callback,
+                const std::filesystem::path &path);
+
         /**
          * @brief Get the underlying file descriptor
          */
@@ -41,14 +67,29 @@ class ListenSocket {
             return this->fd;
         }
 
+        /**
+         * @brief Get the socket's name
+         *
+         * Sockets inherited from systemd carry the name assigned by the `FileDescriptorName=`
+         * key of the socket unit; this name is preserved across handoffs. Sockets created
+         * otherwise have an empty name.
+         */
+        inline const std::string &getName() const {
+            return this->name;
+        }
+
         int accept();
 
+        void suspend();
+        void resume();
+
     private:
         void makeEvent(const std::shared_ptr<RunLoop> &);
         void listen();
 
         static int CreateSocket(const std::filesystem::path &, const bool, const int);
         static void MakeSocketNonblocking(const int);
+        static bool IsSocketListening(const int);
 
     private:
         /// Callback to invoke whenever a new client is pending
@@ -58,6 +99,9 @@ class ListenSocket {
         /// Whether to close the file descriptor when deallocating
         const bool closeFd{true};
 
+        /// Name of the socket (if inherited)
+        std::string name;
+
         /// libevent event handle for this socket
         struct event *event{nullptr};
 };
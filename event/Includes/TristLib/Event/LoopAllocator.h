@@ -0,0 +1,232 @@
+#ifndef TRISTLIB_EVENT_LOOPALLOCATOR_H
+#define TRISTLIB_EVENT_LOOPALLOCATOR_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace TristLib::Event {
+/**
+ * @brief Pooled memory allocator for a run loop
+ *
+ * Memory is handed out from per size class free lists, which are refilled by carving up large
+ * slabs; freed memory goes back onto its free list rather than to the heap, so creating and
+ * destroying event sources at a high rate (such as for short lived connections) doesn't touch the
+ * global allocator once the pool has grown to fit.
+ *
+ * Each run loop has its own allocator. It serves event sources created with `RunLoop::create()`
+ * and, if enabled at build time, libevent's internal allocations (events, buffer events and their
+ * buffers) made while the loop runs, or while a source is constructed on it.
+ *
+ * An allocator is used by one thread at a time: the thread that runs its loop (or creates
+ * sources on it before it runs, as libevent requires anyhow.) Memory can be freed on any thread:
+ * it's handed back to the allocator it came from, which picks it up on its next allocation.
+ *
+ * @remark When libevent's allocations are pooled, memory that libevent hands to the application
+ *         to free (such as the lines returned by `evbuffer_readln()`) doesn't come from `malloc()`
+ *         and must not be passed to `free()`: release it with `FreeLibevent()` instead.
+ *
+ * Allocators are reference counted: the owner holds one reference (dropped with `Release()`) and
+ * each live allocation holds another, so the allocator is deleted once both its owner and all of
+ * its memory are gone, regardless of which thread lets go last.
+ */
+class LoopAllocator {
+    public:
+        /// Largest allocation served from the pool; larger ones go to the heap
+        constexpr static const size_t kMaxPooledSize{4096};
+        /// Size of slabs that pooled memory is carved from
+        constexpr static const size_t kSlabSize{64 * 1024};
+        /// Alignment of all allocations
+        constexpr static const size_t kAlignment{16};
+
+        /**
+         * @brief Allocation statistics
+         */
+        struct Stats {
+            /// Number of live allocations
+            size_t objects;
+            /// Number of bytes in live allocations (as requested)
+            size_t bytes;
+            /// Total size of slabs allocated for the pool
+            size_t reserved;
+        };
+
+        /**
+         * @brief Makes an allocator the calling thread's current allocator
+         *
+         * While a scope exists, libevent allocations on the thread are made from its allocator.
+         * Scopes may be nested.
+         */
+        class Scope {
+            public:
+                Scope(LoopAllocator &allocator) : previous(gCurrent) {
+                    gCurrent = &allocator;
+                }
+                ~Scope() {
+                    gCurrent = this->previous;
+                }
+
+                Scope(const Scope &) = delete;
+                Scope &operator=(const Scope &) = delete;
+
+            private:
+                /// Allocator that was current before the scope
+                LoopAllocator *previous;
+        };
+
+        /**
+         * @brief Standard library allocator drawing from a loop allocator
+         *
+         * Used with `std::allocate_shared()`, so that an object and its reference counts are a
+         * single pooled allocation.
+         */
+        template<typename T>
+        class StlAllocator {
+            template<typename U> friend class StlAllocator;
+
+            public:
+                using value_type = T;
+
+                StlAllocator(LoopAllocator &allocator) : allocator(&allocator) {}
+                template<typename U>
+                StlAllocator(const StlAllocator<U> &other) : allocator(other.allocator) {}
+
+                T *allocate(const size_t n) {
+                    static_assert(alignof(T) <= kAlignment, "type is overaligned");
+
+                    auto ptr = this->allocator->allocate(n * sizeof(T));
+                    if(!ptr) {
+                        throw std::bad_alloc();
+                    }
+                    return static_cast<T *>(ptr);
+                }
+                void deallocate(T *ptr, const size_t) {
+                    LoopAllocator::Free(ptr);
+                }
+
+                template<typename U>
+                bool operator==(const StlAllocator<U> &other) const {
+                    return this->allocator == other.allocator;
+                }
+
+            private:
+                LoopAllocator *allocator;
+        };
+
+    public:
+        LoopAllocator() = default;
+
+        LoopAllocator(const LoopAllocator &) = delete;
+        LoopAllocator &operator=(const LoopAllocator &) = delete;
+
+        static void Release(LoopAllocator *allocator);
+
+        void *allocate(const size_t size);
+
+        static void *Allocate(const size_t size);
+        static void *Reallocate(void *ptr, const size_t size);
+        static void Free(void *ptr);
+        static void FreeLibevent(void *ptr);
+
+        Stats getStats() const;
+
+        /**
+         * @brief Get the calling thread's current allocator, if any
+         */
+        static inline LoopAllocator *Current() {
+            return gCurrent;
+        }
+
+    private:
+        /// Number of pooled size classes
+        constexpr static const size_t kNumClasses{32};
+        /// Size class of allocations made directly from the heap
+        constexpr static const uint32_t kHeapClass{kNumClasses};
+
+        /**
+         * @brief Header preceding each allocation
+         */
+        struct alignas(kAlignment) Header {
+            /// Allocator the memory belongs to (or `nullptr` for plain heap allocations)
+            LoopAllocator *owner;
+            /// Size class of the block
+            uint32_t sizeClass;
+            /// Requested size of the allocation
+            uint32_t size;
+
+            /// Get the pointer to the next block in a free list (stored in the block's memory)
+            inline Header *&getNext() {
+                return *reinterpret_cast<Header **>(this + 1);
+            }
+        };
+
+        /**
+         * @brief Get the size class for an allocation
+         *
+         * Sizes up to 256 bytes are rounded up to multiples of 16; above that, there are four
+         * classes per power of two.
+         */
+        static constexpr size_t GetSizeClass(const size_t size) {
+            if(size <= 256) {
+                return size ? (size - 1) / 16 : 0;
+            }
+            const size_t shift = std::bit_width(size - 1) - 3;
+            return 16 + (shift - 6) * 4 + ((size - 1) >> shift) - 4;
+        }
+        /**
+         * @brief Get the size of blocks of a size class
+         */
+        static constexpr size_t GetClassSize(const size_t sizeClass) {
+            if(sizeClass < 16) {
+                return (sizeClass + 1) * 16;
+            }
+            return (5 + (sizeClass - 16) % 4) << (6 + (sizeClass - 16) / 4);
+        }
+
+        ~LoopAllocator();
+
+        Header *carve(const size_t sizeClass);
+        void drainRemote();
+
+        /// Drop a reference to the allocator, deleting it if it was the last one
+        inline void unref() {
+            if(this->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+
+        /// Add to a counter only ever modified by the allocator's thread
+        static inline void Add(std::atomic_size_t &counter, const size_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value,
+                    std::memory_order_relaxed);
+        }
+
+    private:
+        static thread_local LoopAllocator *gCurrent;
+
+        /// Free blocks for each size class
+        std::array<Header *, kNumClasses> freeLists{};
+        /// Blocks freed by other threads, not yet returned to the free lists
+        std::atomic<Header *> remoteFrees{nullptr};
+
+        /// Most recently allocated slab (each slab starts with a pointer to the previous one)
+        std::byte *slabs{nullptr};
+        /// Unused space at the end of the current slab
+        std::byte *slabCursor{nullptr}, *slabEnd{nullptr};
+
+        /// Number of allocations made and freed by the allocator's thread
+        std::atomic_size_t objects{0}, bytes{0};
+        /// Number of allocations freed by other threads
+        std::atomic_size_t remoteObjects{0}, remoteBytes{0};
+        /// Total size of slabs
+        std::atomic_size_t reserved{0};
+
+        /// References to the allocator: one for its owner, and one for each live allocation
+        std::atomic_size_t refs{1};
+};
+}
+
+#endif
@@ -6,6 +6,12 @@
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "TristLib/Event/InplaceFunction.h"
+#include "TristLib/Event/LoopAllocator.h"
 
 struct event_base;
 struct event;
@@ -17,8 +23,17 @@ class Source;
  * @brief Event loop
  *
  * This sets up a libevent-based loop, which can have various sources attached to it.
+ *
+ * @remark libevent's allocations are made from the loop's memory pool (unless disabled at build
+ *         time) so memory returned by libevent for the caller to free, such as the result of
+ *         `evbuffer_readln()` on a socket's buffer, must be released with
+ *         `LoopAllocator::FreeLibevent()` rather than `free()`.
  */
 class RunLoop: public std::enable_shared_from_this<RunLoop> {
+    public:
+        /// Work posted to the run loop
+        using Work = InplaceFunction<void()>;
+
     public:
         RunLoop();
         ~RunLoop();
@@ -36,6 +51,20 @@ class RunLoop: public std::enable_shared_from_this<RunLoop> {
         void run();
         void interrupt();
 
+        void reservePost();
+        void cancelPost();
+        void post(Work &&work);
+
+        /**
+         * @brief Post any callable to the run loop
+         *
+         * Callables too large to be stored inline are moved to the heap.
+         */
+        template<typename F>
+        inline void post(F &&work) {
+            this->post(Work::Box(std::forward<F>(work)));
+        }
+
         /**
          * @brief Get libevent main loop
          */
@@ -43,6 +72,32 @@ class RunLoop: public std::enable_shared_from_this<RunLoop> {
             return this->evbase;
         }
 
+        /**
+         * @brief Get the run loop's memory pool
+         *
+         * Its statistics reflect the event sources created on the loop, and their libevent
+         * allocations.
+         */
+        inline LoopAllocator &getAllocator() {
+            return *this->allocator;
+        }
+
+        /**
+         * @brief Create an event source on this run loop
+         *
+         * The object and its reference counts are allocated from the loop's memory pool, and
+         * released back into it when the last reference goes away. The run loop is passed as the
+         * first argument to the object's constructor.
+         *
+         * @remark This should be called from the run loop's thread (or before the loop runs.)
+         */
+        template<typename T, typename... Args>
+        std::shared_ptr<T> create(Args &&...args) {
+            LoopAllocator::Scope scope(*this->allocator);
+            return std::allocate_shared<T>(LoopAllocator::StlAllocator<T>(*this->allocator),
+                    this->shared_from_this(), std::forward<Args>(args)...);
+        }
+
         /**
          * @brief Get the current thread's event loop
          *
@@ -61,11 +116,28 @@ class RunLoop: public std::enable_shared_from_this<RunLoop> {
             gCurrentRunLoop = this->shared_from_this();
         }
 
+        void drainPosted();
+
     private:
         static thread_local std::weak_ptr<RunLoop> gCurrentRunLoop;
 
+        /// Memory pool for event sources and libevent allocations on this loop
+        LoopAllocator *allocator{nullptr};
+
         /// libevent main loop
         struct event_base *evbase{nullptr};
+
+        /// eventfd used to wake the loop when work is posted from another thread
+        int postFd{-1};
+        /// Event observing the post eventfd; only pending while posts are outstanding
+        struct event *postEvent{nullptr};
+        /// Number of outstanding post reservations (only accessed from the loop's thread)
+        size_t postReservations{0};
+
+        /// Lock protecting the posted work queue
+        std::mutex postLock;
+        /// Work posted from other threads, waiting to be executed
+        std::vector<Work> postQueue;
 };
 }
 
@@ -0,0 +1,58 @@
+#ifndef TRISTLIB_EVENT_SHAREDMEMORYCHANNEL_H
+#define TRISTLIB_EVENT_SHAREDMEMORYCHANNEL_H
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include "TristLib/Event/InplaceFunction.h"
+
+struct event;
+
+namespace TristLib::Event {
+class RunLoop;
+class SharedMemoryRing;
+
+/**
+ * @brief Shared memory ring event source
+ *
+ * Acts as the consumer of a shared memory ring: whenever messages are written to the ring, they
+ * are read in batches on the run loop and the callback is invoked for each of them. Messages are
+ * passed to the callback directly from shared memory, without copying.
+ */
+class SharedMemoryChannel {
+    public:
+        /// Callback invoked for each message received
+        using ReadCallback = InplaceFunction<void(SharedMemoryChannel *,
+                std::span<const std::byte>)>;
+
+        /// Maximum number of messages to process per run loop iteration
+        constexpr static const size_t kMaxBatchSize{1024};
+
+    public:
+        SharedMemoryChannel(const std::shared_ptr<RunLoop> &loop,
+                const std::shared_ptr<SharedMemoryRing> &ring, ReadCallback callback);
+        ~SharedMemoryChannel();
+
+        /**
+         * @brief Get the ring this channel reads from
+         */
+        inline auto &getRing() const {
+            return this->ring;
+        }
+
+    private:
+        void drain();
+
+    private:
+        /// Ring to read messages from
+        std::shared_ptr<SharedMemoryRing> ring;
+        /// Callback to invoke for each message
+        ReadCallback callback;
+
+        /// Event watching the ring's doorbell
+        struct event *event{nullptr};
+};
+}
+
+#endif
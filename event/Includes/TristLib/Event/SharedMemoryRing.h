@@ -0,0 +1,133 @@
+#ifndef TRISTLIB_EVENT_SHAREDMEMORYRING_H
+#define TRISTLIB_EVENT_SHAREDMEMORYRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+namespace TristLib::Event {
+/**
+ * @brief Shared memory message ring
+ *
+ * A ring buffer of variable length messages in a memory region (backed by a memfd) that can be
+ * shared between processes, along with an eventfd used as a doorbell to wake up the consumer. Any
+ * number of producers (in any process) may write to the ring; there must be only a single
+ * consumer, which will usually read the ring through a `SharedMemoryChannel` on its run loop.
+ *
+ * Producers only ring the doorbell if the consumer has indicated it's idle; while the consumer is
+ * busy draining the ring, messages are appended without any system calls.
+ *
+ * To share a ring with another process, pass the file descriptors returned by `getMemoryFd()` and
+ * `getDoorbellFd()` to it (for example, over an UNIX domain socket) and attach to them there.
+ *
+ * @remark If a producer dies between reserving space for a message and committing it, the
+ *         consumer will stall at that message.
+ */
+class SharedMemoryRing {
+    public:
+        /// Callback invoked for each message read from the ring
+        using ReadCallback = std::function<void(std::span<const std::byte>)>;
+
+        /// Minimum ring capacity, in bytes
+        constexpr static const size_t kMinCapacity{4096};
+
+    private:
+        /**
+         * @brief Ring header, located at the start of the shared memory region
+         */
+        struct Header {
+            /// Magic value, used to validate attached regions
+            uint64_t magic;
+            /// Capacity of the data area (a power of two)
+            uint64_t capacity;
+
+            /// Producer reservation position; incremented by producers
+            alignas(64) std::atomic<uint64_t> reserve;
+            /// Consumer read position
+            alignas(64) std::atomic<uint64_t> head;
+            /// Set when the consumer is waiting for the doorbell
+            alignas(64) std::atomic<uint32_t> consumerIdle;
+        };
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "64-bit atomics must be lock-free to be shared between processes");
+
+        /// Offset from the start of the region to the data area
+        constexpr static const size_t kDataOffset{4096};
+        static_assert(sizeof(Header) <= kDataOffset);
+
+        /// Magic value for the header (`TLSHMRNG`)
+        constexpr static const uint64_t kMagic{0x474E524D4853'4C54};
+
+        /// Message header flag: message has been committed
+        constexpr static const uint64_t kFlagCommitted{1ULL << 32};
+        /// Message header flag: this is a padding record, to be skipped
+        constexpr static const uint64_t kFlagPadding{1ULL << 33};
+
+    public:
+        SharedMemoryRing(const size_t capacity);
+        SharedMemoryRing(const int memoryFd, const int doorbellFd, const bool closeFds = true);
+        ~SharedMemoryRing();
+
+        bool write(std::span<const std::byte> message);
+        size_t read(const ReadCallback &callback, const size_t maxMessages = SIZE_MAX);
+
+        bool isEmpty() const;
+        bool sleep();
+        void wake();
+
+        /**
+         * @brief Get the file descriptor of the shared memory region
+         */
+        constexpr inline auto getMemoryFd() const {
+            return this->memoryFd;
+        }
+        /**
+         * @brief Get the file descriptor of the doorbell eventfd
+         */
+        constexpr inline auto getDoorbellFd() const {
+            return this->doorbellFd;
+        }
+
+        /**
+         * @brief Get the maximum size of a single message
+         */
+        constexpr inline size_t getMaxMessageSize() const {
+            return (this->capacity / 4) - sizeof(uint64_t);
+        }
+
+    private:
+        void map();
+        void ringDoorbell();
+
+        /**
+         * @brief Get the message header word at the given ring position
+         */
+        inline std::atomic_ref<uint64_t> headerAt(const uint64_t position) const {
+            return std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t *>(
+                        this->data + (position & (this->capacity - 1))));
+        }
+
+    private:
+        /// memfd backing the ring
+        int memoryFd{-1};
+        /// eventfd used to wake the consumer
+        int doorbellFd{-1};
+        /// Whether the file descriptors are closed on deallocation
+        bool closeFds{true};
+
+        /// Capacity of the data area, in bytes
+        size_t capacity{0};
+
+        /// Base of the mapped region
+        void *region{nullptr};
+        /// Ring header (at the start of the region)
+        Header *header{nullptr};
+        /// Start of the data area
+        std::byte *data{nullptr};
+};
+}
+
+#endif
@@ -4,11 +4,12 @@
 #include <signal.h>
 
 #include <array>
-#include <functional>
 #include <memory>
 #include <span>
 #include <vector>
 
+#include "TristLib/Event/InplaceFunction.h"
+
 namespace TristLib::Event {
 class RunLoop;
 
@@ -23,14 +24,16 @@ class RunLoop;
  */
 class Signal {
     public:
+        /// Callback invoked when a signal fires, with the signal number
+        using Callback = InplaceFunction<void(int)>;
+
         /// Default Ctrl+C equivalent signals (to quit the program)
         constexpr static const std::array<int, 3> kQuitEvents{{SIGINT, SIGTERM, SIGHUP}};
 
     public:
-        Signal(const std::shared_ptr<RunLoop> &loop, int signal,
-                const std::function<void(int)> &callback);
+        Signal(const std::shared_ptr<RunLoop> &loop, int signal, Callback callback);
         Signal(const std::shared_ptr<RunLoop> &loop, std::span<const int> signals,
-                const std::function<void(int)> &callback);
+                Callback callback);
         ~Signal();
 
     private:
@@ -40,7 +43,7 @@ class Signal {
         /// Underlying signal events
         std::vector<struct event *> events;
         /// Function to invoke on signal
-        std::function<void(int)> callback;
+        Callback callback;
 };
 }
 
@@ -4,12 +4,12 @@
 #include <sys/socket.h>
 
 #include <cstddef>
-#include <functional>
 #include <memory>
-#include <optional>
 #include <span>
 #include <utility>
 
+#include "TristLib/Event/InplaceFunction.h"
+
 struct ssl_st;
 struct bufferevent;
 
@@ -41,9 +41,9 @@ class Socket {
         };
 
         /// Callback type for read/write callbacks
-        using DataCallback = std::function<void(Socket *)>;
+        using DataCallback = InplaceFunction<void(Socket *)>;
         /// Callback type for events
-        using EventCallback = std::function<void(Socket *, const Event)>;
+        using EventCallback = InplaceFunction<void(Socket *, const Event)>;
 
     public:
         Socket(const std::shared_ptr<RunLoop> &loop, const int type = SOCK_STREAM);
@@ -95,24 +95,24 @@ class Socket {
          *
          * @param newCallback New callback to be invoked whenever data is ready to be read
          */
-        inline void setReadCallback(const DataCallback &newCallback) {
-            this->readCallback = newCallback;
+        inline void setReadCallback(DataCallback newCallback) {
+            this->readCallback = std::move(newCallback);
         }
         /**
          * @brief Set write callback
          *
          * @param newCallback New callback to be invoked whenever write data can be accepted
          */
-        inline void setWriteCallback(const DataCallback &newCallback) {
-            this->writeCallback = newCallback;
+        inline void setWriteCallback(DataCallback newCallback) {
+            this->writeCallback = std::move(newCallback);
         }
         /**
          * @brief Set event callback
          *
          * @param newCallback New callback to be invoked for any socket event
          */
-        inline void setEventCallback(const EventCallback &newCallback) {
-            this->eventCallback = newCallback;
+        inline void setEventCallback(EventCallback newCallback) {
+            this->eventCallback = std::move(newCallback);
         }
 
         /**
@@ -133,11 +133,11 @@ class Socket {
         struct ::bufferevent *event{nullptr};
 
         /// Read callback
-        std::optional<DataCallback> readCallback;
+        DataCallback readCallback;
         /// Write callback
-        std::optional<DataCallback> writeCallback;
+        DataCallback writeCallback;
         /// Event callback
-        std::optional<EventCallback> eventCallback;
+        EventCallback eventCallback;
 
 };
 }
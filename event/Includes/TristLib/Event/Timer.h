@@ -2,9 +2,10 @@
 #define TRISTLIB_EVENT_TIMER_H
 
 #include <chrono>
-#include <functional>
 #include <memory>
 
+#include "TristLib/Event/InplaceFunction.h"
+
 namespace TristLib::Event {
 class RunLoop;
 
@@ -12,9 +13,13 @@ class RunLoop;
  * @brief Run loop timer
  */
 class Timer {
+    public:
+        /// Callback invoked when the timer expires
+        using Callback = InplaceFunction<void(Timer *)>;
+
     public:
         Timer(const std::shared_ptr<RunLoop> &loop, const std::chrono::microseconds interval,
-                const std::function<void(Timer *)> &callback, const bool repeating = false,
+                Callback callback, const bool repeating = false,
                 const bool start = true);
         ~Timer();
 
@@ -25,7 +30,7 @@ class Timer {
         /// Timer event
         struct event *ev{nullptr};
         /// Function to invoke on signal
-        std::function<void(Timer *)> callback;
+        Callback callback;
 
         /// Timer interval
         const std::chrono::microseconds interval;
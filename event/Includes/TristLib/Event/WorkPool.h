@@ -0,0 +1,198 @@
+#ifndef TRISTLIB_EVENT_WORKPOOL_H
+#define TRISTLIB_EVENT_WORKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <TristLib/Event/InplaceFunction.h>
+#include <TristLib/Event/RunLoop.h>
+
+namespace TristLib::Event {
+/**
+ * @brief Work stealing thread pool
+ *
+ * Executes CPU intensive work on a set of background threads, delivering the results back to the
+ * run loop that submitted the work. Each worker thread has its own queue; work submitted from a
+ * worker goes to its own queue, and idle workers steal work from the other workers' queues.
+ *
+ * The total number of queued jobs is bounded: once the pool is full, submissions are rejected,
+ * so callers can apply backpressure (for example, by disabling reads on a socket until the queue
+ * depth decreases.)
+ */
+class WorkPool {
+    public:
+        /// A single unit of work
+        using Job = InplaceFunction<void()>;
+
+        /// Default maximum number of queued jobs
+        constexpr static const size_t kDefaultCapacity{1024};
+
+    public:
+        WorkPool(const size_t numThreads = 0, const size_t capacity = kDefaultCapacity);
+        ~WorkPool();
+
+        bool submit(Job &&job);
+
+        /**
+         * @brief Submit any callable for execution
+         *
+         * Callables too large to be stored inline are moved to the heap.
+         */
+        template<class F>
+        inline bool submit(F &&job) {
+            return this->submit(Job::Box(std::forward<F>(job)));
+        }
+
+        /**
+         * @brief Submit work, and receive its result on the calling run loop
+         *
+         * Executes `work` on a worker thread, then invokes `completion` with its return value (if
+         * any) on the run loop of the calling thread.
+         *
+         * @param work Function to execute in the background
+         * @param completion Function to invoke on the run loop with the work's result
+         *
+         * @return Whether the work was queued; `false` if the pool is at capacity.
+         *
+         * @remark The calling thread must have an active run loop. If the work throws, the
+         *         exception is logged, and the completion is not invoked.
+         */
+        template<class Work, class Completion>
+        bool submit(Work &&work, Completion &&completion) {
+            auto loop = RunLoop::Current();
+            if(!loop) {
+                throw std::logic_error("no run loop on calling thread");
+            }
+
+            return this->submit(loop, std::forward<Work>(work),
+                    std::forward<Completion>(completion));
+        }
+
+        /**
+         * @brief Submit work, and receive its result on the given run loop
+         *
+         * Executes `work` on a worker thread, then invokes `completion` with its return value (if
+         * any) on the specified run loop.
+         *
+         * @param loop Run loop to invoke the completion on
+         * @param work Function to execute in the background
+         * @param completion Function to invoke on the run loop with the work's result
+         *
+         * @return Whether the work was queued; `false` if the pool is at capacity.
+         *
+         * @remark This must be called on the run loop's thread. If the work throws, the exception
+         *         is logged, and the completion is not invoked.
+         */
+        template<class Work, class Completion>
+        bool submit(const std::shared_ptr<RunLoop> &loop, Work &&work, Completion &&completion) {
+            using Result = std::invoke_result_t<Work>;
+
+            loop->reservePost();
+
+            bool queued{false};
+            try {
+                queued = this->submit([loop, work = std::forward<Work>(work),
+                        completion = std::forward<Completion>(completion)]() mutable {
+                    try {
+                        if constexpr(std::is_void_v<Result>) {
+                            work();
+                            loop->post([completion = std::move(completion)]() mutable {
+                                completion();
+                            });
+                        } else {
+                            auto result = work();
+                            loop->post([completion = std::move(completion),
+                                    result = std::move(result)]() mutable {
+                                completion(std::move(result));
+                            });
+                        }
+                    } catch(...) {
+                        // release the loop's reservation, then let the worker report the failure
+                        loop->post({});
+                        throw;
+                    }
+                });
+            } catch(...) {
+                loop->cancelPost();
+                throw;
+            }
+
+            if(!queued) {
+                loop->cancelPost();
+            }
+            return queued;
+        }
+
+        /**
+         * @brief Get the number of jobs waiting to be executed
+         */
+        inline size_t getQueueDepth() const {
+            return this->depth.load(std::memory_order_relaxed);
+        }
+        /**
+         * @brief Get the maximum number of queued jobs
+         */
+        constexpr inline size_t getCapacity() const {
+            return this->capacity;
+        }
+        /**
+         * @brief Get the number of worker threads
+         */
+        inline size_t getNumThreads() const {
+            return this->workers.size();
+        }
+
+    private:
+        /**
+         * @brief Worker thread state
+         */
+        struct Worker {
+            /// Lock protecting the queue
+            std::mutex lock;
+            /// Jobs queued on this worker; the owner pops from the back, thieves from the front
+            std::deque<Job> queue;
+            /// Thread executing this worker
+            std::thread thread;
+        };
+
+        void workerMain(const size_t index);
+        bool dequeue(const size_t index, Job &outJob);
+        void wakeWorker();
+
+    private:
+        /// Pool the current thread is a worker of, if any
+        static thread_local WorkPool *gCurrentPool;
+        /// Index of the current thread's worker in its pool
+        static thread_local size_t gCurrentWorker;
+
+        /// Maximum number of queued jobs
+        const size_t capacity;
+        /// Current number of queued jobs
+        std::atomic<size_t> depth{0};
+        /// Worker to receive the next job submitted from outside the pool
+        std::atomic<size_t> nextWorker{0};
+
+        /// All workers
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        /// Lock for idle workers to wait on
+        std::mutex sleepLock;
+        /// Condition signalled when work is queued
+        std::condition_variable sleepCond;
+        /// Number of workers waiting for work
+        std::atomic<size_t> numSleeping{0};
+        /// Set to request the workers to exit
+        std::atomic_bool shutdown{false};
+};
+}
+
+#endif
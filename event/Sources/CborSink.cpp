@@ -0,0 +1,70 @@
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+
+#include <stdexcept>
+
+#include "TristLib/Event.h"
+
+using namespace TristLib::Event;
+
+/**
+ * @brief Create a sink that writes into the given buffer
+ */
+EvbufferCborSink::EvbufferCborSink(struct evbuffer *buffer) : buffer(buffer) {}
+
+/**
+ * @brief Create a sink that writes into a socket's output buffer
+ */
+EvbufferCborSink::EvbufferCborSink(Socket &socket) :
+    buffer(bufferevent_get_output(socket.getEvent())) {}
+
+/**
+ * @brief Commit any outstanding data to the buffer
+ */
+EvbufferCborSink::~EvbufferCborSink() {
+    this->commit();
+}
+
+/**
+ * @brief Commit all data written so far to the buffer
+ *
+ * Unused reserved space is released.
+ */
+void EvbufferCborSink::commit() {
+    if(!this->start) {
+        return;
+    }
+
+    struct evbuffer_iovec vec{this->start, static_cast<size_t>(this->cursor - this->start)};
+    evbuffer_commit_space(this->buffer, &vec, 1);
+
+    this->start = this->cursor = this->end = nullptr;
+}
+
+/**
+ * @brief Write data that doesn't fit in the reserved space
+ *
+ * The data written so far is committed; large writes are then appended to the buffer directly,
+ * while smaller ones go into a newly reserved block.
+ */
+void EvbufferCborSink::writeSlow(const void *data, const size_t length) {
+    this->commit();
+
+    if(length >= kReserveSize / 2) {
+        if(evbuffer_add(this->buffer, data, length)) {
+            throw std::runtime_error("evbuffer_add failed");
+        }
+        return;
+    }
+
+    struct evbuffer_iovec vec;
+    if(evbuffer_reserve_space(this->buffer, kReserveSize, &vec, 1) != 1) {
+        throw std::runtime_error("evbuffer_reserve_space failed");
+    }
+
+    this->start = static_cast<std::byte *>(vec.iov_base);
+    this->end = this->start + vec.iov_len;
+
+    memcpy(this->start, data, length);
+    this->cursor = this->start + length;
+}
@@ -0,0 +1,66 @@
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+
+#include <algorithm>
+
+#include "TristLib/Event.h"
+
+using namespace TristLib::Event;
+
+/// Maximum number of buffer segments to feed to the reader before draining them
+constexpr static const size_t kMaxSegments{16};
+
+/**
+ * @brief Feed a buffer's contents to a CBOR reader, invoking a callback for each item
+ *
+ * @seeAlso ReadCbor
+ */
+size_t TristLib::Event::ReadCbor(Core::CborReader &reader, struct evbuffer *buffer,
+        bool (*callback)(void *, const Core::CborReader::Item &), void *context) {
+    size_t total{0};
+    struct evbuffer_iovec segments[kMaxSegments];
+
+    while(true) {
+        const int numSegments = evbuffer_peek(buffer, -1, nullptr, segments, kMaxSegments);
+        if(numSegments <= 0) {
+            break;
+        }
+
+        // feed segments until all are consumed, or the callback asks us to stop
+        size_t consumed{0};
+        for(int i = 0; i < std::min<int>(numSegments, kMaxSegments); i++) {
+            const auto &segment = segments[i];
+            reader.feed({static_cast<const std::byte *>(segment.iov_base), segment.iov_len});
+
+            while(true) {
+                const auto item = reader.next();
+                if(item.type == Core::CborReader::Type::NeedMore) {
+                    break;
+                }
+
+                if(!callback(context, item)) {
+                    consumed += reader.getOffset();
+                    evbuffer_drain(buffer, consumed);
+                    return total + consumed;
+                }
+            }
+
+            consumed += segment.iov_len;
+        }
+
+        evbuffer_drain(buffer, consumed);
+        total += consumed;
+    }
+
+    return total;
+}
+
+/**
+ * @brief Feed a socket's received data to a CBOR reader, invoking a callback for each item
+ *
+ * @seeAlso ReadCbor
+ */
+size_t TristLib::Event::ReadCbor(Core::CborReader &reader, Socket &socket,
+        bool (*callback)(void *, const Core::CborReader::Item &), void *context) {
+    return ReadCbor(reader, bufferevent_get_input(socket.getEvent()), callback, context);
+}
@@ -0,0 +1,146 @@
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <event2/event.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#include "TristLib/Event.h"
+
+using namespace TristLib::Event;
+
+/**
+ * @brief Create an eventfd for a new flag
+ */
+static int CreateEventFd() {
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "eventfd");
+    }
+    return fd;
+}
+
+
+
+/**
+ * @brief Initialize a counting flag
+ *
+ * Allocates a new eventfd and adds it to the run loop.
+ *
+ * @param loop Run loop to add the event source to
+ */
+CountingFlag::CountingFlag(const std::shared_ptr<RunLoop> &loop) : fd(CreateEventFd()) {
+    try {
+        this->makeEvent(loop);
+    } catch(...) {
+        close(this->fd);
+        throw;
+    }
+}
+
+/**
+ * @brief Initialize a counting flag with an existing eventfd
+ *
+ * This can be used to share a flag between processes: one process creates the flag, and passes
+ * its file descriptor to the other.
+ *
+ * @param loop Run loop to add the event source to
+ * @param fd An eventfd (which must not be in semaphore mode)
+ * @param closeFd When set, the descriptor is closed when the flag is deallocated (or if its
+ *        initialization fails)
+ *
+ * @remark The descriptor will be made non-blocking.
+ */
+CountingFlag::CountingFlag(const std::shared_ptr<RunLoop> &loop, const int fd, const bool closeFd) :
+    fd(fd), closeFd(closeFd) {
+    try {
+        int err = evutil_make_socket_nonblocking(fd);
+        if(err == -1) {
+            throw std::system_error(errno, std::generic_category(),
+                    "evutil_make_socket_nonblocking");
+        }
+
+        this->makeEvent(loop);
+    } catch(...) {
+        if(closeFd) {
+            close(fd);
+        }
+        throw;
+    }
+}
+
+/**
+ * @brief Clean up flag resources
+ */
+CountingFlag::~CountingFlag() {
+    if(this->event) {
+        event_del(this->event);
+        event_free(this->event);
+    }
+
+    if(this->closeFd) {
+        close(this->fd);
+    }
+}
+
+/**
+ * @brief Create the event observing the eventfd
+ *
+ * @param loop Run loop to add the source to
+ */
+void CountingFlag::makeEvent(const std::shared_ptr<RunLoop> &loop) {
+    this->event = event_new(loop->getEvBase(), this->fd, EV_READ | EV_PERSIST,
+            [](auto, auto, auto ctx) {
+        reinterpret_cast<CountingFlag *>(ctx)->handleEvent();
+    }, this);
+    if(!this->event) {
+        throw std::runtime_error("failed to allocate flag event");
+    }
+
+    if(event_add(this->event, nullptr) != 0) {
+        event_free(this->event);
+        this->event = nullptr;
+        throw std::runtime_error("failed to add flag to run loop");
+    }
+}
+
+/**
+ * @brief Read the accumulated count and invoke the callback
+ *
+ * Reading the eventfd resets its counter to zero, so all signals since the last invocation are
+ * reported at once.
+ */
+void CountingFlag::handleEvent() {
+    uint64_t count{0};
+
+    if(::read(this->fd, &count, sizeof(count)) != sizeof(count)) {
+        // spurious wakeup (another reader drained the counter) or error
+        return;
+    }
+
+    if(this->callback) {
+        this->callback(this, count);
+    }
+}
+
+/**
+ * @brief Signal the flag
+ *
+ * Add to the flag's counter, waking up the run loop if needed. This is safe to call from any
+ * thread, and is async-signal-safe.
+ *
+ * @param count Value to add to the counter
+ *
+ * @remark If the counter would overflow, the signal is discarded; the run loop is guaranteed to be
+ *         woken up in that case anyways.
+ */
+void CountingFlag::signal(const uint64_t count) noexcept {
+    const auto savedErrno = errno;
+
+    // cannot fail, except with EAGAIN on overflow, where the flag's already readable
+    [[maybe_unused]] auto written = ::write(this->fd, &count, sizeof(count));
+
+    errno = savedErrno;
+}
@@ -15,6 +15,9 @@ using namespace TristLib::Event;
  * @param fd File descriptor to observe
  */
 FileDescriptor::FileDescriptor(const std::shared_ptr<RunLoop> &loop, const int fd) : fd(fd) {
+    // allocate libevent resources from the run loop's pool
+    LoopAllocator::Scope scope(loop->getAllocator());
+
     // create the event
     auto ev = event_new(loop->getEvBase(), fd, EV_READ | EV_WRITE | EV_CLOSED | EV_PERSIST,
             [](auto fd, auto what, auto ctx) {
@@ -52,17 +55,17 @@ FileDescriptor::~FileDescriptor() {
 void FileDescriptor::handleEvents(const short events) {
     if(events & EV_READ) {
         if(this->readCallback && this->readEnabled) {
-            (*this->readCallback)(this);
+            this->readCallback(this);
         }
     }
     if(events & EV_WRITE) {
         if(this->writeCallback && this->writeEnabled) {
-            (*this->writeCallback)(this);
+            this->writeCallback(this);
         }
     }
     if(events & EV_CLOSED) {
         if(this->eventCallback) {
-            (*this->eventCallback)(this);
+            this->eventCallback(this);
         }
     }
 }
@@ -0,0 +1,473 @@
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <event2/event.h>
+#include <plog/Log.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+#include "TristLib/Event.h"
+
+#ifdef CONFIG_WITH_LIBURING
+#include <liburing.h>
+#endif
+
+using namespace TristLib::Event;
+
+/**
+ * @brief Check whether io_uring support is available
+ *
+ * @remark Even if this returns `true`, the kernel may not support io_uring (or it may be disabled)
+ *         in which case queues fall back to the thread pool.
+ */
+bool FileQueue::SupportsIoUring() noexcept {
+#if defined(CONFIG_WITH_LIBURING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
+/**
+ * @brief Initialize a file IO queue
+ *
+ * Try to set up an io_uring instance for the queue; if that fails, start the fallback thread pool
+ * instead.
+ *
+ * @param loop Run loop on which requests complete
+ * @param depth Maximum number of requests that are submitted to io_uring at once
+ */
+FileQueue::FileQueue(const std::shared_ptr<RunLoop> &loop, const size_t depth) : loop(loop) {
+    this->submitEvent = event_new(loop->getEvBase(), -1, 0, [](auto, auto, auto ctx) {
+        reinterpret_cast<FileQueue *>(ctx)->submitPending();
+    }, this);
+    if(!this->submitEvent) {
+        throw std::runtime_error("failed to allocate file queue event");
+    }
+
+    try {
+#if defined(CONFIG_WITH_LIBURING)
+        int err;
+        auto ring = new struct io_uring;
+
+        err = io_uring_queue_init(depth, ring, 0);
+        if(err < 0) {
+            PLOG_WARNING << "io_uring_queue_init failed (" << strerror(-err)
+                         << "), using thread pool for file IO";
+            delete ring;
+        } else {
+            this->ring = ring;
+
+            this->ringEventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if(this->ringEventFd == -1) {
+                throw std::system_error(errno, std::generic_category(), "eventfd");
+            }
+
+            err = io_uring_register_eventfd(this->ring, this->ringEventFd);
+            if(err < 0) {
+                throw std::system_error(-err, std::generic_category(),
+                        "io_uring_register_eventfd");
+            }
+
+            this->ringEvent = event_new(loop->getEvBase(), this->ringEventFd,
+                    EV_READ | EV_PERSIST, [](auto, auto, auto ctx) {
+                reinterpret_cast<FileQueue *>(ctx)->reapRing();
+            }, this);
+            if(!this->ringEvent) {
+                throw std::runtime_error("failed to allocate file queue completion event");
+            }
+        }
+#endif
+
+        if(!this->ring) {
+            this->pool = std::make_unique<WorkPool>(kPoolThreads);
+        }
+    } catch(...) {
+        this->release();
+        throw;
+    }
+}
+
+/**
+ * @brief Shut down the file IO queue
+ *
+ * Requests that were never submitted are discarded. Requests in flight on io_uring are waited
+ * for, without invoking their callbacks; those running on the thread pool are completed, and
+ * their callbacks are still invoked on the run loop.
+ */
+FileQueue::~FileQueue() {
+    this->release();
+}
+
+/**
+ * @brief Release all resources of the queue
+ *
+ * This is also used to clean up after a partially constructed queue.
+ */
+void FileQueue::release() {
+#if defined(CONFIG_WITH_LIBURING)
+    if(this->ring) {
+        while(this->ringInFlight) {
+            struct io_uring_cqe *cqe;
+            if(io_uring_wait_cqe(this->ring, &cqe) < 0) {
+                break;
+            }
+
+            delete reinterpret_cast<Request *>(io_uring_cqe_get_data(cqe));
+            io_uring_cqe_seen(this->ring, cqe);
+            this->ringInFlight--;
+        }
+
+        io_uring_queue_exit(this->ring);
+        delete this->ring;
+    }
+#endif
+
+    // finish any requests running on the pool before the events go away
+    this->pool.reset();
+
+    if(this->ringEvent) {
+        event_del(this->ringEvent);
+        event_free(this->ringEvent);
+    }
+    if(this->ringEventFd != -1) {
+        close(this->ringEventFd);
+    }
+
+    event_del(this->submitEvent);
+    event_free(this->submitEvent);
+}
+
+
+
+/**
+ * @brief Open a file
+ *
+ * @param path Path of the file to open
+ * @param flags Flags for `open()`
+ * @param mode Mode for newly created files
+ * @param callback Invoked with the file descriptor of the opened file
+ */
+void FileQueue::open(const std::filesystem::path &path, const int flags, const mode_t mode,
+        const Callback &callback) {
+    auto req = std::make_unique<Request>();
+    req->op = Operation::Open;
+    req->path = path.native();
+    req->flags = flags | O_CLOEXEC;
+    req->mode = mode;
+    req->callback = callback;
+
+    this->enqueue(std::move(req));
+}
+
+/**
+ * @brief Read from a file at a given offset
+ *
+ * @param fd File to read from
+ * @param buffer Buffer to receive the data
+ * @param offset Offset into the file at which to start reading
+ * @param callback Invoked with the number of bytes read
+ */
+void FileQueue::read(const int fd, std::span<std::byte> buffer, const off_t offset,
+        const Callback &callback) {
+    auto req = std::make_unique<Request>();
+    req->op = Operation::Read;
+    req->fd = fd;
+    req->buffer = buffer.data();
+    req->length = buffer.size();
+    req->offset = offset;
+    req->callback = callback;
+
+    this->enqueue(std::move(req));
+}
+
+/**
+ * @brief Write to a file at a given offset
+ *
+ * @param fd File to write to
+ * @param buffer Data to write
+ * @param offset Offset into the file at which to start writing
+ * @param callback Invoked with the number of bytes written
+ */
+void FileQueue::write(const int fd, std::span<const std::byte> buffer, const off_t offset,
+        const Callback &callback) {
+    auto req = std::make_unique<Request>();
+    req->op = Operation::Write;
+    req->fd = fd;
+    req->buffer = const_cast<std::byte *>(buffer.data());
+    req->length = buffer.size();
+    req->offset = offset;
+    req->callback = callback;
+
+    this->enqueue(std::move(req));
+}
+
+/**
+ * @brief Flush a file to stable storage
+ *
+ * @param fd File to sync
+ * @param dataOnly When set, only the file's data (and metadata required to read it) is synced, as
+ *        with `fdatasync()`
+ * @param callback Invoked when the sync completes
+ */
+void FileQueue::sync(const int fd, const bool dataOnly, const Callback &callback) {
+    auto req = std::make_unique<Request>();
+    req->op = Operation::Sync;
+    req->fd = fd;
+    req->flags = dataOnly ? 1 : 0;
+    req->callback = callback;
+
+    this->enqueue(std::move(req));
+}
+
+/**
+ * @brief Allocate (or deallocate) space in a file
+ *
+ * @param fd File to allocate space in
+ * @param mode Mode for `fallocate()`, such as `FALLOC_FL_KEEP_SIZE`
+ * @param offset Start of the region to allocate
+ * @param length Length of the region to allocate
+ * @param callback Invoked when the allocation completes
+ */
+void FileQueue::allocate(const int fd, const int mode, const off_t offset, const off_t length,
+        const Callback &callback) {
+    auto req = std::make_unique<Request>();
+    req->op = Operation::Allocate;
+    req->fd = fd;
+    req->flags = mode;
+    req->offset = offset;
+    req->length = length;
+    req->callback = callback;
+
+    this->enqueue(std::move(req));
+}
+
+
+
+/**
+ * @brief Queue a request for submission
+ *
+ * The first request queued during a run loop iteration activates the submit event, so that all
+ * requests made during the iteration are submitted together.
+ */
+void FileQueue::enqueue(std::unique_ptr<Request> &&request) {
+    if(this->pending.empty()) {
+        event_active(this->submitEvent, EV_READ, 0);
+    }
+
+    this->pending.emplace_back(std::move(request));
+}
+
+/**
+ * @brief Submit all pending requests
+ */
+void FileQueue::submitPending() {
+    if(this->ring) {
+        this->submitRing();
+    } else {
+        this->submitPool();
+    }
+}
+
+/**
+ * @brief Submit pending requests to io_uring
+ *
+ * Requests are converted to submission queue entries until either all are converted, or the
+ * submission queue is full; then, they're all submitted with a single system call. Any remaining
+ * requests are submitted on the next run loop iteration.
+ *
+ * If the submission fails, the entries are turned into no-ops (they remain in the submission
+ * queue) and their requests fail with the error.
+ */
+void FileQueue::submitRing() {
+#if defined(CONFIG_WITH_LIBURING)
+    std::vector<struct io_uring_sqe *> prepared;
+
+    for(auto &req : this->pending) {
+        auto sqe = io_uring_get_sqe(this->ring);
+        if(!sqe) {
+            break;
+        }
+
+        switch(req->op) {
+            case Operation::Open:
+                io_uring_prep_openat(sqe, AT_FDCWD, req->path.c_str(), req->flags, req->mode);
+                break;
+            case Operation::Read:
+                io_uring_prep_read(sqe, req->fd, req->buffer, req->length, req->offset);
+                break;
+            case Operation::Write:
+                io_uring_prep_write(sqe, req->fd, req->buffer, req->length, req->offset);
+                break;
+            case Operation::Sync:
+                io_uring_prep_fsync(sqe, req->fd, req->flags ? IORING_FSYNC_DATASYNC : 0);
+                break;
+            case Operation::Allocate:
+                io_uring_prep_fallocate(sqe, req->fd, req->flags, req->offset, req->length);
+                break;
+        }
+
+        io_uring_sqe_set_data(sqe, req.get());
+        prepared.push_back(sqe);
+    }
+
+    if(prepared.empty()) {
+        return;
+    }
+
+    // requests are owned by the ring once submitted
+    std::vector<std::unique_ptr<Request>> requests(
+            std::make_move_iterator(this->pending.begin()),
+            std::make_move_iterator(this->pending.begin() + prepared.size()));
+    this->pending.erase(this->pending.begin(), this->pending.begin() + prepared.size());
+
+    if(!this->pending.empty()) {
+        event_active(this->submitEvent, EV_READ, 0);
+    }
+
+    const int err = io_uring_submit(this->ring);
+    if(err < 0) {
+        PLOG_WARNING << "io_uring_submit failed: " << strerror(-err);
+
+        for(auto sqe : prepared) {
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, nullptr);
+        }
+        for(auto &req : requests) {
+            if(req->callback) {
+                req->callback(err);
+            }
+        }
+        return;
+    }
+
+    for(auto &req : requests) {
+        req.release();
+    }
+
+    // this may include no-ops left over from failed submissions
+    if(err) {
+        if(!this->ringInFlight) {
+            event_add(this->ringEvent, nullptr);
+        }
+        this->ringInFlight += err;
+    }
+#endif
+}
+
+/**
+ * @brief Process io_uring completions
+ *
+ * Invoke the callbacks of all completed requests.
+ */
+void FileQueue::reapRing() {
+#if defined(CONFIG_WITH_LIBURING)
+    uint64_t value;
+    [[maybe_unused]] auto numRead = ::read(this->ringEventFd, &value, sizeof(value));
+
+    struct io_uring_cqe *cqe;
+    while(io_uring_peek_cqe(this->ring, &cqe) == 0) {
+        std::unique_ptr<Request> req(reinterpret_cast<Request *>(io_uring_cqe_get_data(cqe)));
+        const int64_t result = cqe->res;
+
+        io_uring_cqe_seen(this->ring, cqe);
+
+        if(!--this->ringInFlight) {
+            event_del(this->ringEvent);
+        }
+
+        if(req && req->callback) {
+            req->callback(result);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Submit pending requests to the thread pool
+ *
+ * Each request is executed as a separate job; if the pool is at capacity, the request fails with
+ * `EAGAIN`.
+ */
+void FileQueue::submitPool() {
+    auto loop = this->loop.lock();
+    if(!loop) {
+        return;
+    }
+
+    // callbacks invoked below may queue more requests
+    auto requests = std::move(this->pending);
+    this->pending.clear();
+
+    size_t i{0};
+    try {
+        for(; i < requests.size(); i++) {
+            std::shared_ptr<Request> shared(std::move(requests[i]));
+
+            bool queued;
+            try {
+                queued = this->pool->submit(loop, [shared] {
+                    return Execute(*shared);
+                }, [shared](const int64_t result) {
+                    if(shared->callback) {
+                        shared->callback(result);
+                    }
+                });
+            } catch(...) {
+                // nothing else holds the request if it wasn't queued
+                requests[i] = std::make_unique<Request>(std::move(*shared));
+                throw;
+            }
+
+            if(!queued && shared->callback) {
+                shared->callback(-EAGAIN);
+            }
+        }
+    } catch(...) {
+        // keep the requests not yet submitted, for the next run loop iteration
+        if(this->pending.empty()) {
+            event_active(this->submitEvent, EV_READ, 0);
+        }
+        this->pending.insert(this->pending.begin(), std::make_move_iterator(requests.begin() + i),
+                std::make_move_iterator(requests.end()));
+        throw;
+    }
+}
+
+/**
+ * @brief Execute a request synchronously
+ *
+ * This is used by the thread pool fallback.
+ *
+ * @return Result of the request, or a negated errno value
+ */
+int64_t FileQueue::Execute(const Request &req) {
+    int64_t ret{-1};
+
+    switch(req.op) {
+        case Operation::Open:
+            ret = ::open(req.path.c_str(), req.flags, req.mode);
+            break;
+        case Operation::Read:
+            ret = ::pread(req.fd, req.buffer, req.length, req.offset);
+            break;
+        case Operation::Write:
+            ret = ::pwrite(req.fd, req.buffer, req.length, req.offset);
+            break;
+        case Operation::Sync:
+            ret = req.flags ? ::fdatasync(req.fd) : ::fsync(req.fd);
+            break;
+        case Operation::Allocate:
+            ret = ::fallocate(req.fd, req.flags, req.offset, req.length);
+            break;
+    }
+
+    return (ret == -1) ? -errno : ret;
+}
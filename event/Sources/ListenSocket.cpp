@@ -6,13 +6,59 @@
 #include <event2/event.h>
 
 #include <cerrno>
+#include <cstring>
+#include <mutex>
 #include <stdexcept>
 #include <system_error>
+#include <unordered_set>
+#include <utility>
 
 #include "TristLib/Event.h"
 
+#ifdef CONFIG_WITH_SYSTEMD
+#include <systemd/sd-daemon.h>
+#endif
+
 using namespace TristLib::Event;
 
+#ifdef CONFIG_WITH_SYSTEMD
+/**
+ * @brief Release the socket names list returned by systemd
+ */
+static void FreeSystemdNames(char **names) {
+    for(size_t i = 0; names && names[i]; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+/// Protects the set of adopted systemd descriptors
+static std::mutex gSystemdLock;
+/// Descriptors passed in by systemd that have already been adopted
+static std::unordered_set<int> gSystemdAdopted;
+
+/**
+ * @brief Claim a descriptor passed in by systemd
+ *
+ * Each descriptor may only be adopted once, since the listening socket that adopts it takes
+ * ownership of (and eventually closes) it.
+ *
+ * @return Whether the descriptor was claimed; `false` if it had already been adopted
+ */
+static bool ClaimSystemdFd(const int fd) {
+    std::lock_guard guard(gSystemdLock);
+    return gSystemdAdopted.insert(fd).second;
+}
+
+/**
+ * @brief Release the claim on a descriptor, if adopting it failed
+ */
+static void UnclaimSystemdFd(const int fd) {
+    std::lock_guard guard(gSystemdLock);
+    gSystemdAdopted.erase(fd);
+}
+#endif
+
 
 
 /**
@@ -25,14 +71,19 @@ using namespace TristLib::Event;
  * @param fd File descriptor for a socket to receive clients on
  * @param closeFd When set, we'll close the file descriptor on release.
  *
- * @remark The specified socket must already be bound, but it _must not_ be listening already. It
- *         will be made non-blocking as part of this call.
+ * @remark The specified socket must already be bound. If it is already listening (for example,
+ *         because it was inherited from the service manager) its existing backlog is kept;
+ *         otherwise we'll start listening on it. It will be made non-blocking as part of this
+ *         call.
  */
-ListenSocket::ListenSocket(const std::shared_ptr<RunLoop> &loop, const AcceptCallback &callback,
-        const int fd, const bool closeFd) : callback(callback), fd(fd), closeFd(closeFd) {
+ListenSocket::ListenSocket(const std::shared_ptr<RunLoop> &loop, AcceptCallback callback,
+        const int fd, const bool closeFd) : callback(std::move(callback)), fd(fd),
+    closeFd(closeFd) {
     // prepare socket
     MakeSocketNonblocking(fd);
-    this->listen();
+    if(!IsSocketListening(fd)) {
+        this->listen();
+    }
 
     // create the event
     this->makeEvent(loop);
@@ -50,9 +101,9 @@ ListenSocket::ListenSocket(const std::shared_ptr<RunLoop> &loop, const AcceptCal
  * @param unlinkOld Whether the previous file at the location shall be unlinked
  * @param type Socket type (one of the `SOCK_` constants)
  */
-ListenSocket::ListenSocket(const std::shared_ptr<RunLoop> &loop, const AcceptCallback &callback,
+ListenSocket::ListenSocket(const std::shared_ptr<RunLoop> &loop, AcceptCallback callback,
         const std::filesystem::path &fsPath, const bool unlinkOld, const int type) :
-    callback(callback), fd(CreateSocket(fsPath, unlinkOld, type)) {
+    callback(std::move(callback)), fd(CreateSocket(fsPath, unlinkOld, type)) {
     // prepare it and create an event
     MakeSocketNonblocking(this->fd);
     this->listen();
@@ -76,6 +127,329 @@ ListenSocket::~ListenSocket() {
     }
 }
 
+
+
+/**
+ * @brief Check whether systemd socket activation is supported
+ */
+bool ListenSocket::SupportsSocketActivation() noexcept {
+#if defined(CONFIG_WITH_SYSTEMD)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Adopt all sockets passed in by systemd
+ *
+ * Create a listening socket event source for each socket passed to us by the service manager
+ * (via the `LISTEN_FDS` and `LISTEN_FDNAMES` environment variables.) Each socket is named
+ * according to its socket unit's `FileDescriptorName=` setting.
+ *
+ * @remark Each descriptor is adopted only once: sockets that were already adopted (by a previous
+ *         call to either variant of this method) are skipped.
+ *
+ * @param loop Run loop to install the event sources on
+ * @param callback Callback to invoke on pending client, for all sockets
+ *
+ * @return List of sockets; it's empty if we were not socket activated.
+ */
+std::vector<std::shared_ptr<ListenSocket>> ListenSocket::FromSystemd(
+        const std::shared_ptr<RunLoop> &loop, AcceptCallback callback) {
+    std::vector<std::shared_ptr<ListenSocket>> sockets;
+
+#if defined(CONFIG_WITH_SYSTEMD)
+    // the sockets share a single callback
+    const auto shared = std::make_shared<AcceptCallback>(std::move(callback));
+
+    char **names{nullptr};
+
+    const int numFds = sd_listen_fds_with_names(0, &names);
+    if(numFds < 0) {
+        throw std::system_error(-numFds, std::generic_category(), "sd_listen_fds_with_names");
+    }
+
+    try {
+        for(int i = 0; i < numFds; i++) {
+            const int fd = SD_LISTEN_FDS_START + i;
+            if(!ClaimSystemdFd(fd)) {
+                continue;
+            }
+
+            std::shared_ptr<ListenSocket> socket;
+            try {
+                socket = std::make_shared<ListenSocket>(loop, [shared](auto listener) {
+                    (*shared)(listener);
+                }, fd, true);
+            } catch(...) {
+                UnclaimSystemdFd(fd);
+                throw;
+            }
+
+            if(names && names[i]) {
+                socket->name = names[i];
+            }
+            sockets.emplace_back(std::move(socket));
+        }
+    } catch(...) {
+        FreeSystemdNames(names);
+        throw;
+    }
+
+    FreeSystemdNames(names);
+#else
+    throw std::runtime_error("socket activation not supported on this platform");
+#endif
+
+    return sockets;
+}
+
+/**
+ * @brief Adopt a single named socket passed in by systemd
+ *
+ * Find the socket passed to us by the service manager with the given name, and create a listening
+ * socket event source for it.
+ *
+ * @param loop Run loop to install the event source on
+ * @param callback Callback to invoke on pending client
+ * @param name Name of the socket (`FileDescriptorName=` in the socket unit)
+ *
+ * @return Socket event source, or `nullptr` if no such socket was passed in (or it has already
+ *         been adopted.)
+ */
+std::shared_ptr<ListenSocket> ListenSocket::FromSystemd(const std::shared_ptr<RunLoop> &loop,
+        AcceptCallback callback, const std::string_view name) {
+#if defined(CONFIG_WITH_SYSTEMD)
+    char **names{nullptr};
+    int found{-1};
+
+    const int numFds = sd_listen_fds_with_names(0, &names);
+    if(numFds < 0) {
+        throw std::system_error(-numFds, std::generic_category(), "sd_listen_fds_with_names");
+    }
+
+    for(int i = 0; i < numFds && names; i++) {
+        if(found == -1 && names[i] && name == names[i] &&
+                ClaimSystemdFd(SD_LISTEN_FDS_START + i)) {
+            found = SD_LISTEN_FDS_START + i;
+        }
+    }
+
+    FreeSystemdNames(names);
+
+    if(found == -1) {
+        return nullptr;
+    }
+
+    std::shared_ptr<ListenSocket> socket;
+    try {
+        socket = std::make_shared<ListenSocket>(loop, std::move(callback), found, true);
+    } catch(...) {
+        UnclaimSystemdFd(found);
+        throw;
+    }
+
+    socket->name = name;
+    return socket;
+#else
+    throw std::runtime_error("socket activation not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Pass listening sockets to another process
+ *
+ * Send the file descriptors (and names) of the given sockets over an UNIX domain socket, which
+ * should be a connection accepted on a `SOCK_SEQPACKET` handoff socket. This blocks until the
+ * receiving process has adopted the sockets and acknowledged them.
+ *
+ * Once this returns, the caller should `suspend()` the sockets so that all new clients are
+ * accepted by the new process, then drain its existing connections and exit.
+ *
+ * @param channel Connected UNIX domain socket to the receiving process
+ * @param sockets Listening sockets to pass
+ */
+void ListenSocket::SendHandoff(const int channel,
+        std::span<const std::shared_ptr<ListenSocket>> sockets) {
+    if(sockets.empty()) {
+        throw std::invalid_argument("sockets list may not be empty");
+    } else if(sockets.size() > kMaxHandoffSockets) {
+        throw std::invalid_argument("too many sockets for handoff");
+    }
+
+    // build the payload: the NUL terminated name for each socket, in order
+    std::vector<char> payload;
+    std::vector<int> fds;
+
+    for(const auto &socket : sockets) {
+        payload.insert(payload.end(), socket->name.begin(), socket->name.end());
+        payload.push_back('\0');
+        fds.push_back(socket->fd);
+    }
+
+    // send it along with the file descriptors
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+    struct iovec iov{
+        .iov_base = payload.data(),
+        .iov_len = payload.size(),
+    };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+    if(sendmsg(channel, &msg, MSG_NOSIGNAL) == -1) {
+        throw std::system_error(errno, std::generic_category(), "send handoff");
+    }
+
+    // wait for the acknowledgement
+    char ack;
+    int err;
+    do {
+        err = recv(channel, &ack, sizeof(ack), 0);
+    } while(err == -1 && errno == EINTR);
+
+    if(err == -1) {
+        throw std::system_error(errno, std::generic_category(), "receive handoff ack");
+    } else if(!err) {
+        throw std::runtime_error("handoff receiver disconnected before acknowledging");
+    }
+}
+
+/**
+ * @brief Receive listening sockets from another process
+ *
+ * Connect to the handoff socket of a running instance, and adopt the listening sockets it passes
+ * to us. Once all sockets have been installed on the run loop, the sender is notified, at which
+ * point it will stop accepting new clients.
+ *
+ * @param loop Run loop to install the event sources on
+ * @param callback Callback to invoke on pending client, for all sockets
+ * @param path Filesystem path of the (`SOCK_SEQPACKET`) handoff socket
+ *
+ * @return List of sockets received, in the order the sender specified them.
+ *
+ * @remark If no process is listening on the handoff socket, a `std::system_error` is thrown; the
+ *         caller should fall back to creating its own sockets in that case.
+ */
+std::vector<std::shared_ptr<ListenSocket>> ListenSocket::ReceiveHandoff(
+        const std::shared_ptr<RunLoop> &loop, AcceptCallback callback,
+        const std::filesystem::path &path) {
+    int err;
+    std::vector<std::shared_ptr<ListenSocket>> sockets;
+
+    // connect to the old process
+    const int channel = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if(channel == -1) {
+        throw std::system_error(errno, std::generic_category(), "create socket");
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.native().c_str(), sizeof(addr.sun_path) - 1);
+
+    err = connect(channel, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+    if(err == -1) {
+        const auto errnoCopy = errno;
+        close(channel);
+        throw std::system_error(errnoCopy, std::generic_category(), "connect handoff socket");
+    }
+
+    // receive the descriptors (and their names)
+    std::vector<char> payload(kMaxHandoffSockets * 256);
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * kMaxHandoffSockets));
+    struct iovec iov{
+        .iov_base = payload.data(),
+        .iov_len = payload.size(),
+    };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    ssize_t received;
+    do {
+        received = recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+    } while(received == -1 && errno == EINTR);
+
+    if(received == -1) {
+        const auto errnoCopy = errno;
+        close(channel);
+        throw std::system_error(errnoCopy, std::generic_category(), "receive handoff");
+    }
+
+    std::vector<int> fds;
+    for(auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if(cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+
+        const auto numFds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const auto oldSize = fds.size();
+        fds.resize(oldSize + numFds);
+        memcpy(fds.data() + oldSize, CMSG_DATA(cmsg), numFds * sizeof(int));
+    }
+
+    // create sockets for each received descriptor; they're closed by the sockets from here on
+    try {
+        if(msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+            throw std::runtime_error("handoff message truncated");
+        }
+
+        size_t nameOffset{0};
+        // the sockets share a single callback
+        const auto shared = std::make_shared<AcceptCallback>(std::move(callback));
+
+        for(const auto fd : fds) {
+            auto socket = std::make_shared<ListenSocket>(loop, [shared](auto listener) {
+                (*shared)(listener);
+            }, fd, true);
+
+            if(nameOffset < static_cast<size_t>(received)) {
+                socket->name = std::string(payload.data() + nameOffset);
+                nameOffset += socket->name.size() + 1;
+            }
+
+            sockets.emplace_back(std::move(socket));
+        }
+    } catch(...) {
+        for(size_t i = sockets.size(); i < fds.size(); i++) {
+            close(fds[i]);
+        }
+        close(channel);
+        throw;
+    }
+
+    // then acknowledge receipt
+    const char ack{1};
+    err = send(channel, &ack, sizeof(ack), MSG_NOSIGNAL);
+    const auto errnoCopy = errno;
+    close(channel);
+
+    if(err == -1) {
+        throw std::system_error(errnoCopy, std::generic_category(), "send handoff ack");
+    }
+
+    return sockets;
+}
+
+
+
 /**
  * @brief Allocate an UNIX domain socket
  *
@@ -112,8 +486,9 @@ int ListenSocket::CreateSocket(const std::filesystem::path &path, const bool unl
 
     err = bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
     if(err == -1) {
+        const auto errnoCopy = errno;
         close(fd);
-        throw std::system_error(errno, std::generic_category(), "bind socket");
+        throw std::system_error(errnoCopy, std::generic_category(), "bind socket");
     }
 
     return fd;
@@ -159,6 +534,25 @@ void ListenSocket::MakeSocketNonblocking(const int fd) {
     }
 }
 
+/**
+ * @brief Check whether a socket is listening already
+ *
+ * @param fd File descriptor for a socket to check
+ *
+ * @return Whether the socket is in the listening state
+ */
+bool ListenSocket::IsSocketListening(const int fd) {
+    int listening{0};
+    socklen_t len{sizeof(listening)};
+
+    int err = getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &len);
+    if(err == -1) {
+        throw std::system_error(errno, std::generic_category(), "get socket listen state");
+    }
+
+    return !!listening;
+}
+
 /**
  * @brief Start listening for connections
  *
@@ -185,3 +579,23 @@ int ListenSocket::accept() {
 
     return fd;
 }
+
+/**
+ * @brief Stop accepting clients
+ *
+ * Remove the socket's event from the run loop, so the accept callback is no longer invoked. The
+ * socket remains open, and clients continue to be queued; this is useful when handing off the
+ * socket to another process, which then accepts the clients instead.
+ */
+void ListenSocket::suspend() {
+    event_del(this->event);
+}
+
+/**
+ * @brief Resume accepting clients
+ *
+ * Re-add the socket's event to the run loop after it was suspended.
+ */
+void ListenSocket::resume() {
+    event_add(this->event, nullptr);
+}
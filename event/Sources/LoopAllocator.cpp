@@ -0,0 +1,307 @@
+#include <event2/event.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include <plog/Log.h>
+
+#include "TristLib/Event/LoopAllocator.h"
+
+using namespace TristLib::Event;
+
+thread_local LoopAllocator *LoopAllocator::gCurrent{nullptr};
+
+namespace {
+#if defined(CONFIG_WITH_POOLED_LIBEVENT) && defined(EVENT_SET_MEM_FUNCTIONS_IMPLEMENTED)
+/**
+ * @brief Route libevent's allocations through the loop allocators
+ *
+ * libevent must not have allocated anything before its allocator is replaced (it would pass that
+ * memory to our free function later) so this runs before any regular static constructors.
+ */
+__attribute__((constructor(101))) void InstallLibeventAllocator() {
+    event_set_mem_functions(LoopAllocator::Allocate, LoopAllocator::Reallocate,
+            LoopAllocator::Free);
+}
+#endif
+}
+
+
+
+/**
+ * @brief Release all slabs
+ */
+LoopAllocator::~LoopAllocator() {
+    while(this->slabs) {
+        auto previous = *reinterpret_cast<std::byte **>(this->slabs);
+        std::free(this->slabs);
+        this->slabs = previous;
+    }
+}
+
+/**
+ * @brief Dispose of an allocator
+ *
+ * Drops the owner's reference to the allocator. If memory allocated from it is still in use, the
+ * allocator (and its slabs) lives on until the last of it is freed; otherwise it's deleted now.
+ */
+void LoopAllocator::Release(LoopAllocator *allocator) {
+    const auto stats = allocator->getStats();
+    if(stats.objects) {
+        PLOG_DEBUG << "Releasing run loop allocator with about " << stats.objects
+                   << " live allocations (" << stats.bytes << " bytes)";
+    }
+
+    allocator->unref();
+}
+
+
+
+/**
+ * @brief Allocate memory from the pool
+ *
+ * This must only be called from the allocator's thread.
+ *
+ * @return Pointer to the memory, or `nullptr` if out of memory
+ */
+void *LoopAllocator::allocate(const size_t size) {
+    static_assert(GetClassSize(GetSizeClass(kMaxPooledSize)) == kMaxPooledSize);
+    static_assert(GetSizeClass(kMaxPooledSize) == kNumClasses - 1);
+
+    if(size > std::numeric_limits<uint32_t>::max()) {
+        return nullptr;
+    }
+
+    if(this->remoteFrees.load(std::memory_order_relaxed)) {
+        this->drainRemote();
+    }
+
+    Header *header;
+    if(size > kMaxPooledSize) {
+        header = static_cast<Header *>(std::malloc(sizeof(Header) + size));
+        if(!header) {
+            return nullptr;
+        }
+        header->sizeClass = kHeapClass;
+    } else {
+        const auto sizeClass = GetSizeClass(size);
+
+        header = this->freeLists[sizeClass];
+        if(header) {
+            this->freeLists[sizeClass] = header->getNext();
+        } else if(!(header = this->carve(sizeClass))) {
+            return nullptr;
+        }
+        header->sizeClass = sizeClass;
+    }
+
+    header->owner = this;
+    header->size = size;
+
+    this->refs.fetch_add(1, std::memory_order_relaxed);
+    Add(this->objects, 1);
+    Add(this->bytes, size);
+
+    return header + 1;
+}
+
+/**
+ * @brief Carve a new block out of the current slab
+ *
+ * If the current slab is exhausted, a new one is allocated; the remainder of the old one is
+ * wasted.
+ */
+LoopAllocator::Header *LoopAllocator::carve(const size_t sizeClass) {
+    const size_t needed = sizeof(Header) + GetClassSize(sizeClass);
+
+    if(static_cast<size_t>(this->slabEnd - this->slabCursor) < needed) {
+        auto slab = static_cast<std::byte *>(std::malloc(kSlabSize));
+        if(!slab) {
+            return nullptr;
+        }
+
+        *reinterpret_cast<std::byte **>(slab) = this->slabs;
+        this->slabs = slab;
+
+        this->slabCursor = slab + kAlignment;
+        this->slabEnd = slab + kSlabSize;
+        Add(this->reserved, kSlabSize);
+    }
+
+    auto header = reinterpret_cast<Header *>(this->slabCursor);
+    this->slabCursor += needed;
+    return header;
+}
+
+/**
+ * @brief Return blocks freed by other threads to the free lists
+ */
+void LoopAllocator::drainRemote() {
+    auto header = this->remoteFrees.exchange(nullptr, std::memory_order_acquire);
+
+    while(header) {
+        auto next = header->getNext();
+
+        header->getNext() = this->freeLists[header->sizeClass];
+        this->freeLists[header->sizeClass] = header;
+
+        header = next;
+    }
+}
+
+
+
+/**
+ * @brief Allocate memory from the current thread's allocator
+ *
+ * If the thread has no current allocator, memory is allocated from the heap.
+ */
+void *LoopAllocator::Allocate(const size_t size) {
+    if(auto allocator = gCurrent) {
+        return allocator->allocate(size);
+    }
+
+    auto header = static_cast<Header *>(std::malloc(sizeof(Header) + size));
+    if(!header) {
+        return nullptr;
+    }
+    header->owner = nullptr;
+    header->sizeClass = kHeapClass;
+    header->size = static_cast<uint32_t>(std::min<size_t>(size,
+                std::numeric_limits<uint32_t>::max()));
+    return header + 1;
+}
+
+/**
+ * @brief Resize memory allocated with `Allocate()`
+ *
+ * Memory is resized in place if its block is large enough; otherwise, it's moved to a new
+ * allocation from the current thread's allocator.
+ */
+void *LoopAllocator::Reallocate(void *ptr, const size_t size) {
+    if(!ptr) {
+        return Allocate(size);
+    }
+
+    auto header = static_cast<Header *>(ptr) - 1;
+    const auto owner = header->owner;
+
+    if(owner == gCurrent && size <= std::numeric_limits<uint32_t>::max()) {
+        // pooled block that's still large enough
+        if(header->sizeClass != kHeapClass) {
+            if(size <= GetClassSize(header->sizeClass)) {
+                if(owner) {
+                    Add(owner->bytes, size - header->size);
+                }
+                header->size = size;
+                return ptr;
+            }
+        }
+        // heap block (that stays one)
+        else if(!owner || size > kMaxPooledSize) {
+            const auto oldSize = header->size;
+            auto newHeader = static_cast<Header *>(std::realloc(header, sizeof(Header) + size));
+            if(!newHeader) {
+                return nullptr;
+            }
+            if(owner) {
+                Add(owner->bytes, size - oldSize);
+            }
+            newHeader->size = size;
+            return newHeader + 1;
+        }
+    }
+
+    auto newPtr = Allocate(size);
+    if(newPtr) {
+        std::memcpy(newPtr, ptr, std::min<size_t>(size, header->size));
+        Free(ptr);
+    }
+    return newPtr;
+}
+
+/**
+ * @brief Free memory allocated with `Allocate()`
+ *
+ * This may be called from any thread; memory freed on a thread other than that of the allocator
+ * it came from is handed back to that allocator. Freeing the last allocation of an allocator that
+ * was already released deletes it.
+ */
+void LoopAllocator::Free(void *ptr) {
+    if(!ptr) {
+        return;
+    }
+
+    auto header = static_cast<Header *>(ptr) - 1;
+    const auto owner = header->owner;
+    const size_t size = header->size;
+
+    if(!owner) {
+        std::free(header);
+        return;
+    }
+
+    if(owner == gCurrent) {
+        Add(owner->objects, -1);
+        Add(owner->bytes, -size);
+
+        if(header->sizeClass == kHeapClass) {
+            std::free(header);
+        } else {
+            header->getNext() = owner->freeLists[header->sizeClass];
+            owner->freeLists[header->sizeClass] = header;
+        }
+    } else {
+        owner->remoteObjects.fetch_add(1, std::memory_order_relaxed);
+        owner->remoteBytes.fetch_add(size, std::memory_order_relaxed);
+
+        if(header->sizeClass == kHeapClass) {
+            std::free(header);
+        } else {
+            auto head = owner->remoteFrees.load(std::memory_order_relaxed);
+            do {
+                header->getNext() = head;
+            } while(!owner->remoteFrees.compare_exchange_weak(head, header,
+                        std::memory_order_release, std::memory_order_relaxed));
+        }
+    }
+
+    // the allocator may be deleted past this point
+    owner->unref();
+}
+
+
+
+/**
+ * @brief Free memory that libevent allocated on behalf of the application
+ *
+ * Some libevent functions (such as `evbuffer_readln()`) return memory that the caller must free;
+ * it comes from the loop allocators if libevent's allocations are pooled, and from the heap
+ * otherwise. This releases it either way, so use it instead of `free()` for all such memory.
+ */
+void LoopAllocator::FreeLibevent(void *ptr) {
+#if defined(CONFIG_WITH_POOLED_LIBEVENT) && defined(EVENT_SET_MEM_FUNCTIONS_IMPLEMENTED)
+    Free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+
+
+/**
+ * @brief Get the allocator's statistics
+ *
+ * This may be called from any thread; the values are approximate while the allocator is in use.
+ */
+LoopAllocator::Stats LoopAllocator::getStats() const {
+    return {
+        .objects = this->objects.load(std::memory_order_relaxed) -
+            this->remoteObjects.load(std::memory_order_relaxed),
+        .bytes = this->bytes.load(std::memory_order_relaxed) -
+            this->remoteBytes.load(std::memory_order_relaxed),
+        .reserved = this->reserved.load(std::memory_order_relaxed),
+    };
+}
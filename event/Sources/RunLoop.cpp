@@ -1,7 +1,13 @@
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 #include <event2/event.h>
+#include <plog/Log.h>
 
 #include <cerrno>
+#include <exception>
 #include <stdexcept>
+#include <system_error>
 
 #include "TristLib/Event.h"
 
@@ -20,21 +26,56 @@ thread_local std::weak_ptr<RunLoop> RunLoop::gCurrentRunLoop;
  * @brief Initialize the event loop
  */
 RunLoop::RunLoop() {
+    this->allocator = new LoopAllocator;
+    LoopAllocator::Scope scope(*this->allocator);
+
     this->evbase = event_base_new();
     if(!this->evbase) {
+        LoopAllocator::Release(this->allocator);
         throw std::runtime_error("failed to allocate event_base");
     }
+
+    // set up the post queue's wakeup event (it's not added until a post is reserved)
+    this->postFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(this->postFd == -1) {
+        const auto errnoCopy = errno;
+        event_base_free(this->evbase);
+        LoopAllocator::Release(this->allocator);
+        throw std::system_error(errnoCopy, std::generic_category(), "eventfd");
+    }
+
+    this->postEvent = event_new(this->evbase, this->postFd, EV_READ | EV_PERSIST,
+            [](auto, auto, auto ctx) {
+        reinterpret_cast<RunLoop *>(ctx)->drainPosted();
+    }, this);
+    if(!this->postEvent) {
+        close(this->postFd);
+        event_base_free(this->evbase);
+        LoopAllocator::Release(this->allocator);
+        throw std::runtime_error("failed to allocate post event");
+    }
 }
 
 /**
  * @brief Release event loop resources
  *
+ * The loop's memory pool is released too; if event sources allocated from it are still alive, it's
+ * deleted once the last of them is.
+ *
  * @remark The event loop should be stopped when destroying.
  */
 RunLoop::~RunLoop() {
     // TODO: could we check and remove any pending events?
+    {
+        LoopAllocator::Scope scope(*this->allocator);
+
+        event_free(this->postEvent);
+        close(this->postFd);
 
-    event_base_free(this->evbase);
+        event_base_free(this->evbase);
+    }
+
+    LoopAllocator::Release(this->allocator);
 }
 
 /**
@@ -48,6 +89,7 @@ RunLoop::~RunLoop() {
 void RunLoop::run() {
     this->activate();
 
+    LoopAllocator::Scope scope(*this->allocator);
     event_base_dispatch(this->evbase);
 }
 
@@ -59,3 +101,84 @@ void RunLoop::run() {
 void RunLoop::interrupt() {
     event_base_loopbreak(this->evbase);
 }
+
+
+/**
+ * @brief Reserve a post
+ *
+ * Indicate that a call to `post()` will be made later, usually from another thread, once some
+ * background work completes. While any posts are outstanding, the run loop will not exit due to a
+ * lack of pending events.
+ *
+ * @remark This must be called from the run loop's thread, before the corresponding `post()`.
+ */
+void RunLoop::reservePost() {
+    if(!this->postReservations++) {
+        event_add(this->postEvent, nullptr);
+    }
+}
+
+/**
+ * @brief Cancel a previously reserved post
+ *
+ * @remark This must be called from the run loop's thread.
+ */
+void RunLoop::cancelPost() {
+    if(!--this->postReservations) {
+        event_del(this->postEvent);
+    }
+}
+
+/**
+ * @brief Post work to the run loop
+ *
+ * Queue a function to be executed on the run loop's thread, and wake up the loop. This consumes
+ * one post reservation, which must have been made previously with `reservePost()`.
+ *
+ * This may be called from any thread.
+ *
+ * @param work Function to execute on the run loop; it may be empty, in which case only the
+ *        reservation is released.
+ */
+void RunLoop::post(Work &&work) {
+    {
+        std::lock_guard lg(this->postLock);
+        this->postQueue.emplace_back(std::move(work));
+    }
+
+    const uint64_t value{1};
+    [[maybe_unused]] auto written = write(this->postFd, &value, sizeof(value));
+}
+
+/**
+ * @brief Execute all posted work
+ *
+ * Invoked on the run loop when the post eventfd becomes readable.
+ *
+ * Exceptions thrown by the work are logged; they can't propagate through libevent, and the
+ * remaining work (and the release of its reservations) mustn't be abandoned.
+ */
+void RunLoop::drainPosted() {
+    uint64_t value;
+    [[maybe_unused]] auto numRead = read(this->postFd, &value, sizeof(value));
+
+    std::vector<Work> work;
+    {
+        std::lock_guard lg(this->postLock);
+        work.swap(this->postQueue);
+    }
+
+    for(auto &fn : work) {
+        try {
+            if(fn) {
+                fn();
+            }
+        } catch(const std::exception &e) {
+            PLOG_ERROR << "posted work failed: " << e.what();
+        } catch(...) {
+            PLOG_ERROR << "posted work failed (unknown exception)";
+        }
+
+        this->cancelPost();
+    }
+}
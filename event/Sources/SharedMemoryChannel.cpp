@@ -0,0 +1,71 @@
+#include <event2/event.h>
+
+#include <stdexcept>
+#include <utility>
+
+#include "TristLib/Event.h"
+
+using namespace TristLib::Event;
+
+/**
+ * @brief Create a shared memory ring event source
+ *
+ * The event source will be added to the run loop immediately, and starts reading any messages
+ * already in the ring right away.
+ *
+ * @param loop Run loop to add the event source to
+ * @param ring Ring to read messages from; the run loop becomes its only consumer
+ * @param callback Function to invoke for each received message
+ */
+SharedMemoryChannel::SharedMemoryChannel(const std::shared_ptr<RunLoop> &loop,
+        const std::shared_ptr<SharedMemoryRing> &ring, ReadCallback callback) :
+    ring(ring), callback(std::move(callback)) {
+    this->event = event_new(loop->getEvBase(), ring->getDoorbellFd(), EV_READ | EV_PERSIST,
+            [](auto, auto, auto ctx) {
+        reinterpret_cast<SharedMemoryChannel *>(ctx)->drain();
+    }, this);
+    if(!this->event) {
+        throw std::runtime_error("failed to allocate shm channel event");
+    }
+
+    if(event_add(this->event, nullptr) != 0) {
+        event_free(this->event);
+        throw std::runtime_error("failed to add shm channel to run loop");
+    }
+
+    // process any messages written before we started watching the doorbell
+    event_active(this->event, EV_READ, 0);
+}
+
+/**
+ * @brief Remove the event source from the run loop
+ */
+SharedMemoryChannel::~SharedMemoryChannel() {
+    if(this->event) {
+        event_del(this->event);
+        event_free(this->event);
+    }
+}
+
+/**
+ * @brief Read a batch of messages from the ring
+ *
+ * Invoke the callback for up to `kMaxBatchSize` messages. If the ring is then drained, the
+ * consumer is marked as idle so that producers ring the doorbell; otherwise, the event is
+ * activated again, so we continue on the next run loop iteration without starving other sources.
+ */
+void SharedMemoryChannel::drain() {
+    this->ring->wake();
+
+    size_t total{0};
+    do {
+        total += this->ring->read([this](auto message) {
+            this->callback(this, message);
+        }, kMaxBatchSize - total);
+
+        if(total >= kMaxBatchSize) {
+            event_active(this->event, EV_READ, 0);
+            return;
+        }
+    } while(!this->ring->sleep());
+}
@@ -0,0 +1,310 @@
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include "TristLib/Event.h"
+
+using namespace TristLib::Event;
+
+/**
+ * @brief Round a message size up to the ring alignment
+ */
+constexpr static inline uint64_t AlignRecord(const uint64_t size) {
+    return (size + 7) & ~uint64_t{7};
+}
+
+
+
+/**
+ * @brief Create a new shared memory ring
+ *
+ * Allocates a new (anonymous) memory region and doorbell, and initializes the ring.
+ *
+ * @param capacity Size of the ring's data area, in bytes; must be a power of two, and at least
+ *        `kMinCapacity`.
+ */
+SharedMemoryRing::SharedMemoryRing(const size_t capacity) : capacity(capacity) {
+    if(capacity < kMinCapacity || !std::has_single_bit(capacity)) {
+        throw std::invalid_argument("invalid capacity (must be power of two)");
+    }
+
+    // create the region and doorbell
+    this->memoryFd = memfd_create("tristlib-shm-ring", MFD_CLOEXEC);
+    if(this->memoryFd == -1) {
+        throw std::system_error(errno, std::generic_category(), "memfd_create");
+    }
+
+    if(ftruncate(this->memoryFd, kDataOffset + capacity) == -1) {
+        const auto errnoCopy = errno;
+        close(this->memoryFd);
+        throw std::system_error(errnoCopy, std::generic_category(), "resize shm ring");
+    }
+
+    this->doorbellFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(this->doorbellFd == -1) {
+        const auto errnoCopy = errno;
+        close(this->memoryFd);
+        throw std::system_error(errnoCopy, std::generic_category(), "eventfd");
+    }
+
+    try {
+        this->map();
+    } catch(...) {
+        close(this->memoryFd);
+        close(this->doorbellFd);
+        throw;
+    }
+
+    // initialize the header (the rest of the region is already zeroed)
+    new (this->header) Header{
+        .magic = kMagic,
+        .capacity = capacity,
+        .reserve = 0,
+        .head = 0,
+        .consumerIdle = 1,
+    };
+}
+
+/**
+ * @brief Attach to an existing shared memory ring
+ *
+ * Map a ring previously created (usually by another process) and validate it.
+ *
+ * @param memoryFd File descriptor for the ring's memory region
+ * @param doorbellFd File descriptor for the ring's doorbell eventfd
+ * @param closeFds When set, the file descriptors are closed on deallocation (or if attaching
+ *        fails)
+ */
+SharedMemoryRing::SharedMemoryRing(const int memoryFd, const int doorbellFd, const bool closeFds) :
+    memoryFd(memoryFd), doorbellFd(doorbellFd), closeFds(closeFds) {
+    try {
+        struct stat sb;
+
+        if(fstat(memoryFd, &sb) == -1) {
+            throw std::system_error(errno, std::generic_category(), "stat shm ring");
+        } else if(static_cast<size_t>(sb.st_size) < (kDataOffset + kMinCapacity)) {
+            throw std::invalid_argument("shm ring region too small");
+        }
+
+        this->capacity = sb.st_size - kDataOffset;
+        this->map();
+
+        if(this->header->magic != kMagic || this->header->capacity != this->capacity) {
+            munmap(this->region, kDataOffset + this->capacity);
+            throw std::invalid_argument("invalid shm ring header");
+        }
+    } catch(...) {
+        if(closeFds) {
+            close(memoryFd);
+            close(doorbellFd);
+        }
+        throw;
+    }
+}
+
+/**
+ * @brief Unmap the ring
+ *
+ * If requested, the underlying file descriptors are closed as well.
+ */
+SharedMemoryRing::~SharedMemoryRing() {
+    munmap(this->region, kDataOffset + this->capacity);
+
+    if(this->closeFds) {
+        close(this->memoryFd);
+        close(this->doorbellFd);
+    }
+}
+
+/**
+ * @brief Map the ring's memory region
+ */
+void SharedMemoryRing::map() {
+    auto ptr = mmap(nullptr, kDataOffset + this->capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+            this->memoryFd, 0);
+    if(ptr == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "map shm ring");
+    }
+
+    this->region = ptr;
+    this->header = reinterpret_cast<Header *>(ptr);
+    this->data = reinterpret_cast<std::byte *>(ptr) + kDataOffset;
+}
+
+
+
+/**
+ * @brief Write a message to the ring
+ *
+ * Reserve space for the message, copy it into the ring and commit it. If the consumer is idle,
+ * its doorbell is rung.
+ *
+ * This may be called concurrently from any number of threads or processes.
+ *
+ * @param message Message to write; it may not exceed `getMaxMessageSize()` bytes.
+ *
+ * @return Whether the message was written, or `false` if there's insufficient space in the ring.
+ */
+bool SharedMemoryRing::write(std::span<const std::byte> message) {
+    if(message.size() > this->getMaxMessageSize()) {
+        throw std::invalid_argument("message too large");
+    }
+
+    const uint64_t total = AlignRecord(sizeof(uint64_t) + message.size());
+    uint64_t position, padding;
+
+    // reserve space (and padding, if the message would wrap around the end of the ring)
+    position = this->header->reserve.load(std::memory_order_relaxed);
+    do {
+        const auto offset = position & (this->capacity - 1);
+        padding = (offset + total > this->capacity) ? (this->capacity - offset) : 0;
+
+        const auto head = this->header->head.load(std::memory_order_acquire);
+        if((position + padding + total - head) > this->capacity) {
+            return false;
+        }
+    } while(!this->header->reserve.compare_exchange_weak(position, position + padding + total,
+                std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    // commit the padding record, then copy and commit the message
+    if(padding) {
+        this->headerAt(position).store(kFlagCommitted | kFlagPadding | padding,
+                std::memory_order_release);
+        position += padding;
+    }
+
+    const auto offset = position & (this->capacity - 1);
+    memcpy(this->data + offset + sizeof(uint64_t), message.data(), message.size());
+    this->headerAt(position).store(kFlagCommitted | message.size(), std::memory_order_release);
+
+    // wake the consumer, if it's sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(this->header->consumerIdle.load(std::memory_order_relaxed) &&
+            this->header->consumerIdle.exchange(0, std::memory_order_acq_rel)) {
+        this->ringDoorbell();
+    }
+
+    return true;
+}
+
+/**
+ * @brief Read pending messages
+ *
+ * Invoke the callback for each committed message in the ring, in order, then release the space
+ * they occupied. Messages are passed directly out of the shared memory region, and are only valid
+ * until this method returns.
+ *
+ * @remark This must only be called by the ring's single consumer.
+ *
+ * @param callback Function to invoke for each message
+ * @param maxMessages Maximum number of messages to read
+ *
+ * @return Number of messages read
+ */
+size_t SharedMemoryRing::read(const ReadCallback &callback, const size_t maxMessages) {
+    const auto start = this->header->head.load(std::memory_order_relaxed);
+    auto position = start;
+    size_t numRead{0};
+
+    while(numRead < maxMessages) {
+        const auto word = this->headerAt(position).load(std::memory_order_acquire);
+        if(!(word & kFlagCommitted)) {
+            break;
+        }
+
+        const uint64_t length = word & 0xFFFF'FFFF;
+        if(word & kFlagPadding) {
+            position += length;
+            continue;
+        }
+
+        const auto offset = position & (this->capacity - 1);
+        callback({this->data + offset + sizeof(uint64_t), length});
+
+        position += AlignRecord(sizeof(uint64_t) + length);
+        numRead++;
+    }
+
+    if(position == start) {
+        return 0;
+    }
+
+    /*
+     * Clear the consumed region before releasing it to producers: a zero word is how we detect
+     * that a message hasn't been committed yet, and records on the next pass through the ring may
+     * begin anywhere in the space previously occupied by a message.
+     */
+    const auto startOffset = start & (this->capacity - 1);
+    const auto endOffset = position & (this->capacity - 1);
+
+    if(startOffset < endOffset) {
+        memset(this->data + startOffset, 0, endOffset - startOffset);
+    } else {
+        memset(this->data + startOffset, 0, this->capacity - startOffset);
+        memset(this->data, 0, endOffset);
+    }
+
+    this->header->head.store(position, std::memory_order_release);
+    return numRead;
+}
+
+/**
+ * @brief Check whether the ring contains any committed messages
+ */
+bool SharedMemoryRing::isEmpty() const {
+    const auto head = this->header->head.load(std::memory_order_relaxed);
+    return !(this->headerAt(head).load(std::memory_order_acquire) & kFlagCommitted);
+}
+
+/**
+ * @brief Mark the consumer as idle
+ *
+ * After this call, the next producer to commit a message will ring the doorbell. This re-checks
+ * the ring after setting the idle flag, so that messages committed concurrently aren't missed.
+ *
+ * @return Whether the consumer may sleep; if `false`, messages are pending and the consumer
+ *         should continue reading.
+ */
+bool SharedMemoryRing::sleep() {
+    this->header->consumerIdle.store(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(!this->isEmpty()) {
+        this->header->consumerIdle.store(0, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Acknowledge the doorbell
+ *
+ * Reset the doorbell's counter; the consumer should call this before reading the ring after it
+ * was woken up.
+ */
+void SharedMemoryRing::wake() {
+    uint64_t value;
+    if(::read(this->doorbellFd, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+        throw std::system_error(errno, std::generic_category(), "read shm ring doorbell");
+    }
+}
+
+/**
+ * @brief Signal the consumer that messages are available
+ */
+void SharedMemoryRing::ringDoorbell() {
+    const uint64_t value{1};
+
+    // the only possible failure is the counter overflowing, in which case it's already signalled
+    if(::write(this->doorbellFd, &value, sizeof(value)) == -1) {
+        return;
+    }
+}
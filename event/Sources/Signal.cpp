@@ -5,6 +5,7 @@
 
 #include <cerrno>
 #include <stdexcept>
+#include <utility>
 
 #include "TristLib/Event.h"
 
@@ -17,8 +18,8 @@ using namespace TristLib::Event;
  * @param signal Signal to be triggered on
  * @param callback Handler to invoke when signal is triggered
  */
-Signal::Signal(const std::shared_ptr<RunLoop> &loop, int signal,
-        const std::function<void(int)> &callback) : callback(callback) {
+Signal::Signal(const std::shared_ptr<RunLoop> &loop, int signal, Callback callback) :
+    callback(std::move(callback)) {
     this->addEvent(loop, signal);
 }
 
@@ -30,7 +31,7 @@ Signal::Signal(const std::shared_ptr<RunLoop> &loop, int signal,
  * @param callback Handler to invoke when signal is triggered
  */
 Signal::Signal(const std::shared_ptr<RunLoop> &loop, std::span<const int> signals,
-        const std::function<void(int)> &callback) : callback(callback) {
+        Callback callback) : callback(std::move(callback)) {
     if(signals.empty()) {
         throw std::invalid_argument("signals list may not be empty");
     }
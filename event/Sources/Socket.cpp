@@ -24,6 +24,9 @@ using namespace TristLib::Event;
  * @parm type Type of socket to create
  */
 Socket::Socket(const std::shared_ptr<RunLoop> &loop, const int type) {
+    // allocate libevent resources from the run loop's pool
+    LoopAllocator::Scope scope(loop->getAllocator());
+
     if(type != SOCK_STREAM) {
         // TODO: support other socket types
         throw std::invalid_argument("invalid type");
@@ -49,6 +52,8 @@ Socket::Socket(const std::shared_ptr<RunLoop> &loop, const int type) {
  * @parm type Type of socket to create
  */
 Socket::Socket(const std::shared_ptr<RunLoop> &loop, SSL *sslCtx, const int type) {
+    LoopAllocator::Scope scope(loop->getAllocator());
+
     if(type != SOCK_STREAM) {
         // TODO: support other socket types
         throw std::invalid_argument("invalid type");
@@ -74,6 +79,8 @@ Socket::Socket(const std::shared_ptr<RunLoop> &loop, SSL *sslCtx, const int type
  * @param closeFd When set, the socket is closed automatically on deallocation
  */
 Socket::Socket(const std::shared_ptr<RunLoop> &loop, const int fd, const bool closeFd) : fd(fd) {
+    LoopAllocator::Scope scope(loop->getAllocator());
+
     // make the socket non-blocking
     int err = evutil_make_socket_nonblocking(fd);
     if(err == -1) {
@@ -105,6 +112,8 @@ Socket::Socket(const std::shared_ptr<RunLoop> &loop, const int fd, const bool cl
  */
 Socket::Socket(const std::shared_ptr<RunLoop> &loop, const int fd, SSL *sslCtx,
         const bool closeFd) : fd(fd) {
+    LoopAllocator::Scope scope(loop->getAllocator());
+
     // make the socket non-blocking
     int err = evutil_make_socket_nonblocking(fd);
     if(err == -1) {
@@ -132,13 +141,13 @@ Socket::Socket(const std::shared_ptr<RunLoop> &loop, const int fd, SSL *sslCtx,
 void Socket::installCallbacks(struct bufferevent *event) {
     bufferevent_setcb(event, [](auto bev, auto ctx) {
         auto sock = reinterpret_cast<Socket *>(ctx);
-        if(sock->readCallback.has_value()) {
-            (*sock->readCallback)(sock);
+        if(sock->readCallback) {
+            sock->readCallback(sock);
         }
     }, [](auto bev, auto ctx) {
         auto sock = reinterpret_cast<Socket *>(ctx);
-        if(sock->writeCallback.has_value()) {
-            (*sock->writeCallback)(sock);
+        if(sock->writeCallback) {
+            sock->writeCallback(sock);
         }
     }, [](auto bev, auto what, auto ctx) {
         auto sock = reinterpret_cast<Socket *>(ctx);
@@ -255,7 +264,7 @@ void Socket::disableEvents(const bool read, const bool write) {
  */
 void Socket::handleEvents(const size_t flags) {
     // ensure we've a handler
-    if(!this->eventCallback.has_value()) {
+    if(!this->eventCallback) {
         return;
     }
 
@@ -281,7 +290,7 @@ void Socket::handleEvents(const size_t flags) {
         what = static_cast<Event>(what | Event::Connected);
     }
 
-    (*this->eventCallback)(this, what);
+    this->eventCallback(this, what);
 }
 
 /**
@@ -4,6 +4,7 @@
 
 #include <cerrno>
 #include <stdexcept>
+#include <utility>
 
 #include "TristLib/Event.h"
 
@@ -19,8 +20,11 @@ using namespace TristLib::Event;
  * @param start Whether the timer is started immediately
  */
 Timer::Timer(const std::shared_ptr<RunLoop> &loop, const std::chrono::microseconds interval,
-        const std::function<void(Timer *)> &callback, const bool repeating, const bool start) :
-    callback(callback), interval(interval) {
+        Callback callback, const bool repeating, const bool start) :
+    callback(std::move(callback)), interval(interval) {
+    // allocate libevent resources from the run loop's pool
+    LoopAllocator::Scope scope(loop->getAllocator());
+
     this->ev = event_new(loop->getEvBase(), -1, repeating ? EV_PERSIST : 0,
             [](auto, auto, auto ctx) {
         auto timer = reinterpret_cast<Timer *>(ctx);
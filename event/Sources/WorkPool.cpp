@@ -0,0 +1,187 @@
+#include <plog/Log.h>
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "TristLib/Event.h"
+
+using namespace TristLib::Event;
+
+thread_local WorkPool *WorkPool::gCurrentPool{nullptr};
+thread_local size_t WorkPool::gCurrentWorker{0};
+
+/**
+ * @brief Initialize the work pool
+ *
+ * Start the worker threads; they'll idle until work is submitted.
+ *
+ * @param numThreads Number of worker threads; if zero, one per hardware thread
+ * @param capacity Maximum number of jobs that may be queued at once
+ */
+WorkPool::WorkPool(const size_t numThreads, const size_t capacity) : capacity(capacity) {
+    if(!capacity) {
+        throw std::invalid_argument("invalid capacity");
+    }
+
+    const size_t count = numThreads ? numThreads : std::max(std::thread::hardware_concurrency(), 1U);
+
+    for(size_t i = 0; i < count; i++) {
+        this->workers.emplace_back(std::make_unique<Worker>());
+    }
+    for(size_t i = 0; i < count; i++) {
+        this->workers[i]->thread = std::thread(&WorkPool::workerMain, this, i);
+    }
+}
+
+/**
+ * @brief Shut down the work pool
+ *
+ * All jobs that are already queued are executed before the worker threads exit.
+ */
+WorkPool::~WorkPool() {
+    {
+        std::lock_guard lg(this->sleepLock);
+        this->shutdown = true;
+    }
+    this->sleepCond.notify_all();
+
+    for(auto &worker : this->workers) {
+        worker->thread.join();
+    }
+}
+
+/**
+ * @brief Submit a job
+ *
+ * Queue a job for execution on any of the worker threads. Jobs submitted from a worker thread of
+ * this pool are queued on that worker; others are distributed round robin.
+ *
+ * @param job Function to execute
+ *
+ * @return Whether the job was queued; `false` if the pool is at capacity.
+ */
+bool WorkPool::submit(Job &&job) {
+    // reserve space
+    auto current = this->depth.load(std::memory_order_relaxed);
+    do {
+        if(current >= this->capacity) {
+            return false;
+        }
+    } while(!this->depth.compare_exchange_weak(current, current + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed));
+
+    // pick the worker and queue the job
+    size_t index;
+    if(gCurrentPool == this) {
+        index = gCurrentWorker;
+    } else {
+        index = this->nextWorker.fetch_add(1, std::memory_order_relaxed) % this->workers.size();
+    }
+
+    auto &worker = *this->workers[index];
+    {
+        std::lock_guard lg(worker.lock);
+        worker.queue.emplace_back(std::move(job));
+    }
+
+    this->wakeWorker();
+    return true;
+}
+
+/**
+ * @brief Wake an idle worker, if there are any
+ */
+void WorkPool::wakeWorker() {
+    if(!this->numSleeping.load(std::memory_order_seq_cst)) {
+        return;
+    }
+
+    // acquire the lock, so the notification can't be lost between a worker's check and wait
+    {
+        std::lock_guard lg(this->sleepLock);
+    }
+    this->sleepCond.notify_one();
+}
+
+/**
+ * @brief Get the next job for a worker
+ *
+ * Take the most recently queued job from the worker's own queue; if it's empty, steal the oldest
+ * job from another worker's queue.
+ *
+ * @param index Index of the worker looking for work
+ * @param outJob Variable to receive the job
+ *
+ * @return Whether a job was found
+ */
+bool WorkPool::dequeue(const size_t index, Job &outJob) {
+    {
+        auto &worker = *this->workers[index];
+        std::lock_guard lg(worker.lock);
+
+        if(!worker.queue.empty()) {
+            outJob = std::move(worker.queue.back());
+            worker.queue.pop_back();
+            return true;
+        }
+    }
+
+    for(size_t i = 1; i < this->workers.size(); i++) {
+        auto &victim = *this->workers[(index + i) % this->workers.size()];
+        std::lock_guard lg(victim.lock);
+
+        if(!victim.queue.empty()) {
+            outJob = std::move(victim.queue.front());
+            victim.queue.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Worker thread entry point
+ *
+ * Executes jobs until the pool is shut down, and all queues are drained.
+ *
+ * @param index Index of this worker
+ */
+void WorkPool::workerMain(const size_t index) {
+    gCurrentPool = this;
+    gCurrentWorker = index;
+
+    Job job;
+
+    while(true) {
+        if(this->dequeue(index, job)) {
+            this->depth.fetch_sub(1, std::memory_order_relaxed);
+
+            try {
+                job();
+            } catch(const std::exception &e) {
+                PLOG_ERROR << "work pool job failed: " << e.what();
+            } catch(...) {
+                PLOG_ERROR << "work pool job failed (unknown exception)";
+            }
+
+            job = nullptr;
+            continue;
+        }
+
+        // no work available: go to sleep until some is queued
+        std::unique_lock ul(this->sleepLock);
+        this->numSleeping.fetch_add(1, std::memory_order_seq_cst);
+
+        this->sleepCond.wait(ul, [this] {
+            return this->shutdown || this->depth.load(std::memory_order_seq_cst);
+        });
+
+        this->numSleeping.fetch_sub(1, std::memory_order_relaxed);
+
+        if(this->shutdown && !this->depth.load()) {
+            break;
+        }
+    }
+}
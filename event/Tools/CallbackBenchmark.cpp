@@ -0,0 +1,140 @@
+/**
+ * @file
+ *
+ * @brief Event source callback benchmark
+ *
+ * Measures the cost of storing and invoking event source callbacks, comparing `InplaceFunction`
+ * (which event sources hold their callbacks in) against `std::function`, and the cost of
+ * dispatching a flag event through a run loop end to end. The callbacks capture 24 bytes of
+ * state, which `std::function` has to store on the heap.
+ *
+ * Usage: `tristlib-callbackbench [-n iterations]`
+ */
+#include <event2/event.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+#include "TristLib/Event/Flag.h"
+#include "TristLib/Event/InplaceFunction.h"
+#include "TristLib/Event/RunLoop.h"
+
+using namespace TristLib::Event;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+/// Number of times callbacks were invoked (so the compiler can't optimize the calls away)
+size_t gInvocations{0};
+
+/**
+ * @brief Run a benchmark, and print the average time per iteration
+ *
+ * @param name Name of the benchmark
+ * @param iterations Number of times to invoke the function
+ * @param fn Function to benchmark
+ */
+template<typename F>
+void Measure(const char *name, const size_t iterations, F &&fn) {
+    const auto start = Clock::now();
+    for(size_t i = 0; i < iterations; i++) {
+        fn();
+        asm volatile("" ::: "memory");
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+
+    printf("%-32s %8.2f ns\n", name, elapsed.count() / iterations);
+}
+
+/**
+ * @brief Create a callback with 24 bytes of captured state
+ */
+auto MakeCallback(const std::shared_ptr<size_t> &state) {
+    return [state, counter = &gInvocations](Flag *) {
+        ++*counter;
+    };
+}
+}
+
+int main(int argc, char * const *argv) {
+    size_t iterations{10'000'000};
+
+    int c;
+    while((c = getopt(argc, argv, "n:")) != -1) {
+        switch(c) {
+            case 'n': {
+                char *end;
+                errno = 0;
+                iterations = strtoull(optarg, &end, 0);
+                if(errno || end == optarg || *end || !iterations) {
+                    fprintf(stderr, "invalid iteration count: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            default:
+                fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    printf("sizeof(Flag) = %zu, sizeof(Flag::SignalCallback) = %zu, "
+            "sizeof(std::function) = %zu\n\n", sizeof(Flag), sizeof(Flag::SignalCallback),
+            sizeof(std::function<void(Flag *)>));
+
+    auto loop = std::make_shared<RunLoop>();
+    auto state = std::make_shared<size_t>(0);
+
+    // store a callback
+    {
+        std::function<void(Flag *)> callback;
+        Measure("store (std::function)", iterations, [&] {
+            callback = MakeCallback(state);
+        });
+    }
+    {
+        Flag::SignalCallback callback;
+        Measure("store (InplaceFunction)", iterations, [&] {
+            callback = MakeCallback(state);
+        });
+    }
+    {
+        auto flag = std::make_shared<Flag>(loop);
+        Measure("Flag::setCallback()", iterations, [&] {
+            flag->setCallback(MakeCallback(state));
+        });
+    }
+
+    // invoke a callback
+    {
+        std::function<void(Flag *)> callback{MakeCallback(state)};
+        Measure("invoke (std::function)", iterations, [&] {
+            callback(nullptr);
+        });
+    }
+    {
+        Flag::SignalCallback callback{MakeCallback(state)};
+        Measure("invoke (InplaceFunction)", iterations, [&] {
+            callback(nullptr);
+        });
+    }
+
+    // signal a flag, and dispatch it through the loop
+    {
+        auto flag = std::make_shared<Flag>(loop);
+        flag->setCallback(MakeCallback(state));
+
+        Measure("Flag signal and dispatch", iterations, [&] {
+            flag->signal();
+            event_base_loop(loop->getEvBase(), EVLOOP_NONBLOCK | EVLOOP_ONCE);
+        });
+    }
+
+    printf("\n%zu callbacks invoked\n", gInvocations);
+    return 0;
+}